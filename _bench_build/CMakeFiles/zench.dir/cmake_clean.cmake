@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/zench.dir/main.cpp.o"
+  "CMakeFiles/zench.dir/main.cpp.o.d"
+  "zench"
+  "zench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/zench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
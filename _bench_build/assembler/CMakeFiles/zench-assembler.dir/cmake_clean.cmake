@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/zench-assembler.dir/Assembler.cpp.o"
+  "CMakeFiles/zench-assembler.dir/Assembler.cpp.o.d"
+  "libzench-assembler.a"
+  "libzench-assembler.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/zench-assembler.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
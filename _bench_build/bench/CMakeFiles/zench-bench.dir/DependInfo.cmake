@@ -0,0 +1,28 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/bench/decode.cpp" "bench/CMakeFiles/zench-bench.dir/decode.cpp.o" "gcc" "bench/CMakeFiles/zench-bench.dir/decode.cpp.o.d"
+  "/root/repo/bench/dispatch.cpp" "bench/CMakeFiles/zench-bench.dir/dispatch.cpp.o" "gcc" "bench/CMakeFiles/zench-bench.dir/dispatch.cpp.o.d"
+  "/root/repo/bench/load.cpp" "bench/CMakeFiles/zench-bench.dir/load.cpp.o" "gcc" "bench/CMakeFiles/zench-bench.dir/load.cpp.o.d"
+  "/root/repo/bench/main.cpp" "bench/CMakeFiles/zench-bench.dir/main.cpp.o" "gcc" "bench/CMakeFiles/zench-bench.dir/main.cpp.o.d"
+  "/root/repo/bench/routines.cpp" "bench/CMakeFiles/zench-bench.dir/routines.cpp.o" "gcc" "bench/CMakeFiles/zench-bench.dir/routines.cpp.o.d"
+  "/root/repo/bench/save.cpp" "bench/CMakeFiles/zench-bench.dir/save.cpp.o" "gcc" "bench/CMakeFiles/zench-bench.dir/save.cpp.o.d"
+  "/root/repo/bench/text.cpp" "bench/CMakeFiles/zench-bench.dir/text.cpp.o" "gcc" "bench/CMakeFiles/zench-bench.dir/text.cpp.o.d"
+  "/root/repo/bench/workloads.cpp" "bench/CMakeFiles/zench-bench.dir/workloads.cpp.o" "gcc" "bench/CMakeFiles/zench-bench.dir/workloads.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_bench_build/libzench/CMakeFiles/libzench.dir/DependInfo.cmake"
+  "/root/repo/_bench_build/assembler/CMakeFiles/zench-assembler.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
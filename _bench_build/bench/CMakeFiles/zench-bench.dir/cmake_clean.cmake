@@ -0,0 +1,25 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/zench-bench.dir/decode.cpp.o"
+  "CMakeFiles/zench-bench.dir/decode.cpp.o.d"
+  "CMakeFiles/zench-bench.dir/dispatch.cpp.o"
+  "CMakeFiles/zench-bench.dir/dispatch.cpp.o.d"
+  "CMakeFiles/zench-bench.dir/load.cpp.o"
+  "CMakeFiles/zench-bench.dir/load.cpp.o.d"
+  "CMakeFiles/zench-bench.dir/main.cpp.o"
+  "CMakeFiles/zench-bench.dir/main.cpp.o.d"
+  "CMakeFiles/zench-bench.dir/routines.cpp.o"
+  "CMakeFiles/zench-bench.dir/routines.cpp.o.d"
+  "CMakeFiles/zench-bench.dir/save.cpp.o"
+  "CMakeFiles/zench-bench.dir/save.cpp.o.d"
+  "CMakeFiles/zench-bench.dir/text.cpp.o"
+  "CMakeFiles/zench-bench.dir/text.cpp.o.d"
+  "CMakeFiles/zench-bench.dir/workloads.cpp.o"
+  "CMakeFiles/zench-bench.dir/workloads.cpp.o.d"
+  "zench-bench"
+  "zench-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/zench-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,3 @@
+# CPM Package Lock
+# This file should be committed to version control
+
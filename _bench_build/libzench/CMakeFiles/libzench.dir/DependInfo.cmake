@@ -0,0 +1,35 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/libzench/src/AsyncWriter.cpp" "libzench/CMakeFiles/libzench.dir/src/AsyncWriter.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/AsyncWriter.cpp.o.d"
+  "/root/repo/libzench/src/Dictionary.cpp" "libzench/CMakeFiles/libzench.dir/src/Dictionary.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/Dictionary.cpp.o.d"
+  "/root/repo/libzench/src/Instruction.cpp" "libzench/CMakeFiles/libzench.dir/src/Instruction.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/Instruction.cpp.o.d"
+  "/root/repo/libzench/src/ObjectTable.cpp" "libzench/CMakeFiles/libzench.dir/src/ObjectTable.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/ObjectTable.cpp.o.d"
+  "/root/repo/libzench/src/Profiler.cpp" "libzench/CMakeFiles/libzench.dir/src/Profiler.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/Profiler.cpp.o.d"
+  "/root/repo/libzench/src/Quetzal.cpp" "libzench/CMakeFiles/libzench.dir/src/Quetzal.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/Quetzal.cpp.o.d"
+  "/root/repo/libzench/src/RingKeyboard.cpp" "libzench/CMakeFiles/libzench.dir/src/RingKeyboard.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/RingKeyboard.cpp.o.d"
+  "/root/repo/libzench/src/Scheduler.cpp" "libzench/CMakeFiles/libzench.dir/src/Scheduler.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/Scheduler.cpp.o.d"
+  "/root/repo/libzench/src/ScreenBuffer.cpp" "libzench/CMakeFiles/libzench.dir/src/ScreenBuffer.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/ScreenBuffer.cpp.o.d"
+  "/root/repo/libzench/src/StandardFileSystem.cpp" "libzench/CMakeFiles/libzench.dir/src/StandardFileSystem.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/StandardFileSystem.cpp.o.d"
+  "/root/repo/libzench/src/StoryImage.cpp" "libzench/CMakeFiles/libzench.dir/src/StoryImage.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/StoryImage.cpp.o.d"
+  "/root/repo/libzench/src/StringCache.cpp" "libzench/CMakeFiles/libzench.dir/src/StringCache.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/StringCache.cpp.o.d"
+  "/root/repo/libzench/src/UndoRing.cpp" "libzench/CMakeFiles/libzench.dir/src/UndoRing.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/UndoRing.cpp.o.d"
+  "/root/repo/libzench/src/ZMachine.cpp" "libzench/CMakeFiles/libzench.dir/src/ZMachine.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/ZMachine.cpp.o.d"
+  "/root/repo/libzench/src/ZMachineImpl.cpp" "libzench/CMakeFiles/libzench.dir/src/ZMachineImpl.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/ZMachineImpl.cpp.o.d"
+  "/root/repo/libzench/src/ZStringDecoder.cpp" "libzench/CMakeFiles/libzench.dir/src/ZStringDecoder.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/ZStringDecoder.cpp.o.d"
+  "/root/repo/libzench/src/zench.cpp" "libzench/CMakeFiles/libzench.dir/src/zench.cpp.o" "gcc" "libzench/CMakeFiles/libzench.dir/src/zench.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,43 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/libzench.dir/src/AsyncWriter.cpp.o"
+  "CMakeFiles/libzench.dir/src/AsyncWriter.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/Dictionary.cpp.o"
+  "CMakeFiles/libzench.dir/src/Dictionary.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/Instruction.cpp.o"
+  "CMakeFiles/libzench.dir/src/Instruction.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/ObjectTable.cpp.o"
+  "CMakeFiles/libzench.dir/src/ObjectTable.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/Profiler.cpp.o"
+  "CMakeFiles/libzench.dir/src/Profiler.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/Quetzal.cpp.o"
+  "CMakeFiles/libzench.dir/src/Quetzal.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/RingKeyboard.cpp.o"
+  "CMakeFiles/libzench.dir/src/RingKeyboard.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/Scheduler.cpp.o"
+  "CMakeFiles/libzench.dir/src/Scheduler.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/ScreenBuffer.cpp.o"
+  "CMakeFiles/libzench.dir/src/ScreenBuffer.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/StandardFileSystem.cpp.o"
+  "CMakeFiles/libzench.dir/src/StandardFileSystem.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/StoryImage.cpp.o"
+  "CMakeFiles/libzench.dir/src/StoryImage.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/StringCache.cpp.o"
+  "CMakeFiles/libzench.dir/src/StringCache.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/UndoRing.cpp.o"
+  "CMakeFiles/libzench.dir/src/UndoRing.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/ZMachine.cpp.o"
+  "CMakeFiles/libzench.dir/src/ZMachine.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/ZMachineImpl.cpp.o"
+  "CMakeFiles/libzench.dir/src/ZMachineImpl.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/ZStringDecoder.cpp.o"
+  "CMakeFiles/libzench.dir/src/ZStringDecoder.cpp.o.d"
+  "CMakeFiles/libzench.dir/src/zench.cpp.o"
+  "CMakeFiles/libzench.dir/src/zench.cpp.o.d"
+  "libzench.a"
+  "libzench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/libzench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,883 @@
+/*
+ * This file forms part of zench
+ * zench-assembler builds Z-machine story files from code, for generating the
+ * stories which the tests and benchmarks run.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>         // size_t
+
+#include <algorithm>       // find, sort
+#include <array>           // array
+#include <charconv>        // from_chars
+#include <functional>      // less
+#include <initializer_list> // initializer_list
+#include <map>             // map
+#include <optional>        // optional
+#include <string>          // string, to_string
+#include <string_view>     // string_view
+#include <system_error>    // errc
+#include <utility>         // move, pair
+#include <vector>          // vector
+
+#include <zench/zench.hpp>
+
+#include "Assembler.hpp"
+#include "ZStringDecoder.hpp"
+
+namespace com::saxbophone::zench {
+    namespace {
+        enum class Category { _0OP, _1OP, _2OP, VAR };
+
+        struct Opcode {
+            std::string_view name;
+            Category category;
+            Byte number;
+            bool store = false;
+            bool branch = false;
+        };
+
+        // every Version 3 opcode, as Instruction::to_string() names them
+        constexpr Opcode OPCODES[] = {
+            {"je", Category::_2OP, 0x01, false, true},
+            {"jl", Category::_2OP, 0x02, false, true},
+            {"jg", Category::_2OP, 0x03, false, true},
+            {"dec_chk", Category::_2OP, 0x04, false, true},
+            {"inc_chk", Category::_2OP, 0x05, false, true},
+            {"jin", Category::_2OP, 0x06, false, true},
+            {"test", Category::_2OP, 0x07, false, true},
+            {"or", Category::_2OP, 0x08, true},
+            {"and", Category::_2OP, 0x09, true},
+            {"test_attr", Category::_2OP, 0x0a, false, true},
+            {"set_attr", Category::_2OP, 0x0b},
+            {"clear_attr", Category::_2OP, 0x0c},
+            {"store", Category::_2OP, 0x0d},
+            {"insert_obj", Category::_2OP, 0x0e},
+            {"loadw", Category::_2OP, 0x0f, true},
+            {"loadb", Category::_2OP, 0x10, true},
+            {"get_prop", Category::_2OP, 0x11, true},
+            {"get_prop_addr", Category::_2OP, 0x12, true},
+            {"get_next_prop", Category::_2OP, 0x13, true},
+            {"add", Category::_2OP, 0x14, true},
+            {"sub", Category::_2OP, 0x15, true},
+            {"mul", Category::_2OP, 0x16, true},
+            {"div", Category::_2OP, 0x17, true},
+            {"mod", Category::_2OP, 0x18, true},
+            {"jz", Category::_1OP, 0x0, false, true},
+            {"get_sibling", Category::_1OP, 0x1, true, true},
+            {"get_child", Category::_1OP, 0x2, true, true},
+            {"get_parent", Category::_1OP, 0x3, true},
+            {"get_prop_len", Category::_1OP, 0x4, true},
+            {"inc", Category::_1OP, 0x5},
+            {"dec", Category::_1OP, 0x6},
+            {"print_addr", Category::_1OP, 0x7},
+            {"remove_obj", Category::_1OP, 0x9},
+            {"print_obj", Category::_1OP, 0xa},
+            {"ret", Category::_1OP, 0xb},
+            {"jump", Category::_1OP, 0xc},
+            {"print_paddr", Category::_1OP, 0xd},
+            {"load", Category::_1OP, 0xe, true},
+            {"not", Category::_1OP, 0xf, true},
+            {"rtrue", Category::_0OP, 0x0},
+            {"rfalse", Category::_0OP, 0x1},
+            {"print", Category::_0OP, 0x2},
+            {"print_ret", Category::_0OP, 0x3},
+            {"nop", Category::_0OP, 0x4},
+            {"save", Category::_0OP, 0x5, false, true},
+            {"restore", Category::_0OP, 0x6, false, true},
+            {"restart", Category::_0OP, 0x7},
+            {"ret_popped", Category::_0OP, 0x8},
+            {"pop", Category::_0OP, 0x9},
+            {"quit", Category::_0OP, 0xa},
+            {"new_line", Category::_0OP, 0xb},
+            {"show_status", Category::_0OP, 0xc},
+            {"verify", Category::_0OP, 0xd, false, true},
+            {"call", Category::VAR, 0x00, true},
+            {"storew", Category::VAR, 0x01},
+            {"storeb", Category::VAR, 0x02},
+            {"put_prop", Category::VAR, 0x03},
+            {"sread", Category::VAR, 0x04},
+            {"print_char", Category::VAR, 0x05},
+            {"print_num", Category::VAR, 0x06},
+            {"random", Category::VAR, 0x07, true},
+            {"push", Category::VAR, 0x08},
+            {"pull", Category::VAR, 0x09},
+            {"split_window", Category::VAR, 0x0a},
+            {"set_window", Category::VAR, 0x0b},
+            {"output_stream", Category::VAR, 0x13},
+            {"input_stream", Category::VAR, 0x14},
+            {"sound_effect", Category::VAR, 0x15},
+        };
+
+        const Opcode& find_opcode(std::string_view name) {
+            for (const Opcode& opcode : OPCODES) {
+                if (opcode.name == name) {
+                    return opcode;
+                }
+            }
+            throw AssemblyException("no such instruction: " + std::string(name));
+        }
+
+        constexpr Byte LARGE_CONSTANT = 0b00;
+        constexpr Byte SMALL_CONSTANT = 0b01;
+        constexpr Byte VARIABLE = 0b10;
+        constexpr Byte OMITTED = 0b11;
+
+        Byte operand_type(const Assembler::Operand& operand) {
+            switch (operand.kind) {
+            case Assembler::Operand::Kind::Constant:
+                return operand.value <= 0xff ? SMALL_CONSTANT : LARGE_CONSTANT;
+            case Assembler::Operand::Kind::Variable:
+                return VARIABLE;
+            default:
+                // filled in later, so must have room for any address
+                return LARGE_CONSTANT;
+            }
+        }
+
+        void put_word(std::vector<Byte>& bytes, Word value) {
+            bytes.push_back((Byte)(value >> 8));
+            bytes.push_back((Byte)value);
+        }
+
+        void set_word(std::vector<Byte>& bytes, std::size_t at, Word value) {
+            bytes[at] = (Byte)(value >> 8);
+            bytes[at + 1] = (Byte)value;
+        }
+
+        Word to_word(std::size_t value, const char* what) {
+            if (value > 0xffff) {
+                throw AssemblyException(std::string(what) + " doesn't fit in 16 bits");
+            }
+            return (Word)value;
+        }
+    }
+
+    Assembler::Label Assembler::new_label() {
+        this->_labels.emplace_back();
+        return this->_labels.size() - 1;
+    }
+
+    void Assembler::bind(Label label) {
+        Binding& binding = this->_labels.at(label);
+        if (binding.section != Binding::Section::None) {
+            throw AssemblyException("label " + std::to_string(label) + " is bound twice");
+        }
+        binding = {Binding::Section::High, this->_high.size()};
+    }
+
+    Assembler::Label Assembler::routine(std::initializer_list<Word> locals) {
+        return this->routine(std::vector<Word>(locals));
+    }
+
+    Assembler::Label Assembler::routine(const std::vector<Word>& locals) {
+        if (locals.size() > 15) {
+            throw AssemblyException("routines can't have more than 15 locals");
+        }
+        this->_align_high();
+        Label label = this->new_label();
+        this->bind(label);
+        this->_high.push_back((Byte)locals.size());
+        for (Word value : locals) {
+            this->_write_word(value);
+        }
+        return label;
+    }
+
+    void Assembler::start_here() {
+        this->_start = this->_high.size();
+    }
+
+    void Assembler::instruction(
+        std::string_view name,
+        std::vector<Operand> operands,
+        std::optional<Byte> store,
+        std::optional<Branch> branch
+    ) {
+        const Opcode& opcode = find_opcode(name);
+        if (opcode.category == Category::_0OP and (opcode.number == 0x2 or opcode.number == 0x3)) {
+            throw AssemblyException(std::string(name) + " is written with print() or print_ret()");
+        }
+        if (store.has_value() != opcode.store) {
+            throw AssemblyException(std::string(name) + (opcode.store ? " needs" : " doesn't take") + " a store variable");
+        }
+        if (branch.has_value() != opcode.branch) {
+            throw AssemblyException(std::string(name) + (opcode.branch ? " needs" : " doesn't take") + " a branch");
+        }
+        std::size_t fixups = this->_fixups.size();
+        auto check_count = [&](std::size_t least, std::size_t most) {
+            if (operands.size() < least or operands.size() > most) {
+                throw AssemblyException(std::string(name) + " has the wrong number of operands");
+            }
+        };
+        // the operand types, packed into a byte for the variable form
+        auto types_byte = [&] {
+            Byte types = 0;
+            for (std::size_t o = 0; o < 4; o++) {
+                types = (Byte)(types << 2 | (o < operands.size() ? operand_type(operands[o]) : OMITTED));
+            }
+            return types;
+        };
+        switch (opcode.category) {
+        case Category::_0OP:
+            check_count(0, 0);
+            this->_high.push_back((Byte)(0xb0 | opcode.number));
+            break;
+        case Category::_1OP:
+            check_count(1, 1);
+            this->_high.push_back((Byte)(0x80 | operand_type(operands[0]) << 4 | opcode.number));
+            break;
+        case Category::_2OP:
+            // only je compares against more than one value
+            check_count(2, opcode.number == 0x01 ? 4 : 2);
+            if (
+                operands.size() == 2
+                and operand_type(operands[0]) != LARGE_CONSTANT
+                and operand_type(operands[1]) != LARGE_CONSTANT
+            ) {
+                // the long form fits two small operands into the opcode byte
+                this->_high.push_back((Byte)(
+                    (operand_type(operands[0]) == VARIABLE ? 0x40 : 0x00)
+                    | (operand_type(operands[1]) == VARIABLE ? 0x20 : 0x00)
+                    | opcode.number
+                ));
+            } else {
+                this->_high.push_back((Byte)(0xc0 | opcode.number));
+                this->_high.push_back(types_byte());
+            }
+            break;
+        case Category::VAR:
+            check_count(0, 4);
+            this->_high.push_back((Byte)(0xe0 | opcode.number));
+            this->_high.push_back(types_byte());
+            break;
+        }
+        for (const Operand& operand : operands) {
+            if (operand_type(operand) != LARGE_CONSTANT) {
+                this->_high.push_back((Byte)operand.value);
+                continue;
+            }
+            if (operand.kind != Operand::Kind::Constant) {
+                this->_fixups.push_back({this->_high.size(), operand, 0});
+            }
+            this->_write_word(operand.value);
+        }
+        if (store) {
+            this->_high.push_back(*store);
+        }
+        if (branch) {
+            if (branch->label == RETURN_FALSE or branch->label == RETURN_TRUE) {
+                // the 1-byte form, whose offsets of 0 and 1 return false and true
+                this->_high.push_back((Byte)(
+                    (branch->on_true ? 0x80 : 0x00) | 0x40 | (branch->label == RETURN_TRUE ? 1 : 0)
+                ));
+            } else {
+                this->_branch_fixups.push_back({this->_high.size(), *branch});
+                this->_write_word(0);
+            }
+        }
+        // only the operand of jump is relative, to the end of the instruction
+        if (opcode.category == Category::_1OP and opcode.number == 0xc) {
+            for (std::size_t f = fixups; f < this->_fixups.size(); f++) {
+                this->_fixups[f].instruction_end = this->_high.size();
+            }
+        }
+    }
+
+    void Assembler::print(std::string_view text) {
+        this->_high.push_back(0xb2);
+        std::vector<Byte> encoded = _encode(text);
+        this->_high.insert(this->_high.end(), encoded.begin(), encoded.end());
+    }
+
+    void Assembler::print_ret(std::string_view text) {
+        this->_high.push_back(0xb3);
+        std::vector<Byte> encoded = _encode(text);
+        this->_high.insert(this->_high.end(), encoded.begin(), encoded.end());
+    }
+
+    Assembler::Label Assembler::string(std::string_view text) {
+        this->_align_high();
+        Label label = this->new_label();
+        this->bind(label);
+        std::vector<Byte> encoded = _encode(text);
+        this->_high.insert(this->_high.end(), encoded.begin(), encoded.end());
+        return label;
+    }
+
+    Assembler::Label Assembler::array(std::vector<Byte> bytes) {
+        Label label = this->new_label();
+        this->_labels[label] = {Binding::Section::Array, this->_arrays.size()};
+        this->_arrays.insert(this->_arrays.end(), bytes.begin(), bytes.end());
+        return label;
+    }
+
+    void Assembler::set_global(Byte number, Word value) {
+        if (number >= this->_globals.size()) {
+            throw AssemblyException("there are only 240 globals");
+        }
+        this->_globals[number] = value;
+    }
+
+    Word Assembler::object(std::string_view name, Word parent) {
+        if (this->_objects.size() == 255) {
+            throw AssemblyException("there can't be more than 255 objects");
+        }
+        Word number = (Word)(this->_objects.size() + 1);
+        if (parent != 0) {
+            // checked before adding the new object, so it can't be its own parent
+            Object& parent_object = this->_object(parent);
+            if (parent_object.child == 0) {
+                parent_object.child = number;
+            } else {
+                Word last = parent_object.child;
+                while (this->_object(last).sibling != 0) {
+                    last = this->_object(last).sibling;
+                }
+                this->_object(last).sibling = number;
+            }
+        }
+        this->_objects.push_back({std::string(name), {}, parent, 0, 0, {}});
+        return number;
+    }
+
+    void Assembler::set_attribute(Word object, Byte attribute) {
+        if (attribute > 31) {
+            throw AssemblyException("there are only 32 attributes");
+        }
+        this->_object(object).attributes[attribute / 8u] |= (Byte)(0x80u >> (attribute % 8u));
+    }
+
+    void Assembler::set_property(Word object, Byte property, std::vector<Byte> data) {
+        if (property < 1 or property > 31) {
+            throw AssemblyException("property numbers are 1 to 31");
+        }
+        if (data.empty() or data.size() > 8) {
+            throw AssemblyException("properties are 1 to 8 bytes long");
+        }
+        this->_object(object).properties[property] = std::move(data);
+    }
+
+    void Assembler::set_property_default(Byte property, Word value) {
+        if (property < 1 or property > 31) {
+            throw AssemblyException("property numbers are 1 to 31");
+        }
+        this->_property_defaults[property - 1u] = value;
+    }
+
+    Assembler::Label Assembler::word(std::string_view text) {
+        std::string lower(text);
+        for (char& c : lower) {
+            if ('A' <= c and c <= 'Z') {
+                c = (char)(c - 'A' + 'a');
+            }
+        }
+        for (const std::string& existing : this->_words) {
+            if (_encode_word(existing) == _encode_word(lower)) {
+                throw AssemblyException("the dictionary already has a word encoded as \"" + lower + "\"");
+            }
+        }
+        Label label = this->new_label();
+        this->_labels[label] = {Binding::Section::Word, this->_words.size()};
+        this->_words.push_back(std::move(lower));
+        return label;
+    }
+
+    void Assembler::set_separators(std::string_view separators) {
+        this->_separators = separators;
+    }
+
+    std::vector<Byte> Assembler::build() const {
+        if (not this->_start) {
+            throw AssemblyException("nothing says where to start");
+        }
+        std::vector<Byte> story(0x40);
+        // dynamic memory: globals
+        std::size_t globals = story.size();
+        for (Word value : this->_globals) {
+            put_word(story, value);
+        }
+        // the object table, with each object's property table after them all
+        std::size_t objects = story.size();
+        for (Word value : this->_property_defaults) {
+            put_word(story, value);
+        }
+        std::size_t entries = story.size();
+        story.resize(story.size() + 9 * this->_objects.size());
+        for (std::size_t o = 0; o < this->_objects.size(); o++) {
+            const Object& object = this->_objects[o];
+            std::size_t entry = entries + 9 * o;
+            std::copy(object.attributes.begin(), object.attributes.end(), story.begin() + (std::ptrdiff_t)entry);
+            story[entry + 4] = (Byte)object.parent;
+            story[entry + 5] = (Byte)object.sibling;
+            story[entry + 6] = (Byte)object.child;
+            set_word(story, entry + 7, to_word(story.size(), "a property table's address"));
+            std::vector<Byte> name = object.name.empty() ? std::vector<Byte>() : _encode(object.name);
+            story.push_back((Byte)(name.size() / 2));
+            story.insert(story.end(), name.begin(), name.end());
+            // in descending order of number
+            for (auto property = object.properties.rbegin(); property != object.properties.rend(); property++) {
+                story.push_back((Byte)(32 * (property->second.size() - 1) + property->first));
+                story.insert(story.end(), property->second.begin(), property->second.end());
+            }
+            story.push_back(0);
+        }
+        std::size_t arrays = story.size();
+        story.insert(story.end(), this->_arrays.begin(), this->_arrays.end());
+        // static memory: the dictionary, in order of encoded word
+        std::size_t static_memory = story.size();
+        std::size_t dictionary = story.size();
+        story.push_back((Byte)this->_separators.size());
+        story.insert(story.end(), this->_separators.begin(), this->_separators.end());
+        constexpr std::size_t ENTRY_LENGTH = 7; // 3 bytes of data after each word, as Infocom's stories have
+        story.push_back((Byte)ENTRY_LENGTH);
+        put_word(story, to_word(this->_words.size(), "the number of dictionary words"));
+        std::vector<std::pair<std::array<Byte, 4>, std::size_t>> sorted;
+        for (std::size_t w = 0; w < this->_words.size(); w++) {
+            sorted.emplace_back(_encode_word(this->_words[w]), w);
+        }
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<std::size_t> word_addresses(this->_words.size());
+        for (const auto& [encoded, w] : sorted) {
+            word_addresses[w] = story.size();
+            story.insert(story.end(), encoded.begin(), encoded.end());
+            story.resize(story.size() + ENTRY_LENGTH - encoded.size());
+        }
+        // high memory starts at an even address, so that it can be reached by packed addresses
+        if (story.size() % 2 != 0) {
+            story.push_back(0);
+        }
+        std::size_t high_memory = story.size();
+        story.insert(story.end(), this->_high.begin(), this->_high.end());
+        if (story.size() % 2 != 0) {
+            story.push_back(0);
+        }
+        if (story.size() > 128 * 1024) {
+            throw AssemblyException("Version 3 stories can't be longer than 128KiB");
+        }
+        // fills in everything which refers to a label
+        auto address_of = [&](Label label) -> std::size_t {
+            const Binding& binding = this->_labels.at(label);
+            switch (binding.section) {
+            case Binding::Section::High:
+                return high_memory + binding.offset;
+            case Binding::Section::Array:
+                return arrays + binding.offset;
+            case Binding::Section::Word:
+                return word_addresses[binding.offset];
+            default:
+                throw AssemblyException("label " + std::to_string(label) + " is never bound");
+            }
+        };
+        for (const Fixup& fixup : this->_fixups) {
+            std::size_t address = address_of(fixup.operand.label);
+            Word value;
+            if (fixup.operand.kind == Operand::Kind::PackedAddress) {
+                if (this->_labels[fixup.operand.label].section != Binding::Section::High) {
+                    throw AssemblyException("only routines and strings have packed addresses");
+                }
+                value = to_word(address / 2, "a packed address");
+            } else if (fixup.instruction_end != 0) {
+                // jump's operand is the offset from the end of the instruction, plus 2
+                value = (Word)(address - (high_memory + fixup.instruction_end) + 2);
+            } else {
+                value = to_word(address, "a byte address");
+            }
+            set_word(story, high_memory + fixup.at, value);
+        }
+        for (const BranchFixup& fixup : this->_branch_fixups) {
+            if (this->_labels.at(fixup.branch.label).section != Binding::Section::High) {
+                throw AssemblyException("branches can only go to code");
+            }
+            // the offset is from the end of the branch bytes, plus 2
+            std::ptrdiff_t offset = (std::ptrdiff_t)address_of(fixup.branch.label) - (std::ptrdiff_t)(high_memory + fixup.at);
+            if (offset < -0x2000 or offset >= 0x2000) {
+                throw AssemblyException("a branch is too far from its label");
+            }
+            story[high_memory + fixup.at] = (Byte)((fixup.branch.on_true ? 0x80 : 0x00) | ((offset >> 8) & 0x3f));
+            story[high_memory + fixup.at + 1] = (Byte)offset;
+        }
+        // the header
+        story[0x00] = 3;
+        set_word(story, 0x04, to_word(high_memory, "the start of high memory"));
+        set_word(story, 0x06, to_word(high_memory + *this->_start, "the first instruction's address"));
+        set_word(story, 0x08, (Word)dictionary);
+        set_word(story, 0x0a, (Word)objects);
+        set_word(story, 0x0c, (Word)globals);
+        set_word(story, 0x0e, (Word)static_memory);
+        std::string_view serial = "000000";
+        std::copy(serial.begin(), serial.end(), story.begin() + 0x12);
+        set_word(story, 0x1a, (Word)(story.size() / 2));
+        Word checksum = 0;
+        for (std::size_t b = 0x40; b < story.size(); b++) {
+            checksum = (Word)(checksum + story[b]);
+        }
+        set_word(story, 0x1c, checksum);
+        return story;
+    }
+
+    std::vector<Byte> Assembler::_encode(std::string_view text) {
+        constexpr auto& ALPHABETS = ZStringDecoder::ALPHABETS;
+        std::vector<Byte> z_chars;
+        for (char c : text) {
+            if (c == ' ') {
+                z_chars.push_back(0);
+                continue;
+            }
+            // the first character of A2 is the ZSCII escape, so is skipped
+            auto found = std::find(ALPHABETS.begin(), ALPHABETS.end(), c);
+            std::size_t index = (std::size_t)(found - ALPHABETS.begin());
+            if (found != ALPHABETS.end() and index != 52) {
+                if (index >= 26) {
+                    z_chars.push_back((Byte)(3 + index / 26)); // shift to A1 (4) or A2 (5)
+                }
+                z_chars.push_back((Byte)(6 + index % 26));
+            } else {
+                Byte zscii = c == '\n' ? 13 : (Byte)c;
+                z_chars.insert(z_chars.end(), {5, 6, (Byte)(zscii >> 5), (Byte)(zscii & 0x1f)});
+            }
+        }
+        // padded out to whole Words with shifts, which print nothing
+        while (z_chars.empty() or z_chars.size() % 3 != 0) {
+            z_chars.push_back(5);
+        }
+        std::vector<Byte> encoded;
+        for (std::size_t z = 0; z < z_chars.size(); z += 3) {
+            Word packed = (Word)(z_chars[z] << 10 | z_chars[z + 1] << 5 | z_chars[z + 2]);
+            if (z + 3 == z_chars.size()) {
+                packed |= 0x8000;
+            }
+            put_word(encoded, packed);
+        }
+        return encoded;
+    }
+
+    std::array<Byte, 4> Assembler::_encode_word(std::string_view text) {
+        std::vector<Byte> encoded = _encode(text);
+        std::array<Byte, 4> word;
+        if (encoded.size() >= 4) {
+            std::copy_n(encoded.begin(), 4, word.begin());
+        } else {
+            // a word of up to 3 Z-chars is padded out to 6
+            std::copy_n(encoded.begin(), 2, word.begin());
+            word[0] &= 0x7f;
+            word[2] = 0x94; // three shifts, ending the word
+            word[3] = 0xa5;
+        }
+        // a word of more than 6 Z-chars is cut short
+        word[2] |= 0x80;
+        return word;
+    }
+
+    void Assembler::_write_word(Word value) {
+        put_word(this->_high, value);
+    }
+
+    void Assembler::_align_high() {
+        if (this->_high.size() % 2 != 0) {
+            this->_high.push_back(0);
+        }
+    }
+
+    Assembler::Object& Assembler::_object(Word number) {
+        if (number < 1 or number > this->_objects.size()) {
+            throw AssemblyException("there's no object " + std::to_string(number));
+        }
+        return this->_objects[number - 1u];
+    }
+
+    namespace {
+        struct Token {
+            std::string text;
+            bool quoted = false;
+        };
+
+        // splits a line into tokens at spaces and commas, dropping any comment
+        std::vector<Token> tokenise(std::string_view line) {
+            std::vector<Token> tokens;
+            std::size_t i = 0;
+            auto separates = [](char c) { return c == ' ' or c == '\t' or c == '\r' or c == ','; };
+            while (i < line.size() and line[i] != ';') {
+                if (separates(line[i])) {
+                    i++;
+                    continue;
+                }
+                Token token;
+                if (line[i] != '"') {
+                    while (i < line.size() and not separates(line[i]) and line[i] != ';') {
+                        token.text += line[i++];
+                    }
+                    tokens.push_back(std::move(token));
+                    continue;
+                }
+                token.quoted = true;
+                i++;
+                while (true) {
+                    if (i == line.size()) {
+                        throw AssemblyException("a string has no closing quote");
+                    }
+                    char c = line[i++];
+                    if (c == '"') {
+                        break;
+                    }
+                    if (c == '\\' and i < line.size()) {
+                        c = line[i++];
+                        if (c == 'n') {
+                            c = '\n';
+                        } else if (c != '"' and c != '\\') {
+                            throw AssemblyException(std::string("no such escape: \\") + c);
+                        }
+                    }
+                    token.text += c;
+                }
+                tokens.push_back(std::move(token));
+            }
+            return tokens;
+        }
+
+        Word parse_hex(std::string_view text) {
+            unsigned value = 0;
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+            if (text.empty() or error != std::errc() or end != text.data() + text.size() or value > 0xffff) {
+                throw AssemblyException("not a hex number: " + std::string(text));
+            }
+            return (Word)value;
+        }
+
+        Byte parse_byte(std::string_view text) {
+            Word value = parse_hex(text);
+            if (value > 0xff) {
+                throw AssemblyException("doesn't fit in a byte: " + std::string(text));
+            }
+            return (Byte)value;
+        }
+
+        // a constant written as #hex
+        Word parse_constant(const Token& token) {
+            if (token.quoted or not token.text.starts_with('#')) {
+                throw AssemblyException("expected a #constant, not: " + token.text);
+            }
+            return parse_hex(std::string_view(token.text).substr(1));
+        }
+
+        Byte parse_variable(std::string_view text) {
+            if (text == "sp") {
+                return 0x00;
+            }
+            if (text.starts_with('l') and text.size() > 1) {
+                Byte local = parse_byte(text.substr(1));
+                if (local > 14) {
+                    throw AssemblyException("there are only 15 locals: " + std::string(text));
+                }
+                return (Byte)(local + 1);
+            }
+            if (text.starts_with('g') and text.size() > 1) {
+                Byte global = parse_byte(text.substr(1));
+                if (global > 239) {
+                    throw AssemblyException("there are only 240 globals: " + std::string(text));
+                }
+                return (Byte)(global + 0x10);
+            }
+            return parse_byte(text);
+        }
+    }
+
+    std::vector<Byte> Assembler::assemble(std::string_view source) {
+        Assembler assembler;
+        std::map<std::string, Label, std::less<>> labels;
+        std::map<std::string, Word, std::less<>> objects;
+        auto label_named = [&](std::string_view name) {
+            auto found = labels.find(name);
+            if (found == labels.end()) {
+                found = labels.emplace(name, assembler.new_label()).first;
+            }
+            return found->second;
+        };
+        auto object_named = [&](std::string_view name) {
+            auto found = objects.find(name);
+            if (found == objects.end()) {
+                throw AssemblyException("no such object: " + std::string(name));
+            }
+            return found->second;
+        };
+        std::size_t line_number = 0;
+        while (not source.empty()) {
+            line_number++;
+            std::size_t end = source.find('\n');
+            std::string_view line = source.substr(0, end);
+            source = end == source.npos ? std::string_view() : source.substr(end + 1);
+            try {
+                std::vector<Token> tokens = tokenise(line);
+                std::size_t t = 0;
+                auto next = [&](const char* what) -> const Token& {
+                    if (t == tokens.size()) {
+                        throw AssemblyException(std::string("expected ") + what);
+                    }
+                    return tokens[t++];
+                };
+                auto next_string = [&]() -> const std::string& {
+                    const Token& token = next("a quoted string");
+                    if (not token.quoted) {
+                        throw AssemblyException("expected a quoted string, not: " + token.text);
+                    }
+                    return token.text;
+                };
+                auto next_name = [&]() -> const std::string& {
+                    const Token& token = next("a name");
+                    if (token.quoted) {
+                        throw AssemblyException("expected a name, not a string");
+                    }
+                    return token.text;
+                };
+                if (not tokens.empty() and not tokens[0].quoted and tokens[0].text.ends_with(':')) {
+                    std::string_view name(tokens[0].text);
+                    assembler.bind(label_named(name.substr(0, name.size() - 1)));
+                    t++;
+                }
+                if (t == tokens.size()) {
+                    continue;
+                }
+                std::string_view keyword = next_name();
+                if (keyword == ".routine") {
+                    std::string name = next_name();
+                    std::vector<Word> locals;
+                    while (t < tokens.size()) {
+                        locals.push_back(parse_constant(tokens[t++]));
+                    }
+                    if (labels.contains(name)) {
+                        throw AssemblyException("label " + name + " is bound twice");
+                    }
+                    labels[name] = assembler.routine(locals);
+                } else if (keyword == ".start") {
+                    assembler.start_here();
+                } else if (keyword == ".string") {
+                    std::string name = next_name();
+                    if (labels.contains(name)) {
+                        throw AssemblyException("label " + name + " is bound twice");
+                    }
+                    labels[name] = assembler.string(next_string());
+                } else if (keyword == ".array") {
+                    std::string name = next_name();
+                    std::vector<Byte> bytes;
+                    while (t < tokens.size()) {
+                        Word value = parse_constant(tokens[t++]);
+                        if (value > 0xff) {
+                            throw AssemblyException("doesn't fit in a byte: " + tokens[t - 1].text);
+                        }
+                        bytes.push_back((Byte)value);
+                    }
+                    if (labels.contains(name)) {
+                        throw AssemblyException("label " + name + " is bound twice");
+                    }
+                    labels[name] = assembler.array(bytes);
+                } else if (keyword == ".global") {
+                    Byte variable = parse_variable(next_name());
+                    if (variable < 0x10) {
+                        throw AssemblyException(".global needs a global variable");
+                    }
+                    assembler.set_global((Byte)(variable - 0x10), parse_constant(next("a value")));
+                } else if (keyword == ".object") {
+                    std::string name = next_name();
+                    std::string short_name = next_string();
+                    Word parent = t < tokens.size() ? object_named(next_name()) : 0;
+                    if (objects.contains(name)) {
+                        throw AssemblyException("object " + name + " is defined twice");
+                    }
+                    objects[name] = assembler.object(short_name, parent);
+                } else if (keyword == ".attribute") {
+                    Word object = object_named(next_name());
+                    Word attribute = parse_constant(next("an attribute number"));
+                    assembler.set_attribute(object, attribute > 0xff ? 0xff : (Byte)attribute);
+                } else if (keyword == ".property") {
+                    Word object = object_named(next_name());
+                    Word property = parse_constant(next("a property number"));
+                    std::vector<Byte> data;
+                    while (t < tokens.size()) {
+                        Word value = parse_constant(tokens[t++]);
+                        if (value > 0xff) {
+                            throw AssemblyException("doesn't fit in a byte: " + tokens[t - 1].text);
+                        }
+                        data.push_back((Byte)value);
+                    }
+                    assembler.set_property(object, property > 0xff ? 0 : (Byte)property, data);
+                } else if (keyword == ".default") {
+                    Word property = parse_constant(next("a property number"));
+                    assembler.set_property_default(property > 0xff ? 0 : (Byte)property, parse_constant(next("a value")));
+                } else if (keyword == ".word") {
+                    std::string name = next_name();
+                    if (labels.contains(name)) {
+                        throw AssemblyException("label " + name + " is bound twice");
+                    }
+                    labels[name] = assembler.word(next_string());
+                } else if (keyword == ".separators") {
+                    assembler.set_separators(next_string());
+                } else if (keyword.starts_with('.')) {
+                    throw AssemblyException("no such directive: " + std::string(keyword));
+                } else {
+                    std::string_view mnemonic = keyword.starts_with('@') ? keyword.substr(1) : keyword;
+                    if (mnemonic == "print" or mnemonic == "print_ret") {
+                        const std::string& text = next_string();
+                        if (mnemonic == "print") {
+                            assembler.print(text);
+                        } else {
+                            assembler.print_ret(text);
+                        }
+                    } else {
+                        std::vector<Operand> operands;
+                        std::optional<Byte> store;
+                        std::optional<Branch> branch;
+                        while (t < tokens.size()) {
+                            const Token& token = tokens[t++];
+                            std::string_view text(token.text);
+                            if (token.quoted) {
+                                throw AssemblyException("only print and print_ret take a string");
+                            } else if (text == "->") {
+                                store = parse_variable(next_name());
+                            } else if (text.starts_with('?')) {
+                                bool on_true = not text.starts_with("?!");
+                                text.remove_prefix(on_true ? 1 : 2);
+                                // the label may be written apart from the ?, as to_string() does
+                                std::string_view target = text.empty() ? std::string_view(next_name()) : text;
+                                Label label = target == "rtrue" ? RETURN_TRUE : target == "rfalse" ? RETURN_FALSE : label_named(target);
+                                branch = Branch{label, on_true};
+                            } else if (store or branch) {
+                                throw AssemblyException("operands come before the store and branch");
+                            } else if (text.starts_with('#')) {
+                                operands.push_back(constant(parse_hex(text.substr(1))));
+                            } else if (text.starts_with('&')) {
+                                operands.push_back(packed(label_named(text.substr(1))));
+                            } else if (text.starts_with('*')) {
+                                operands.push_back(address(label_named(text.substr(1))));
+                            } else if (text.starts_with('%')) {
+                                operands.push_back(constant(object_named(text.substr(1))));
+                            } else if (mnemonic == "jump") {
+                                operands.push_back(address(label_named(text)));
+                            } else {
+                                operands.push_back(variable(parse_variable(text)));
+                            }
+                        }
+                        assembler.instruction(mnemonic, operands, store, branch);
+                    }
+                }
+                if (t != tokens.size()) {
+                    throw AssemblyException("unexpected: " + tokens[t].text);
+                }
+            } catch (const AssemblyException& e) {
+                throw AssemblyException("line " + std::to_string(line_number) + ": " + e.what());
+            }
+        }
+        for (const auto& [name, label] : labels) {
+            if (assembler._labels[label].section == Binding::Section::None) {
+                throw AssemblyException("label " + name + " is never bound");
+            }
+        }
+        return assembler.build();
+    }
+}
@@ -0,0 +1,226 @@
+/*
+ * This file forms part of zench
+ * zench-assembler builds Z-machine story files from code, for generating the
+ * stories which the tests and benchmarks run.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_ASSEMBLER_HPP
+#define COM_SAXBOPHONE_ZENCH_ASSEMBLER_HPP
+
+#include <cstddef>         // size_t
+#include <cstdint>         // SIZE_MAX
+
+#include <array>           // array
+#include <initializer_list> // initializer_list
+#include <map>             // map
+#include <optional>        // optional
+#include <string>          // string
+#include <string_view>     // string_view
+#include <utility>         // move
+#include <vector>          // vector
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+namespace com::saxbophone::zench {
+    // thrown for anything which can't be assembled, saying what and where
+    class AssemblyException : public Exception {
+    public:
+        AssemblyException(std::string message) : _message(std::move(message)) {}
+        const char* what() const noexcept override {
+            return this->_message.c_str();
+        }
+    private:
+        std::string _message;
+    };
+
+    /*
+     * Builds a Version 3 story file: the inverse of Instruction::decode() and
+     * to_string(). Code is written with builder calls, or as text in the
+     * syntax of assemble(), and addresses are filled in by build() once the
+     * whole story is laid out:
+     *
+     *     header, globals, object table, arrays  (dynamic memory)
+     *     dictionary                             (static memory)
+     *     routines and strings, in order written (high memory)
+     *
+     * Branches always use the 2-byte form, and operands referring to labels
+     * are always large constants, so the layout never depends on addresses.
+     */
+    class Assembler {
+    public:
+        // a position in the story, which may be referred to before it's bound
+        using Label = std::size_t;
+        // branch targets which return from the routine rather than jumping
+        static constexpr Label RETURN_FALSE = SIZE_MAX - 1;
+        static constexpr Label RETURN_TRUE = SIZE_MAX;
+
+        struct Operand {
+            enum class Kind {
+                Constant,
+                Variable, // 0 is the stack, 0x01..0x0f locals and 0x10..0xff globals
+                PackedAddress, // of a routine or string label
+                ByteAddress, // of a label, or for jump, the offset to it
+            };
+            Kind kind;
+            Word value = 0; // for a Constant or Variable
+            Label label = 0; // for the others
+        };
+        static Operand constant(Word value) {
+            return {Operand::Kind::Constant, value};
+        }
+        static Operand variable(Byte number) {
+            return {Operand::Kind::Variable, number};
+        }
+        static Operand sp() {
+            return variable(0x00);
+        }
+        // local number 1..15
+        static Operand local(Byte number) {
+            return variable(number);
+        }
+        // global number 0..239
+        static Operand global(Byte number) {
+            return variable((Byte)(0x10 + number));
+        }
+        static Operand packed(Label label) {
+            return {Operand::Kind::PackedAddress, 0, label};
+        }
+        static Operand address(Label label) {
+            return {Operand::Kind::ByteAddress, 0, label};
+        }
+
+        struct Branch {
+            Label label; // or RETURN_FALSE or RETURN_TRUE
+            bool on_true = true;
+        };
+
+        Label new_label();
+        // binds label to the next instruction written
+        void bind(Label label);
+        /*
+         * Starts a routine with the given locals, the number of which is
+         * that of initial values given, at the next packed address.
+         * Returns its label.
+         */
+        Label routine(std::initializer_list<Word> locals = {});
+        Label routine(const std::vector<Word>& locals);
+        // makes the next instruction written the first to be executed
+        void start_here();
+        /*
+         * Writes an instruction, given by its name as in the Z-machine
+         * standard, with a store variable and branch if it has them.
+         */
+        void instruction(
+            std::string_view name,
+            std::vector<Operand> operands = {},
+            std::optional<Byte> store = {},
+            std::optional<Branch> branch = {}
+        );
+        // writes print or print_ret, with its text
+        void print(std::string_view text);
+        void print_ret(std::string_view text);
+        // adds a string to high memory, at a packed address, returning its label
+        Label string(std::string_view text);
+        // adds bytes to dynamic memory, returning their label
+        Label array(std::vector<Byte> bytes);
+        void set_global(Byte number, Word value);
+        /*
+         * Adds an object with the given short name, as the last child of
+         * parent if it's not 0, returning its number.
+         */
+        Word object(std::string_view name, Word parent = 0);
+        void set_attribute(Word object, Byte attribute);
+        // sets property 1..31 of an object, whose data must be 1..8 bytes
+        void set_property(Word object, Byte property, std::vector<Byte> data);
+        void set_property_default(Byte property, Word value);
+        // adds a word to the dictionary, returning the label of its entry
+        Label word(std::string_view text);
+        // sets the word separators of the dictionary, which are none by default
+        void set_separators(std::string_view separators);
+        // lays out the story and returns its bytes, throwing AssemblyException if anything's missing
+        std::vector<Byte> build() const;
+
+        /*
+         * Assembles a whole story from text, one statement per line, with
+         * comments from ';' to the end of the line:
+         *
+         *     name:                          binds a label
+         *     .routine name [#value...]      starts a routine, with a local per value
+         *     .start                         the next instruction is the first executed
+         *     .string name "text"            a string in high memory
+         *     .array name #byte...           bytes in dynamic memory
+         *     .global gNN #value             an initial value for a global
+         *     .object name "short name" [parent]
+         *     .attribute object #number
+         *     .property object #number #byte...
+         *     .default #number #value        a property default
+         *     .word name "text"              a dictionary word
+         *     .separators "chars"
+         *     [@]mnemonic operands [-> variable] [?[!]label]
+         *
+         * Operands, separated by spaces or commas, are: #hex constants; sp,
+         * lNN (local NN+1) and gNN (global NN) or bare hex variable numbers,
+         * as to_string() shows them; &label for a packed address; *label for
+         * a byte address; %object for an object's number; and a bare label
+         * as the operand of jump. Branches may go to rtrue or rfalse. The
+         * text of print and print_ret follows in double quotes, in which \n,
+         * \" and \\ are escapes.
+         */
+        static std::vector<Byte> assemble(std::string_view source);
+    private:
+        // the Z-chars of text, packed into Words, the last with its top bit set
+        static std::vector<Byte> _encode(std::string_view text);
+        // the first 6 Z-chars of a dictionary word, packed into 4 bytes
+        static std::array<Byte, 4> _encode_word(std::string_view text);
+
+        // where a label refers to, once bound
+        struct Binding {
+            enum class Section { None, High, Array, Word };
+            Section section = Section::None;
+            std::size_t offset = 0; // into _high or _arrays, or index into _words
+        };
+        // a Word of high memory to fill in with the address of a label
+        struct Fixup {
+            std::size_t at; // offset into _high
+            Operand operand;
+            std::size_t instruction_end; // offset into _high of the end of the instruction for jump, otherwise 0
+        };
+        // a branch to fill in with the offset to a label
+        struct BranchFixup {
+            std::size_t at; // offset into _high of the 2 branch bytes
+            Branch branch;
+        };
+        struct Object {
+            std::string name;
+            std::array<Byte, 4> attributes = {};
+            Word parent = 0, sibling = 0, child = 0;
+            std::map<Byte, std::vector<Byte>> properties;
+        };
+
+        void _write_word(Word value);
+        void _align_high();
+        Object& _object(Word number);
+
+        std::vector<Binding> _labels;
+        std::vector<Byte> _high; // routines and strings, from the start of high memory
+        std::vector<Fixup> _fixups;
+        std::vector<BranchFixup> _branch_fixups;
+        std::optional<std::size_t> _start; // offset into _high of the first instruction
+        std::vector<Byte> _arrays;
+        std::array<Word, 240> _globals = {};
+        std::array<Word, 31> _property_defaults = {};
+        std::vector<Object> _objects;
+        std::vector<std::string> _words;
+        std::string _separators;
+    };
+}
+
+#endif // include guard
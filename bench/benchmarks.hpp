@@ -0,0 +1,51 @@
+/*
+ * Declarations shared between the benchmark harness and the benchmarks.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_BENCH_BENCHMARKS_HPP
+#define COM_SAXBOPHONE_ZENCH_BENCH_BENCHMARKS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace com::saxbophone::zench::bench {
+    struct Result {
+        std::string name;
+        double rate; // operations per second
+        std::string unit; // what an operation is
+    };
+
+    // times the fastest of several repetitions of the given function, in seconds
+    template <typename Function>
+    double fastest_of(std::size_t repetitions, Function function) {
+        double fastest = 0.0;
+        for (std::size_t i = 0; i < repetitions; i++) {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (i == 0 or elapsed.count() < fastest) {
+                fastest = elapsed.count();
+            }
+        }
+        return fastest;
+    }
+
+    // instructions/sec of decoding a mix of instructions of every form
+    std::vector<Result> benchmark_decode();
+    // instructions/sec of the Switch and Threaded dispatch engines on an arithmetic loop
+    std::vector<Result> benchmark_dispatch();
+    // instructions/sec of reading and writing variables, and calls/sec of calling and returning from a routine
+    std::vector<Result> benchmark_routines();
+    // stories/sec of loading a large story, and machines/sec of starting one from it once loaded
+    std::vector<Result> benchmark_load();
+    // saves/sec and restores/sec of a story with a large dynamic memory, to and from memory
+    std::vector<Result> benchmark_save_restore();
+    // words/sec of unpacking Z-chars, characters/sec of decoding and prints/sec of print_paddr, for a long text
+    std::vector<Result> benchmark_text();
+    // instructions/sec of assembled stories shaped like the call-, print- and object-heavy parts of real games
+    std::vector<Result> benchmark_workloads();
+}
+
+#endif // include guard
@@ -0,0 +1,54 @@
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include <zench/zench.hpp>
+
+#include "Instruction.hpp"
+#include "benchmarks.hpp"
+
+namespace com::saxbophone::zench::bench {
+    namespace {
+        // a mix of every instruction form, with and without stores, branches and string literals
+        constexpr Byte CODE[] = {
+            0x54, 0x10, 0x01, 0x11,             // add g00 #01 -> g01
+            0xC1, 0x8F, 0x00, 0x01, 0x8B, 0x43, // je sp #018b ?! +3
+            0x0F, 0x40, 0x02, 0x15,             // loadw #40 #02 -> g05
+            0xE0, 0x1F, 0x00, 0x90, 0x05, 0x10, // call 0x120 #05 -> g00
+            0xE2, 0x57, 0x80, 0x00, 0x11,       // storeb #80 #00 #11
+            0x95, 0x10,                         // inc #10
+            0xA0, 0x14, 0xC2,                   // jz g04 ?+2
+            0xB2, 0x11, 0xAA, 0xC6, 0x34,       // print "hello"
+            0xAB, 0x01,                         // ret l00
+            0x8C, 0xFF, 0xDF,                   // jump -31
+        };
+        constexpr std::size_t INSTRUCTIONS_IN_CODE = 10;
+
+        double instructions_decoded_per_second() {
+            constexpr std::size_t REPEATS = 100'000;
+            std::vector<Byte> memory(0x100);
+            std::copy(std::begin(CODE), std::end(CODE), memory.begin());
+            // kept so that the decoding isn't optimised away
+            volatile std::size_t sink = 0;
+            double seconds = fastest_of(5, [&] {
+                std::size_t checksum = 0;
+                for (std::size_t r = 0; r < REPEATS; r++) {
+                    Address pc = 0;
+                    while (pc < std::size(CODE)) {
+                        checksum += Instruction::decode(pc, memory).operand_count;
+                    }
+                }
+                sink = checksum;
+            });
+            return REPEATS * INSTRUCTIONS_IN_CODE / seconds;
+        }
+    }
+
+    std::vector<Result> benchmark_decode() {
+        return {
+            {"instruction-decode/mixed", instructions_decoded_per_second(), "instructions"},
+        };
+    }
+}
@@ -0,0 +1,60 @@
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+#include "benchmarks.hpp"
+#include "stubs.hpp"
+
+namespace com::saxbophone::zench::bench {
+    using namespace com::saxbophone::zench::tests;
+
+    namespace {
+        // a tight loop of 10 common instructions, which never ends
+        std::vector<Byte> arithmetic_loop_story() {
+            auto story = blank_story(0x200, 0x100, 0x100);
+            Byte code[] = {
+                0x54, 0x10, 0x01, 0x11, // 0x100: add g00 #01 -> g01
+                0x55, 0x11, 0x02, 0x12, // 0x104: sub g01 #02 -> g02
+                0x56, 0x12, 0x03, 0x00, // 0x108: mul g02 #03 -> sp
+                0x49, 0x00, 0xFF, 0x13, // 0x10C: and sp #ff -> g03
+                0x0D, 0x14, 0x05,       // 0x110: store #14 #05
+                0x0F, 0x40, 0x02, 0x15, // 0x113: loadw #40 #02 -> g05
+                0x41, 0x13, 0x07, 0xC2, // 0x117: je g03 #07 ?0x11b
+                0x95, 0x10,             // 0x11B: inc #10
+                0xA0, 0x14, 0xC2,       // 0x11D: jz g04 ?0x120
+                0x8C, 0xFF, 0xDF,       // 0x120: jump 0x100
+            };
+            std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+            return story;
+        }
+
+        double instructions_per_second(ZMachine::Dispatch dispatch) {
+            constexpr std::size_t INSTRUCTIONS = 10'000'000;
+            MemoryInputFile file(arithmetic_loop_story());
+            StubFileSystem fs;
+            StubScreen screen;
+            StubKeyboard keyboard;
+            ZMachine vm(file, fs, screen, keyboard, dispatch);
+            vm.run(INSTRUCTIONS / 10); // warm up the instruction cache
+            double seconds = fastest_of(5, [&] {
+                if (vm.run(INSTRUCTIONS) != ZMachine::Status::BudgetExhausted) {
+                    throw std::runtime_error("dispatch benchmark story stopped unexpectedly");
+                }
+            });
+            return INSTRUCTIONS / seconds;
+        }
+    }
+
+    std::vector<Result> benchmark_dispatch() {
+        return {
+            {"dispatch/switch", instructions_per_second(ZMachine::Dispatch::Switch), "instructions"},
+            {"dispatch/threaded", instructions_per_second(ZMachine::Dispatch::Threaded), "instructions"},
+        };
+    }
+}
@@ -0,0 +1,102 @@
+#include <cstddef>
+
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <zench/FileSystem.hpp>
+#include <zench/StoryImage.hpp>
+#include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+#include "benchmarks.hpp"
+#include "stubs.hpp"
+
+namespace com::saxbophone::zench::bench {
+    using namespace com::saxbophone::zench::tests;
+
+    namespace {
+        // reads a story held elsewhere in memory, without copying it first
+        class SpanInputFile : public FileSystem::InputFile {
+        public:
+            SpanInputFile(std::span<const Byte> data) : _data(data) {}
+            constexpr const char* name() override {
+                return "SpanInputFile";
+            }
+            bool is_open() override {
+                return true;
+            }
+            void close() override {}
+            bool open() override {
+                return true;
+            }
+            char read() override {
+                return _cursor < _data.size() ? (char)_data[_cursor++] : '\0';
+            }
+            std::size_t read_into(std::span<Byte> buffer) override {
+                std::size_t count = std::min(buffer.size(), _data.size() - _cursor);
+                std::copy_n(_data.begin() + (std::ptrdiff_t)_cursor, count, buffer.begin());
+                _cursor += count;
+                return count;
+            }
+            std::optional<std::size_t> size() override {
+                return _data.size();
+            }
+            std::span<const Byte> contents() override {
+                return _data;
+            }
+        private:
+            std::span<const Byte> _data;
+            std::size_t _cursor = 0;
+        };
+
+        // a story of nearly the largest size V3 allows, with 48KiB of non-blank dynamic memory
+        std::vector<Byte> large_story() {
+            auto story = blank_story(0x1fe00, 0xc000, 0xc000);
+            for (std::size_t address = 0x100; address < story.size(); address++) {
+                story[address] = (Byte)(address * 7);
+            }
+            story[0xc000] = 0xBA; // quit
+            return story;
+        }
+
+        double stories_loaded_per_second() {
+            constexpr std::size_t LOADS = 500;
+            auto story = large_story();
+            double seconds = fastest_of(5, [&] {
+                for (std::size_t l = 0; l < LOADS; l++) {
+                    SpanInputFile file(story);
+                    if (StoryImage::load(file) == nullptr) {
+                        throw std::runtime_error("story load benchmark failed to load");
+                    }
+                }
+            });
+            return LOADS / seconds;
+        }
+
+        // machines started from a story already loaded, as when many sessions play the same story
+        double machines_started_per_second() {
+            constexpr std::size_t STARTS = 2'000;
+            MemoryInputFile file(large_story());
+            auto image = StoryImage::load(file);
+            StubFileSystem fs;
+            StubScreen screen;
+            StubKeyboard keyboard;
+            double seconds = fastest_of(5, [&] {
+                for (std::size_t s = 0; s < STARTS; s++) {
+                    ZMachine vm(image, fs, screen, keyboard);
+                }
+            });
+            return STARTS / seconds;
+        }
+    }
+
+    std::vector<Result> benchmark_load() {
+        return {
+            {"load/127KiB", stories_loaded_per_second(), "stories"},
+            {"start/48KiB-dynamic", machines_started_per_second(), "machines"},
+        };
+    }
+}
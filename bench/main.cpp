@@ -0,0 +1,67 @@
+/*
+ * Runs all of the benchmarks and reports how fast each of them went, as a
+ * table or, given --json, as JSON for comparing against earlier runs.
+ * NOTE: build in Release mode for the results to mean anything!
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "benchmarks.hpp"
+
+using namespace com::saxbophone::zench::bench;
+
+namespace {
+    void print_table(const std::vector<Result>& results) {
+        for (const auto& result : results) {
+            std::cout << std::left << std::setw(24) << result.name << " ";
+            std::cout << std::right << std::setw(14) << std::fixed << std::setprecision(0) << result.rate;
+            std::cout << " " << result.unit << "/sec" << std::endl;
+        }
+    }
+
+    // NOTE: names and units are plain ASCII without quotes or backslashes, so need no escaping
+    void print_json(const std::vector<Result>& results) {
+        std::cout << "{\n  \"benchmarks\": [\n";
+        for (std::size_t r = 0; r < results.size(); r++) {
+            std::cout << "    {\"name\": \"" << results[r].name << "\", ";
+            std::cout << "\"unit\": \"" << results[r].unit << "\", ";
+            std::cout << "\"per_second\": " << std::fixed << std::setprecision(1) << results[r].rate << "}";
+            std::cout << (r + 1 < results.size() ? ",\n" : "\n");
+        }
+        std::cout << "  ]\n}" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    for (int a = 1; a < argc; a++) {
+        if (std::string_view(argv[a]) == "--json") {
+            json = true;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--json]" << std::endl;
+            return 2;
+        }
+    }
+    std::vector<Result> results;
+    for (auto benchmark : {
+        benchmark_decode,
+        benchmark_dispatch,
+        benchmark_routines,
+        benchmark_text,
+        benchmark_load,
+        benchmark_save_restore,
+        benchmark_workloads,
+    }) {
+        for (const auto& result : benchmark()) {
+            results.push_back(result);
+        }
+    }
+    if (json) {
+        print_json(results);
+    } else {
+        print_table(results);
+    }
+}
@@ -0,0 +1,81 @@
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+#include "benchmarks.hpp"
+#include "stubs.hpp"
+
+namespace com::saxbophone::zench::bench {
+    using namespace com::saxbophone::zench::tests;
+
+    namespace {
+        // runs the story for a number of instructions, which it mustn't stop before
+        double instructions_per_second(const std::vector<Byte>& story) {
+            constexpr std::size_t INSTRUCTIONS = 6'000'000;
+            MemoryInputFile file(story);
+            StubFileSystem fs;
+            StubScreen screen;
+            StubKeyboard keyboard;
+            ZMachine vm(file, fs, screen, keyboard);
+            vm.run(INSTRUCTIONS / 10); // warm up the instruction cache
+            double seconds = fastest_of(5, [&] {
+                if (vm.run(INSTRUCTIONS) != ZMachine::Status::BudgetExhausted) {
+                    throw std::runtime_error("routine benchmark story stopped unexpectedly");
+                }
+            });
+            return INSTRUCTIONS / seconds;
+        }
+
+        // a routine looping forever over loads and stores of locals, globals and the stack
+        std::vector<Byte> variables_story() {
+            auto story = blank_story(0x200, 0x100, 0x100);
+            Byte code[] = {
+                0xE0, 0x3F, 0x00, 0x88, 0x00,   // 0x100: call 0x110 -> sp
+            };
+            Byte routine[] = {
+                0x02, 0x00, 0x00, 0x00, 0x00,   // 0x110: 2 locals
+                0x54, 0x01, 0x01, 0x02,         // 0x115: add l00 #01 -> l01
+                0x75, 0x02, 0x10, 0x01,         // 0x119: sub l01 g00 -> l00
+                0xE8, 0xBF, 0x01,               // 0x11D: push l00
+                0xE9, 0x7F, 0x11,               // 0x120: pull g01
+                0x95, 0x01,                     // 0x123: inc #01
+                0x9E, 0x11, 0x02,               // 0x125: load #11 -> l01
+                0x0D, 0x10, 0x05,               // 0x128: store #10 #05
+                0x8C, 0xFF, 0xE9,               // 0x12B: jump 0x115
+            };
+            std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+            std::copy(std::begin(routine), std::end(routine), story.begin() + 0x110);
+            return story;
+        }
+
+        // calls a routine which returns its argument, forever
+        std::vector<Byte> calls_story() {
+            auto story = blank_story(0x200, 0x100, 0x100);
+            Byte code[] = {
+                0xE0, 0x1F, 0x00, 0x90, 0x05, 0x10, // 0x100: call 0x120 #05 -> g00
+                0x8C, 0xFF, 0xF9,                   // 0x106: jump 0x100
+            };
+            Byte routine[] = {
+                0x01, 0x00, 0x00,                   // 0x120: 1 local
+                0xAB, 0x01,                         // 0x123: ret l00
+            };
+            std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+            std::copy(std::begin(routine), std::end(routine), story.begin() + 0x120);
+            return story;
+        }
+    }
+
+    std::vector<Result> benchmark_routines() {
+        return {
+            {"variables/mixed", instructions_per_second(variables_story()), "instructions"},
+            // each call is three instructions: call, ret and the jump back
+            {"call-return/1-arg", instructions_per_second(calls_story()) / 3, "calls"},
+        };
+    }
+}
@@ -0,0 +1,81 @@
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+#include "benchmarks.hpp"
+#include "stubs.hpp"
+
+namespace com::saxbophone::zench::bench {
+    using namespace com::saxbophone::zench::tests;
+
+    namespace {
+        constexpr Word CODE = 0xf000; // leaves the largest practical dynamic memory
+
+        // a story with nearly 60KiB of non-blank dynamic memory, running the given code
+        template <std::size_t N>
+        std::vector<Byte> large_story(const Byte (&code)[N]) {
+            auto story = blank_story(0x10000, CODE, CODE);
+            for (std::size_t address = 0x100; address < CODE; address++) {
+                story[address] = (Byte)(address * 7);
+            }
+            std::copy(std::begin(code), std::end(code), story.begin() + CODE);
+            return story;
+        }
+
+        double saves_per_second() {
+            constexpr std::size_t SAVES = 2'000;
+            Byte code[] = {
+                0xE2, 0x57, 0x80, 0x00, 0x11, // 0xF000: storeb #80 #00 #11
+                0xB5, 0xC2,                   // 0xF005: save ?0xf007
+                0x8C, 0xFF, 0xFD,             // 0xF007: jump 0xf005
+            };
+            MemoryInputFile file(large_story(code));
+            MemoryFileSystem fs;
+            StubScreen screen;
+            StubKeyboard keyboard;
+            ZMachine vm(file, fs, screen, keyboard);
+            vm.run(1);
+            double seconds = fastest_of(5, [&] {
+                if (vm.run(SAVES * 2) != ZMachine::Status::BudgetExhausted) {
+                    throw std::runtime_error("save benchmark story stopped unexpectedly");
+                }
+            });
+            return SAVES / seconds;
+        }
+
+        double restores_per_second() {
+            constexpr std::size_t RESTORES = 2'000;
+            Byte code[] = {
+                0xE2, 0x57, 0x80, 0x00, 0x11, // 0xF000: storeb #80 #00 #11
+                0xB5, 0xC2,                   // 0xF005: save ?0xf007
+                0xB6, 0xC2,                   // 0xF007: restore ?0xf009 --resumes at 0xf007
+                0xBA,                         // 0xF009: quit
+            };
+            MemoryInputFile file(large_story(code));
+            MemoryFileSystem fs;
+            StubScreen screen;
+            StubKeyboard keyboard;
+            ZMachine vm(file, fs, screen, keyboard);
+            vm.run(2);
+            double seconds = fastest_of(5, [&] {
+                if (vm.run(RESTORES) != ZMachine::Status::BudgetExhausted) {
+                    throw std::runtime_error("restore benchmark story stopped unexpectedly");
+                }
+            });
+            return RESTORES / seconds;
+        }
+    }
+
+    std::vector<Result> benchmark_save_restore() {
+        return {
+            {"save/60KiB", saves_per_second(), "saves"},
+            {"restore/60KiB", restores_per_second(), "restores"},
+        };
+    }
+}
@@ -0,0 +1,110 @@
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <zench/Screen.hpp>
+#include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+#include "ZStringDecoder.hpp"
+#include "benchmarks.hpp"
+#include "stubs.hpp"
+
+namespace com::saxbophone::zench::bench {
+    using namespace com::saxbophone::zench::tests;
+
+    namespace {
+        constexpr std::size_t TEXT_WORDS = 1024; // 2KiB, as long as the longest room descriptions
+        constexpr Word TEXT = 0x1000;
+
+        // a long Z-string of lower-case words, ending at its last Word
+        std::vector<Byte> long_text() {
+            std::vector<Byte> z_string;
+            for (std::size_t w = 0; w < TEXT_WORDS; w++) {
+                Word word = (Word)((6 + w % 26) << 10 | (6 + w * 7 % 26) << 5 | (w % 5 == 4 ? 0 : 6 + w * 3 % 26));
+                if (w == TEXT_WORDS - 1) {
+                    word |= 0x8000;
+                }
+                z_string.push_back((Byte)(word >> 8));
+                z_string.push_back((Byte)word);
+            }
+            return z_string;
+        }
+
+        // discards everything printed, so that only the interpreter is timed
+        class NullScreen : public StubScreen {
+        public:
+            void render(std::span<const Command>, std::string_view) override {}
+        };
+
+        double words_unpacked_per_second(bool vectorised) {
+            constexpr std::size_t REPEATS = 20'000;
+            auto z_string = long_text();
+            std::vector<Byte> z_chars(TEXT_WORDS * ZStringDecoder::UNPACKED_WORD_SIZE);
+            std::size_t unpacked = 0;
+            double seconds = fastest_of(5, [&] {
+                for (std::size_t r = 0; r < REPEATS; r++) {
+                    unpacked += vectorised ?
+                        ZStringDecoder::unpack(z_string, z_chars) :
+                        ZStringDecoder::unpack_word_by_word(z_string, z_chars);
+                }
+            });
+            if (unpacked != 5 * REPEATS * TEXT_WORDS) {
+                throw std::runtime_error("unpack benchmark stopped short of the end of the text");
+            }
+            return REPEATS * TEXT_WORDS / seconds;
+        }
+
+        double characters_decoded_per_second() {
+            constexpr std::size_t REPEATS = 2'000;
+            auto z_string = long_text();
+            ZStringDecoder decoder(ZVersion::V3);
+            std::vector<char> text(3 * TEXT_WORDS);
+            std::size_t length = 0;
+            double seconds = fastest_of(5, [&] {
+                for (std::size_t r = 0; r < REPEATS; r++) {
+                    length = decoder.decode(z_string, text);
+                }
+            });
+            return REPEATS * length / seconds;
+        }
+
+        double prints_per_second() {
+            constexpr std::size_t PRINTS = 2'000;
+            auto story = blank_story(0x2000, 0x100, 0x100);
+            Byte code[] = {
+                0x8D, 0x08, 0x00, // 0x100: print_paddr #0800
+                0x8C, 0xFF, 0xFC, // 0x103: jump 0x100
+            };
+            std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+            auto text = long_text();
+            std::copy(text.begin(), text.end(), story.begin() + TEXT);
+            MemoryInputFile file(story);
+            StubFileSystem fs;
+            NullScreen screen;
+            StubKeyboard keyboard;
+            ZMachine vm(file, fs, screen, keyboard);
+            vm.run(2);
+            double seconds = fastest_of(5, [&] {
+                if (vm.run(PRINTS * 2) != ZMachine::Status::BudgetExhausted) {
+                    throw std::runtime_error("print benchmark story stopped unexpectedly");
+                }
+            });
+            return PRINTS / seconds;
+        }
+    }
+
+    std::vector<Result> benchmark_text() {
+        return {
+            {"unpack/word-by-word", words_unpacked_per_second(false), "words"},
+            {"unpack/vectorised", words_unpacked_per_second(true), "words"},
+            {"decode/2KiB", characters_decoded_per_second(), "characters"},
+            {"print_paddr/2KiB", prints_per_second(), "prints"},
+        };
+    }
+}
@@ -0,0 +1,128 @@
+#include <cstddef>
+
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <zench/Screen.hpp>
+#include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+#include <Assembler.hpp>
+
+#include "benchmarks.hpp"
+#include "stubs.hpp"
+
+namespace com::saxbophone::zench::bench {
+    using namespace com::saxbophone::zench::tests;
+
+    namespace {
+        // discards everything printed, so that only the interpreter is timed
+        class NullScreen : public StubScreen {
+        public:
+            void render(std::span<const Command>, std::string_view) override {}
+        };
+
+        // runs the story for a number of instructions, which it mustn't stop before
+        double instructions_per_second(const std::vector<Byte>& story) {
+            constexpr std::size_t INSTRUCTIONS = 6'000'000;
+            MemoryInputFile file(story);
+            StubFileSystem fs;
+            NullScreen screen;
+            StubKeyboard keyboard;
+            ZMachine vm(file, fs, screen, keyboard);
+            vm.run(INSTRUCTIONS / 10); // warm up the instruction cache
+            double seconds = fastest_of(5, [&] {
+                if (vm.run(INSTRUCTIONS) != ZMachine::Status::BudgetExhausted) {
+                    throw std::runtime_error("workload benchmark story stopped unexpectedly");
+                }
+            });
+            return INSTRUCTIONS / seconds;
+        }
+
+        // recursive Fibonacci, forever: mostly calls and returns, with a few locals each
+        std::vector<Byte> call_heavy_story() {
+            return Assembler::assemble(R"(
+                .routine fib #0000 #0000
+                    jl l00 #02 ?small
+                    sub l00 #01 -> sp
+                    call &fib sp -> l01
+                    sub l00 #02 -> sp
+                    call &fib sp -> sp
+                    add sp l01 -> sp
+                    ret_popped
+                small:
+                    ret l00
+
+                .start
+                again:
+                    call &fib #0c -> g00
+                    jump again
+            )");
+        }
+
+        // a room description and a status line, forever
+        std::vector<Byte> print_heavy_story() {
+            return Assembler::assemble(R"(
+                .string description "You are standing in an open field west of a white house, with a boarded front door."
+
+                .start
+                again:
+                    print "West of House"
+                    new_line
+                    print_paddr &description
+                    new_line
+                    print "Score: "
+                    print_num g00
+                    print_char #2f
+                    inc #10
+                    new_line
+                    jump again
+            )");
+        }
+
+        // walks the contents of a room, reading the properties and attributes of each object, forever
+        std::vector<Byte> object_heavy_story() {
+            constexpr Byte OBJECTS = 24;
+            Assembler assembler;
+            Word room = assembler.object("Large Room");
+            for (Byte o = 0; o < OBJECTS; o++) {
+                Word object = assembler.object("small brass object " + std::to_string(o), room);
+                assembler.set_property(object, 5, {0x00, o});
+                assembler.set_property(object, 6, std::vector<Byte>(o % 8u + 1u, o));
+                if (o % 3 == 0) {
+                    assembler.set_attribute(object, 2);
+                }
+            }
+            Assembler::Label again = assembler.new_label();
+            Assembler::Label next = assembler.new_label();
+            Assembler::Label each = assembler.new_label();
+            assembler.start_here();
+            assembler.bind(again);
+            assembler.instruction("get_child", {Assembler::constant(room)}, 0x10, Assembler::Branch{each});
+            assembler.bind(each);
+            assembler.instruction("get_prop", {Assembler::global(0), Assembler::constant(5)}, 0x00);
+            assembler.instruction("add", {Assembler::sp(), Assembler::global(1)}, 0x11);
+            assembler.instruction("get_prop_addr", {Assembler::global(0), Assembler::constant(6)}, 0x00);
+            assembler.instruction("get_prop_len", {Assembler::sp()}, 0x00);
+            assembler.instruction("add", {Assembler::sp(), Assembler::global(1)}, 0x11);
+            assembler.instruction("test_attr", {Assembler::global(0), Assembler::constant(2)}, {}, Assembler::Branch{next, false});
+            assembler.instruction("get_parent", {Assembler::global(0)}, 0x00);
+            assembler.instruction("pop");
+            assembler.bind(next);
+            assembler.instruction("get_sibling", {Assembler::global(0)}, 0x10, Assembler::Branch{each});
+            assembler.instruction("jump", {Assembler::address(again)});
+            return assembler.build();
+        }
+    }
+
+    std::vector<Result> benchmark_workloads() {
+        return {
+            {"workload/call-heavy", instructions_per_second(call_heavy_story()), "instructions"},
+            {"workload/print-heavy", instructions_per_second(print_heavy_story()), "instructions"},
+            {"workload/object-heavy", instructions_per_second(object_heavy_story()), "instructions"},
+        };
+    }
+}
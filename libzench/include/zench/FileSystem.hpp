@@ -19,10 +19,15 @@
 #ifndef COM_SAXBOPHONE_ZENCH_FILESYSTEM_HPP
 #define COM_SAXBOPHONE_ZENCH_FILESYSTEM_HPP
 
-#include <memory> // unique_ptr
-#include <string> // string
+#include <cstddef>  // size_t
+
+#include <memory>   // unique_ptr
+#include <optional> // optional
+#include <span>     // span
+#include <string>   // string
 
 #include <zench/Component.hpp>
+#include <zench/zench.hpp>
 
 namespace com::saxbophone::zench {
     /**
@@ -86,6 +91,40 @@ namespace com::saxbophone::zench {
         class InputFile : public File {
         public:
             virtual char read() = 0; // EOF?
+            /**
+             * @brief Reads bytes into the given buffer, up to its size
+             * @returns the number of bytes read, which is less than the size
+             * of the buffer only when the end of the file has been reached
+             * @pre `File.is_open() == true`
+             * @note The default implementation calls read() once per byte,
+             * which can't detect the end of the file. Implementors should
+             * override this if they can do better.
+             */
+            virtual std::size_t read_into(std::span<Byte> buffer) {
+                for (Byte& byte : buffer) {
+                    byte = (Byte)this->read();
+                }
+                return buffer.size();
+            }
+            /**
+             * @returns the total size of the file in bytes, or nothing if
+             * this is not known
+             * @pre `File.is_open() == true`
+             */
+            virtual std::optional<std::size_t> size() {
+                return std::nullopt;
+            }
+            /**
+             * @returns a view of the entire contents of the file, if they are
+             * already held in memory (such as when memory-mapped), otherwise
+             * an empty span
+             * @pre `File.is_open() == true`
+             * @note The view is only valid until the file is closed or
+             * destroyed, and is not affected by read() or read_into().
+             */
+            virtual std::span<const Byte> contents() {
+                return {};
+            }
         };
         /**
          * @brief An abstract file to which bytes can be written
@@ -93,7 +132,15 @@ namespace com::saxbophone::zench {
          * of classes implementing this one ensuring that the file is closed
          * before it is destroyed.
          */
-        class OutputFile : public File {};
+        class OutputFile : public File {
+        public:
+            /**
+             * @brief Writes the given bytes to the end of the file
+             * @returns whether all of the bytes were written successfully
+             * @pre `File.is_open() == true`
+             */
+            virtual bool write(std::span<const Byte> bytes) = 0;
+        };
         // all the following methods return nullptr when a file could not be retrieved.
         // tries to open a file for reading from. Where the file comes from, is the responsibility of the FileSystem
         // object to determine (such as prompting the user, or opening up a file-picker).
@@ -0,0 +1,104 @@
+/**
+ * @file
+ * @brief This file forms part of libzench
+ * @details libzench is a software library that implements a portable and
+ * extensible Z-machine interpreter, designed to be embedded within other
+ * programs.
+ *
+ * @author the zench contributors
+ * @date October 2026
+ *
+ * @copyright Copyright the zench contributors 2026
+ *
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_RING_KEYBOARD_HPP
+#define COM_SAXBOPHONE_ZENCH_RING_KEYBOARD_HPP
+
+#include <cstddef>              // size_t
+#include <cstdint>              // uint16_t, uint32_t
+
+#include <atomic>               // atomic
+#include <memory>               // unique_ptr
+#include <optional>             // optional
+#include <variant>              // get, get_if
+#include <vector>               // vector
+
+#include <zench/Keyboard.hpp>
+
+namespace com::saxbophone::zench {
+    /**
+     * @brief A Keyboard which buffers events in a fixed-size, lock-free ring
+     * @details One thread (such as a network thread) may push() events whilst
+     * another (the one running the ZMachine) takes them, without either
+     * locking or allocating. A ZMachine reads a RingKeyboard directly, one
+     * event at a time, rather than through get_input().
+     * @warning Only one thread may push() and only one may take events.
+     */
+    class RingKeyboard : public Keyboard {
+    public:
+        /**
+         * @brief An Event packed into 32 bits
+         * @details Unicode codepoints are stored as they are, and SpecialKeys
+         * as their value with bit 16 set.
+         */
+        using EncodedEvent = std::uint32_t;
+        static constexpr EncodedEvent SPECIAL_KEY_TAG = 0x10000;
+
+        static constexpr EncodedEvent encode(Event event) {
+            if (const std::uint16_t* codepoint = std::get_if<std::uint16_t>(&event)) {
+                return *codepoint;
+            }
+            return SPECIAL_KEY_TAG | (EncodedEvent)std::get<SpecialKey>(event);
+        }
+
+        static constexpr Event decode(EncodedEvent encoded) {
+            if (encoded & SPECIAL_KEY_TAG) {
+                return (SpecialKey)(encoded & ~SPECIAL_KEY_TAG);
+            }
+            return (std::uint16_t)encoded;
+        }
+
+        /**
+         * @param capacity the most events which can be waiting at once,
+         * rounded up to a power of two
+         */
+        RingKeyboard(std::size_t capacity = 1024);
+        constexpr const char* name() override {
+            return "RingKeyboard";
+        }
+        constexpr bool supports_mouse() override {
+            return false;
+        }
+        constexpr bool supports_menus() override {
+            return false;
+        }
+        std::size_t capacity() const;
+        /**
+         * @brief Adds an event, from the producing thread
+         * @returns false, dropping the event, if the ring is full
+         */
+        bool push(Event event);
+        /**
+         * @brief Takes the oldest event, from the consuming thread
+         * @returns nothing if there are no events waiting
+         */
+        std::optional<Event> pop();
+        // takes all waiting events, from the consuming thread
+        std::vector<Event> get_input() override;
+    private:
+        std::size_t _mask;
+        std::unique_ptr<EncodedEvent[]> _slots;
+        // each index is written by one side only, and kept on its own cache line to avoid false sharing
+        alignas(64) std::atomic<std::size_t> _head = 0; // next slot to take, written by the consumer
+        std::size_t _cached_tail = 0; // the consumer's last sight of _tail
+        alignas(64) std::atomic<std::size_t> _tail = 0; // next slot to fill, written by the producer
+        std::size_t _cached_head = 0; // the producer's last sight of _head
+    };
+}
+
+#endif // include guard
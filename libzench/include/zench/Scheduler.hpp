@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief This file forms part of libzench
+ * @details libzench is a software library that implements a portable and
+ * extensible Z-machine interpreter, designed to be embedded within other
+ * programs.
+ *
+ * @author the zench contributors
+ * @date October 2026
+ *
+ * @copyright Copyright the zench contributors 2026
+ *
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_SCHEDULER_HPP
+#define COM_SAXBOPHONE_ZENCH_SCHEDULER_HPP
+
+#include <cstddef>               // size_t
+#include <cstdint>               // uint64_t
+
+#include <functional>            // function
+#include <memory>                // unique_ptr
+
+#include <zench/ZMachine.hpp>
+
+namespace com::saxbophone::zench {
+    /**
+     * @brief Runs many ZMachine sessions on a fixed number of threads
+     * @details Sessions which can run are time-sliced across a pool of worker
+     * threads, each with its own queue, which steal from one another when
+     * idle. A session which is waiting for Keyboard input is parked without
+     * holding a thread until notify() is called for it, so a few threads can
+     * serve a great many mostly idle sessions.
+     * @note The components of each ZMachine are only ever used by one thread
+     * at a time, but not always the same one, and Keyboard input for a
+     * session is typically provided from a thread outside the pool.
+     */
+    class Scheduler {
+    public:
+        using SessionId = std::uint64_t;
+        /**
+         * @brief Called from a worker thread whenever a session stops running
+         * for a reason other than using up its time slice
+         * @details The session is parked when status is WaitingForInput. Once
+         * it is Quit or Error, the session's ZMachine is destroyed after this
+         * returns.
+         */
+        using Callback = std::function<void(SessionId session, ZMachine& machine, ZMachine::Status status)>;
+        // the number of instructions a session runs before giving way to the next
+        static constexpr std::size_t DEFAULT_TIME_SLICE = 10'000;
+        /**
+         * @param threads number of worker threads, at least one
+         * @param on_stop called as described by Callback, may be empty
+         * @param time_slice number of instructions a session runs before giving way
+         */
+        Scheduler(std::size_t threads, Callback on_stop = {}, std::size_t time_slice = DEFAULT_TIME_SLICE);
+        /**
+         * @brief Stops the worker threads, once they finish their current time
+         * slices, and destroys all remaining sessions
+         */
+        ~Scheduler();
+        Scheduler(const Scheduler&) = delete;
+        Scheduler& operator=(const Scheduler&) = delete;
+        /**
+         * @brief Takes ownership of a ZMachine and schedules it to run
+         * @returns the id by which the new session is known
+         */
+        SessionId add(std::unique_ptr<ZMachine> machine);
+        /**
+         * @brief Tells the scheduler that input is available for a session
+         * @details A parked session is scheduled to run again. If the session
+         * is already running, it gets another go once it next stops for input.
+         * @returns false if there's no such session (it may have finished)
+         */
+        bool notify(SessionId session);
+        /**
+         * @returns the number of sessions which haven't yet finished
+         */
+        std::size_t session_count() const;
+        /**
+         * @brief Blocks until every session is either parked or finished
+         */
+        void wait_until_idle();
+    private:
+        class SchedulerImpl;
+        // pimpl pointer
+        std::unique_ptr<SchedulerImpl> _impl;
+    };
+}
+
+#endif // include guard
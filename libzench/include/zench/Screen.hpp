@@ -19,14 +19,17 @@
 #ifndef COM_SAXBOPHONE_ZENCH_SCREEN_HPP
 #define COM_SAXBOPHONE_ZENCH_SCREEN_HPP
 
-#include <cstdint> // uint8_t
+#include <cstdint>     // uint8_t, uint32_t
 
-#include <utility> // pair
+#include <span>        // span
+#include <string_view> // string_view
+#include <utility>     // pair
 
 #include <zench/Component.hpp>
 
 namespace com::saxbophone::zench {
     class Screen : public Component {
+    public:
         // This is meant to be abstract
         /*
          * This is meant to be like a low-level device driver, so we
@@ -51,9 +54,55 @@ namespace com::saxbophone::zench {
          * - change visible cursor style/blink settings/visibility
          * - get resize events?
          */
+        // text styles, which may be combined with bitwise OR
+        enum Style : std::uint8_t {
+            Roman = 0,
+            Reverse = 1,
+            Bold = 2,
+            Italic = 4,
+            FixedPitch = 8,
+        };
+        /*
+         * One operation for the driver to carry out. Rather than being called
+         * for every operation, the driver is given them in batches to render().
+         */
+        struct Command {
+            enum class Type : std::uint8_t {
+                Print, // writes text at the cursor, in style
+                NewLine, // moves the cursor to the start of the next line, scrolling if need be
+            };
+            Type type;
+            std::uint8_t style; // for Print
+            // for Print, where the text is in the batch's text
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+
         virtual std::pair<std::uint8_t, std::uint8_t> get_dimensions() = 0;
         virtual bool supports_colour() = 0;
         virtual bool supports_truecolour() = 0;
+        // writes text (UTF-8 encoded) at the cursor, in style --by default, it's discarded
+        virtual void print(std::string_view, std::uint8_t) {}
+        // moves the cursor to the start of the next line, scrolling if need be --by default, does nothing
+        virtual void new_line() {}
+        /*
+         * Carries out a batch of commands, in order. The text written by all
+         * of the batch's Print commands is in text (UTF-8 encoded), which
+         * remains valid only until this returns. Consecutive Print commands
+         * are always in different styles, as runs of text in the same style
+         * are merged into one.
+         * By default, each command is passed on to print() or new_line() in
+         * turn, so a driver may override those instead of this.
+         */
+        virtual void render(std::span<const Command> commands, std::string_view text) {
+            for (const Command& command : commands) {
+                if (command.type == Command::Type::Print) {
+                    this->print(text.substr(command.offset, command.length), command.style);
+                } else {
+                    this->new_line();
+                }
+            }
+        }
     };
 }
 
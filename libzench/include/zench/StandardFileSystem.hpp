@@ -19,10 +19,18 @@
 #ifndef COM_SAXBOPHONE_ZENCH_STANDARD_FILESYSTEM_HPP
 #define COM_SAXBOPHONE_ZENCH_STANDARD_FILESYSTEM_HPP
 
-#include <string>
+#include <cstddef>  // size_t
+
+#include <fstream>  // ofstream
+#include <memory>   // unique_ptr
+#include <optional> // optional
+#include <span>     // span
+#include <string>   // string
+#include <vector>   // vector
 
 #include <zench/Component.hpp>
 #include <zench/FileSystem.hpp>
+#include <zench/zench.hpp>
 
 namespace com::saxbophone::zench {
     // abstracts out the method of prompting for filenames
@@ -35,29 +43,59 @@ namespace com::saxbophone::zench {
     // an implementation of FileSystem that just passes through to the stdlib
     class StandardFileSystem : public FileSystem {
     public:
+        /**
+         * @brief A file on disk, read in its entirety when opened
+         * @details Where the platform supports it, the file is memory-mapped
+         * so that contents() is available without copying it, otherwise it is
+         * read into a buffer in one go.
+         */
         class InputFile : public FileSystem::InputFile {
         public:
+            // a closed file which refers to nothing and can't be opened
+            InputFile() = default;
+            // opens the file at the given path, check is_open() for success
+            InputFile(std::string path);
+            InputFile(const InputFile&) = delete;
+            InputFile& operator=(const InputFile&) = delete;
+            ~InputFile();
             constexpr const char* name() override {
                 return "StandardFileSystem::InputFile";
             }
-            bool is_open() override {
-                return false;
-            }
-            void close() override {
-                return;
-            }
-            bool open() override {
-                return false;
-            }
-            char read() override {
-                return {};
-            }
+            bool is_open() override;
+            void close() override;
+            bool open() override;
+            char read() override;
+            std::size_t read_into(std::span<Byte> buffer) override;
+            std::optional<std::size_t> size() override;
+            std::span<const Byte> contents() override;
+        private:
+            std::string _path;
+            bool _is_open = false;
+            const Byte* _data = nullptr; // the file's contents, either mapped or pointing into _buffer
+            std::size_t _size = 0;
+            std::size_t _cursor = 0; // position of the next byte to read
+            bool _is_mapped = false;
+            std::vector<Byte> _buffer; // only used when the file can't be memory-mapped
         };
+        /**
+         * @brief A file on disk, which is created (or truncated) when opened
+         * and appended to if it is re-opened after being closed
+         */
         class OutputFile : public FileSystem::OutputFile {
         public:
+            // creates or truncates the file at the given path, check is_open() for success
+            OutputFile(std::string path);
+            ~OutputFile();
             constexpr const char* name() override {
                 return "StandardFileSystem::OutputFile";
             }
+            bool is_open() override;
+            void close() override;
+            bool open() override;
+            bool write(std::span<const Byte> bytes) override;
+        private:
+            std::string _path;
+            std::ofstream _file;
         };
         StandardFileSystem(StandardFilePicker& picker);
         constexpr const char* name() override {
@@ -67,6 +105,8 @@ namespace com::saxbophone::zench {
         std::unique_ptr<FileSystem::InputFile> open_for_read(std::string filename) override;
         std::unique_ptr<FileSystem::OutputFile> open_for_write() override;
         std::unique_ptr<FileSystem::OutputFile> open_for_write(std::string filename) override;
+    private:
+        StandardFilePicker& _picker;
     };
 }
 
@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @brief This file forms part of libzench
+ * @details libzench is a software library that implements a portable and
+ * extensible Z-machine interpreter, designed to be embedded within other
+ * programs.
+ *
+ * @author the zench contributors
+ * @date October 2026
+ *
+ * @copyright Copyright the zench contributors 2026
+ *
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_STORY_IMAGE_HPP
+#define COM_SAXBOPHONE_ZENCH_STORY_IMAGE_HPP
+
+#include <cstddef>               // size_t
+
+#include <memory>                // shared_ptr, unique_ptr
+#include <span>                  // span
+#include <vector>                // vector
+
+#include <zench/FileSystem.hpp>
+#include <zench/zench.hpp>
+
+namespace com::saxbophone::zench {
+    class StringCache;
+
+    /**
+     * @brief The contents of a story file, as loaded at startup
+     * @details A StoryImage is immutable once loaded, so one image can be
+     * shared by any number of ZMachine instances playing the same story, even
+     * from different threads. Each ZMachine only keeps its own copy of the
+     * dynamic memory, reading static and high memory from the shared image.
+     */
+    class StoryImage {
+    public:
+        static constexpr std::size_t HEADER_SIZE = 64;
+        /**
+         * @brief Reads in and validates a story file
+         * @throws CantReadStoryFileException if the file is not open
+         * @throws UnsupportedVersionException if the story's version is not
+         * supported
+         * @throws InvalidStoryFileException if the story file is malformed
+         */
+        static std::shared_ptr<const StoryImage> load(FileSystem::InputFile& story_file);
+        /**
+         * @returns the whole story file, as it was when loaded
+         */
+        std::span<const Byte> bytes() const;
+        ZVersion version() const;
+        /**
+         * @returns the address of the first byte after dynamic memory
+         */
+        ByteAddress static_memory_begin() const;
+        /**
+         * @returns the decoded text of strings in static and high memory,
+         * which is shared by all ZMachines playing this story
+         * @note Safe to use from any number of threads at once.
+         */
+        StringCache& strings() const;
+        ~StoryImage();
+    private:
+        StoryImage(std::vector<Byte> bytes);
+
+        std::vector<Byte> _bytes;
+        std::unique_ptr<StringCache> _strings;
+    };
+}
+
+#endif // include guard
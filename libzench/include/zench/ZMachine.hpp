@@ -19,31 +19,245 @@
 #ifndef COM_SAXBOPHONE_ZENCH_ZMACHINE_HPP
 #define COM_SAXBOPHONE_ZENCH_ZMACHINE_HPP
 
-#include <memory>   // unique_ptr
+#include <cstddef>   // size_t
+#include <cstdint>   // uint64_t
+
+#include <array>     // array
+#include <coroutine> // coroutine_handle, noop_coroutine, suspend_always, suspend_never
+#include <exception> // exception_ptr
+#include <memory>    // shared_ptr, unique_ptr
+#include <string>    // string
+#include <vector>    // vector
 
 #include <zench/FileSystem.hpp>
 #include <zench/Keyboard.hpp>
 #include <zench/Screen.hpp>
+#include <zench/StoryImage.hpp>
 
 namespace com::saxbophone::zench {
     class ZMachine {
     public:
+        // reasons for which a batch of instructions stopped executing
+        enum class Status {
+            WaitingForInput, // a READ opcode is waiting on Keyboard input
+            Quit, // the story has quit, or this ZMachine was not ready
+            BudgetExhausted, // the requested number of instructions were executed
+            Error, // execution was halted by an error, see error()
+        };
+        // the ways in which instructions can be dispatched to their implementations
+        enum class Dispatch {
+            Switch, // switch on opcode category, then on opcode number
+            Threaded, // flat table indexed by opcode byte, threaded with computed goto where supported
+        };
+        class Task;
+        // number of buckets in OpcodeStats::histogram
+        static constexpr std::size_t TIMING_BUCKETS = 24;
+        // how often an opcode has been executed, and how long it took, as reported by stats()
+        struct OpcodeStats {
+            const char* name = ""; // the opcode's name, as in the Z-machine standard
+            std::uint64_t count = 0; // times executed
+            std::uint64_t sampled = 0; // executions which were timed
+            std::uint64_t nanoseconds = 0; // total time taken by the timed executions
+            /*
+             * The timed executions by how long they took: bucket 0 counts
+             * those under 1ns, and each bucket b after that those taking at
+             * least 2^(b-1)ns but under 2^b ns. The last bucket also counts
+             * any which took longer.
+             */
+            std::array<std::uint64_t, TIMING_BUCKETS> histogram = {};
+        };
+        // a snapshot of the counts and timings recorded for a ZMachine's opcodes
+        struct Stats {
+            /*
+             * whether libzench was built with opcode stats (ENABLE_OPCODE_STATS
+             * in CMake), without which nothing is recorded and the rest is empty
+             */
+            bool enabled = false;
+            std::uint64_t instructions = 0; // executed in total
+            // one per opcode handler, including the one for opcodes that aren't implemented
+            std::vector<OpcodeStats> opcodes;
+        };
+        // the default for set_undo_budget(), enough for hundreds of turns of a typical story
+        static constexpr std::size_t DEFAULT_UNDO_BUDGET = 256 * 1024;
+        // loads the story from story_file, for use by this ZMachine alone
         ZMachine(
             FileSystem::InputFile& story_file,
             FileSystem& fs,
             Screen& screen,
-            Keyboard& keyboard
+            Keyboard& keyboard,
+            Dispatch dispatch = Dispatch::Threaded
+        );
+        // plays a story which has already been loaded, and may be shared with other ZMachines
+        ZMachine(
+            std::shared_ptr<const StoryImage> story,
+            FileSystem& fs,
+            Screen& screen,
+            Keyboard& keyboard,
+            Dispatch dispatch = Dispatch::Threaded
         );
         ~ZMachine();
         // returns true if ZMachine instance is ready to execute an instruction
         bool is_ready();
         // executes one instruction
         void execute();
+        /*
+         * executes up to max_instructions instructions, stopping early if the
+         * ZMachine quits, hits an error or needs input which isn't available
+         * NOTE: errors are reported by status rather than thrown, and halt the
+         * ZMachine for good
+         */
+        Status run(std::size_t max_instructions);
+        // executes instructions until the ZMachine quits, hits an error or needs input
+        Status run_until_blocked();
+        // returns the error that halted execution, or nullptr if there wasn't one
+        std::exception_ptr error() const;
+        /*
+         * Hands everything printed so far to the Screen. This happens by
+         * itself whenever a READ starts, the ZMachine stops for good, or
+         * enough output has built up.
+         */
+        void flush_screen();
+        /*
+         * Starts playing the story as a coroutine, which runs until a READ
+         * needs input and then suspends, rather than returning, until resumed
+         * with Task::resume(). The Task completes when the ZMachine quits or
+         * hits an error, and can be co_awaited to be resumed at that point.
+         * NOTE: this ZMachine must outlive the returned Task
+         */
+        Task play();
+        /*
+         * Sets the most memory, in bytes, which this ZMachine may use to
+         * remember earlier turns for undo(). A turn is remembered each time
+         * the story asks for a line of input. Zero disables undo.
+         */
+        void set_undo_budget(std::size_t bytes);
+        // how many turns can currently be undone
+        std::size_t undo_depth() const;
+        /*
+         * Rewinds to where the story asked for input the given number of
+         * turns ago, returning false (and changing nothing) if that turn
+         * isn't remembered.
+         */
+        bool undo(std::size_t turns = 1);
+        /*
+         * Returns the number of times each opcode has been executed since
+         * this ZMachine started or reset_stats() was last called, along with
+         * the time taken by a sample of those executions.
+         */
+        Stats stats() const;
+        void reset_stats();
+        // the number of instructions executed since this ZMachine started, whether or not stats are built in
+        std::uint64_t instructions() const;
+        /*
+         * Starts profiling the story afresh, sampling which of its routines
+         * are on the Z-machine's call stack once every given number of
+         * instructions. Zero stops profiling and discards the profile.
+         */
+        void set_profiling_interval(std::size_t instructions);
+        /*
+         * The call stacks sampled since profiling started, in the folded
+         * format read by flame graph tools: one line per distinct stack,
+         * such as "main;0x4e3c;0x5a10 42", naming routines by their byte
+         * addresses (or "?" where not known, as after a restore) from the
+         * outermost inwards, followed by the number of samples of it.
+         */
+        std::string profile() const;
     private:
         class ZMachineImpl;
         // pimpl pointer
         std::unique_ptr<ZMachineImpl> _impl;
     };
+
+    /*
+     * The coroutine returned by ZMachine::play(), which owns the suspended
+     * state of a game in progress.
+     */
+    class ZMachine::Task {
+    public:
+        struct promise_type {
+            // on completion, resumes whichever coroutine was awaiting the Task
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> task) noexcept {
+                    std::coroutine_handle<> continuation = task.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() const noexcept {}
+            };
+
+            Task get_return_object() {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            // plays eagerly up to the first READ
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            // suspends whilst waiting for input
+            std::suspend_always yield_value(ZMachine::Status stopped) noexcept {
+                this->status = stopped;
+                return {};
+            }
+            void return_value(ZMachine::Status stopped) noexcept {
+                this->status = stopped;
+            }
+            void unhandled_exception() noexcept {
+                this->status = ZMachine::Status::Error;
+            }
+
+            ZMachine::Status status = ZMachine::Status::WaitingForInput;
+            std::coroutine_handle<> continuation;
+        };
+
+        Task(Task&& other) noexcept : _handle(other._handle) {
+            other._handle = {};
+        }
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (this->_handle) {
+                    this->_handle.destroy();
+                }
+                this->_handle = other._handle;
+                other._handle = {};
+            }
+            return *this;
+        }
+        ~Task() {
+            if (this->_handle) {
+                this->_handle.destroy();
+            }
+        }
+        // returns true once the ZMachine has quit or hit an error
+        bool done() const {
+            return not this->_handle or this->_handle.done();
+        }
+        // WaitingForInput whilst suspended, otherwise Quit or Error
+        ZMachine::Status status() const {
+            return this->_handle ? this->_handle.promise().status : ZMachine::Status::Quit;
+        }
+        /*
+         * Carries on playing, once input may be available, until input is
+         * needed again or the game is over. Returns the new status().
+         */
+        ZMachine::Status resume() {
+            if (not this->done()) {
+                this->_handle.resume();
+            }
+            return this->status();
+        }
+        // co_awaiting a Task resumes the awaiting coroutine once the game is over
+        bool await_ready() const noexcept {
+            return this->done();
+        }
+        void await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            this->_handle.promise().continuation = awaiting;
+        }
+        ZMachine::Status await_resume() const noexcept {
+            return this->status();
+        }
+    private:
+        explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+        std::coroutine_handle<promise_type> _handle;
+    };
 }
 
 #endif // include guard
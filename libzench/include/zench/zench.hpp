@@ -0,0 +1,108 @@
+/**
+ * @file
+ * @brief This file forms part of libzench
+ * @details libzench is a software library that implements a portable and
+ * extensible Z-machine interpreter, designed to be embedded within other
+ * programs.
+ *
+ * @author the zench contributors
+ * @date October 2026
+ *
+ * @copyright Copyright the zench contributors 2026
+ *
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_ZENCH_HPP
+#define COM_SAXBOPHONE_ZENCH_ZENCH_HPP
+
+#include <cstdint>   // fixed-width types
+
+#include <exception> // exception
+#include <string>    // string
+
+namespace com::saxbophone::zench {
+    using Byte = std::uint8_t;
+    using Word = std::uint16_t;
+    using SWord = std::int16_t; // signed Word
+    // these addresses can address any byte in memory. Range depends on version, but never bigger than 19-bit.
+    using Address = std::uint32_t;
+    using ByteAddress = std::uint16_t; // address to a Byte anywhere in dynamic or static memory
+    using WordAddress = std::uint16_t; // address/2 of a Word anywhere in the bottom 128KiB of all memory
+    using PackedAddress = std::uint16_t; // packed address for routines and strings
+    // handy enum for Z-machine versions
+    enum class ZVersion : int {
+        UNDEFINED = 0,
+        V1 = 1,
+        V2 = 2,
+        V3 = 3,
+        V4 = 4,
+        V5 = 5,
+        V6 = 6,
+        V7 = 7,
+        V8 = 8,
+    };
+
+    /**
+     * @brief Base class for all of zench's exceptions
+     */
+    class Exception : public std::exception {};
+    class CantReadStoryFileException : public Exception {
+        const char* what() const noexcept {
+            return "Can't read story file";
+        }
+    };
+    class UnsupportedVersionException : public Exception {
+    public:
+        // version is the story's, or 0 if an instruction only found in later versions was met
+        UnsupportedVersionException(Byte version = 0);
+        const char* what() const noexcept;
+        Byte version() const;
+    private:
+        Byte _version;
+        std::string _message;
+    };
+    class InvalidStoryFileException : public Exception {
+        const char* what() const noexcept {
+            return "Invalid story file";
+        }
+    };
+    class UnimplementedInstructionException : public Exception {
+        const char* what() const noexcept {
+            return "Unimplemented instruction encountered";
+        }
+    };
+    class WrongNumberOfInstructionOperandsException : public Exception {
+        const char* what() const noexcept {
+            return "Wrong number of operands given to instruction";
+        }
+    };
+    class StackUnderflowException : public Exception {
+        const char* what() const noexcept {
+            return "Attempted to pop an empty stack";
+        }
+    };
+    class StackOverflowException : public Exception {
+        const char* what() const noexcept {
+            return "Attempted to grow the stack beyond its capacity";
+        }
+    };
+    class IllegalMemoryWriteException : public Exception {
+        const char* what() const noexcept {
+            return "Attempted to write outside of dynamic memory";
+        }
+    };
+    class DivisionByZeroException : public Exception {
+        const char* what() const noexcept {
+            return "Attempted division by zero";
+        }
+    };
+
+    extern const std::string VERSION;
+    extern const std::string VERSION_DESCRIPTION;
+}
+
+#endif // include guard
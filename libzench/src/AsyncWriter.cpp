@@ -0,0 +1,217 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>            // size_t
+
+#include <algorithm>          // min
+#include <condition_variable> // condition_variable
+#include <deque>              // deque
+#include <memory>             // make_shared, shared_ptr, unique_ptr
+#include <mutex>              // lock_guard, mutex, unique_lock
+#include <span>               // span
+#include <string_view>        // string_view
+#include <thread>             // thread
+#include <utility>            // move
+#include <vector>             // vector
+
+#include <zench/FileSystem.hpp>
+#include <zench/zench.hpp>
+
+#include "AsyncWriter.hpp"
+
+namespace com::saxbophone::zench {
+    struct AsyncWriter::Channel {
+        /*
+         * Writes the oldest full buffer to the file.
+         * Returns true if there are more waiting, otherwise the channel is no
+         * longer scheduled.
+         */
+        bool write_next();
+
+        // only used by the I/O thread whilst scheduled, and by the writer otherwise
+        std::unique_ptr<FileSystem::OutputFile> file;
+        // guards everything below
+        std::mutex mutex;
+        // notified whenever a buffer has been written
+        std::condition_variable written;
+        // full buffers waiting to be written, oldest first, the front one being written when scheduled
+        std::deque<std::vector<Byte>> full;
+        // emptied buffers, ready to be filled again
+        std::vector<std::vector<Byte>> spare;
+        // whether the I/O thread has this channel in its queue or is writing it
+        bool scheduled = false;
+        bool failed = false;
+    };
+
+    namespace {
+        // writes the buffers of every AsyncWriter in the process, a buffer at a time from each in turn
+        class IoThread {
+        public:
+            static IoThread& instance() {
+                static IoThread io_thread;
+                return io_thread;
+            }
+
+            ~IoThread() {
+                {
+                    std::lock_guard lock(this->_mutex);
+                    this->_stopping = true;
+                }
+                this->_work_available.notify_one();
+                this->_thread.join();
+            }
+
+            void schedule(std::shared_ptr<AsyncWriter::Channel> channel) {
+                {
+                    std::lock_guard lock(this->_mutex);
+                    this->_channels.push_back(std::move(channel));
+                }
+                this->_work_available.notify_one();
+            }
+        private:
+            IoThread() : _thread([this] { this->_work(); }) {}
+
+            void _work() {
+                while (true) {
+                    std::shared_ptr<AsyncWriter::Channel> channel;
+                    {
+                        std::unique_lock lock(this->_mutex);
+                        this->_work_available.wait(lock, [this] {
+                            return this->_stopping or not this->_channels.empty();
+                        });
+                        // anything already handed over is still written before stopping
+                        if (this->_channels.empty()) {
+                            return;
+                        }
+                        channel = std::move(this->_channels.front());
+                        this->_channels.pop_front();
+                    }
+                    // one buffer at a time, so that a busy writer doesn't hold up the others
+                    if (channel->write_next()) {
+                        this->schedule(std::move(channel));
+                    }
+                }
+            }
+
+            std::mutex _mutex;
+            std::condition_variable _work_available;
+            std::deque<std::shared_ptr<AsyncWriter::Channel>> _channels;
+            bool _stopping = false;
+            std::thread _thread;
+        };
+    }
+
+    bool AsyncWriter::Channel::write_next() {
+        std::unique_lock lock(this->mutex);
+        // the writer only ever appends, so the front buffer stays put whilst unlocked
+        std::vector<Byte>& buffer = this->full.front();
+        lock.unlock();
+        bool written = this->file->write(buffer);
+        lock.lock();
+        this->failed = this->failed or not written;
+        buffer.clear();
+        this->spare.push_back(std::move(buffer));
+        this->full.pop_front();
+        this->scheduled = not this->full.empty();
+        // the writer may be waiting for room, or for everything to be written
+        this->written.notify_all();
+        return this->scheduled;
+    }
+
+    AsyncWriter::AsyncWriter(std::unique_ptr<FileSystem::OutputFile> file, std::size_t buffer_size)
+      : _buffer_size(buffer_size < 1 ? 1 : buffer_size)
+      , _channel(std::make_shared<Channel>())
+      {
+        if (file == nullptr) {
+            throw Exception(); // ERROR! nothing to write to
+        }
+        this->_channel->file = std::move(file);
+        this->_buffer.reserve(this->_buffer_size);
+      }
+
+    AsyncWriter::~AsyncWriter() {
+        this->close();
+    }
+
+    void AsyncWriter::write(std::span<const Byte> bytes) {
+        while (not bytes.empty()) {
+            std::size_t count = std::min(bytes.size(), this->_buffer_size - this->_buffer.size());
+            this->_buffer.insert(this->_buffer.end(), bytes.begin(), bytes.begin() + (std::ptrdiff_t)count);
+            bytes = bytes.subspan(count);
+            if (this->_buffer.size() == this->_buffer_size) {
+                this->_hand_over();
+            }
+        }
+    }
+
+    void AsyncWriter::write(std::string_view text) {
+        this->write(std::span<const Byte>((const Byte*)text.data(), text.size()));
+    }
+
+    void AsyncWriter::write(char character) {
+        this->_buffer.push_back((Byte)character);
+        if (this->_buffer.size() == this->_buffer_size) {
+            this->_hand_over();
+        }
+    }
+
+    void AsyncWriter::submit() {
+        if (not this->_buffer.empty()) {
+            this->_hand_over();
+        }
+    }
+
+    bool AsyncWriter::flush() {
+        this->submit();
+        std::unique_lock lock(this->_channel->mutex);
+        this->_channel->written.wait(lock, [this] { return not this->_channel->scheduled; });
+        return not this->_channel->failed;
+    }
+
+    bool AsyncWriter::close() {
+        if (this->_closed) {
+            return not this->_channel->failed;
+        }
+        bool flushed = this->flush();
+        // the I/O thread is done with the file once the channel is no longer scheduled
+        this->_channel->file->close();
+        this->_closed = true;
+        return flushed;
+    }
+
+    void AsyncWriter::_hand_over() {
+        if (this->_closed) {
+            throw Exception(); // ERROR! written to after being closed
+        }
+        Channel& channel = *this->_channel;
+        bool schedule;
+        {
+            std::unique_lock lock(channel.mutex);
+            channel.written.wait(lock, [&channel] { return channel.full.size() < MAX_PENDING_BUFFERS; });
+            channel.full.push_back(std::move(this->_buffer));
+            if (channel.spare.empty()) {
+                this->_buffer = {};
+                this->_buffer.reserve(this->_buffer_size);
+            } else {
+                this->_buffer = std::move(channel.spare.back());
+                channel.spare.pop_back();
+            }
+            schedule = not channel.scheduled;
+            channel.scheduled = true;
+        }
+        if (schedule) {
+            IoThread::instance().schedule(this->_channel);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_ASYNC_WRITER_HPP
+#define COM_SAXBOPHONE_ZENCH_ASYNC_WRITER_HPP
+
+#include <cstddef>              // size_t
+
+#include <memory>               // shared_ptr, unique_ptr
+#include <span>                 // span
+#include <string_view>          // string_view
+#include <vector>               // vector
+
+#include <zench/FileSystem.hpp>
+#include <zench/zench.hpp>      // base library definitions of core types
+
+namespace com::saxbophone::zench {
+    /*
+     * Writes to an OutputFile without waiting for it, for output streams such
+     * as the transcript which are written a character at a time.
+     *
+     * Writes are gathered into a buffer, and each full buffer is handed to an
+     * I/O thread shared by every AsyncWriter in the process, which writes the
+     * buffers of all of them in turn. Buffers are reused once written, and
+     * only a few may be waiting at once: a writer which gets that far ahead of
+     * its file blocks until the I/O thread catches up, so memory stays bounded
+     * however slow the file is.
+     *
+     * NOTE: an AsyncWriter may only be used by one thread at a time, and must
+     * be closed or destroyed before main() returns.
+     */
+    class AsyncWriter {
+    public:
+        static constexpr std::size_t DEFAULT_BUFFER_SIZE = 4096;
+        // full buffers which may be waiting for the I/O thread before write() blocks
+        static constexpr std::size_t MAX_PENDING_BUFFERS = 4;
+
+        AsyncWriter(std::unique_ptr<FileSystem::OutputFile> file, std::size_t buffer_size = DEFAULT_BUFFER_SIZE);
+        // closes the file, after writing everything written to it so far
+        ~AsyncWriter();
+        AsyncWriter(const AsyncWriter&) = delete;
+        AsyncWriter& operator=(const AsyncWriter&) = delete;
+        void write(std::span<const Byte> bytes);
+        void write(std::string_view text);
+        void write(char character);
+        // hands whatever has been written so far to the I/O thread, without waiting for it
+        void submit();
+        /*
+         * Waits until everything written so far is in the file.
+         * Returns false if any write to the file has failed.
+         */
+        bool flush();
+        // flushes and closes the file, after which nothing more may be written
+        bool close();
+
+        // the state shared with the I/O thread
+        struct Channel;
+    private:
+
+        // hands the current buffer to the I/O thread, first waiting for room if need be
+        void _hand_over();
+
+        std::size_t _buffer_size;
+        // shared with the I/O thread, which may still hold it for a moment after the writer is gone
+        std::shared_ptr<Channel> _channel;
+        // the buffer being filled
+        std::vector<Byte> _buffer;
+        bool _closed = false;
+    };
+}
+
+#endif // include guard
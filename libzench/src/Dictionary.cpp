@@ -0,0 +1,210 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>         // size_t
+#include <cstdint>         // uint64_t
+#include <cstring>         // memcmp
+
+#include <algorithm>       // find
+#include <array>           // array
+#include <bit>             // bit_ceil, countr_zero
+#include <span>            // span
+#include <string_view>     // string_view
+#include <vector>          // vector
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+#include "Dictionary.hpp"
+
+namespace {
+    using namespace com::saxbophone::zench;
+
+    using ZChar = Byte;
+
+    // the A2 alphabet from Z-char 7 onwards (Z-char 6 is the ZSCII escape), V2 onwards
+    constexpr std::string_view A2_CHARACTERS = "\n0123456789.,!?_#'\"/\\-:()";
+
+    Word load_word(std::span<const Byte> memory, std::size_t address) {
+        return (Word)((memory[address] << 8) | memory[address + 1]);
+    }
+}
+
+namespace com::saxbophone::zench {
+    Dictionary::Index::Index(const Dictionary& dictionary) : _length(dictionary.encoded_length()) {
+        SWord entries_count = dictionary._entries_count();
+        std::size_t count = (std::size_t)(entries_count < 0 ? -entries_count : entries_count);
+        // at most half full, so that probe sequences stay short
+        std::size_t slots = std::bit_ceil(2 * count + 1);
+        this->_shift = 64 - (std::size_t)std::countr_zero(slots);
+        this->_slots.assign(slots, {0, 0});
+        for (std::size_t i = 0; i < count; i++) {
+            std::size_t entry = dictionary._entries() + i * dictionary._entry_length();
+            std::uint64_t key = _key(&dictionary._memory[entry], this->_length);
+            Slot& slot = this->_slots[this->_slot_for(key)];
+            // if a word is in an unsorted dictionary twice, the first is the one found by searching
+            if (slot.entry == 0) {
+                slot = {key, (ByteAddress)entry};
+            }
+        }
+    }
+
+    ByteAddress Dictionary::Index::lookup(const EncodedWord& word) const {
+        return this->_slots[this->_slot_for(_key(word.data(), this->_length))].entry;
+    }
+
+    std::uint64_t Dictionary::Index::_key(const Byte* word, std::size_t length) {
+        std::uint64_t key = 0;
+        for (std::size_t b = 0; b < length; b++) {
+            key = key << 8 | word[b];
+        }
+        return key;
+    }
+
+    std::size_t Dictionary::Index::_slot_for(std::uint64_t key) const {
+        // Fibonacci hashing, then linear probing until the key or an empty slot is found
+        std::size_t mask = this->_slots.size() - 1;
+        std::size_t slot = this->_shift == 64 ? 0 : (std::size_t)(key * 0x9E3779B97F4A7C15u >> this->_shift);
+        while (this->_slots[slot].entry != 0 and this->_slots[slot].key != key) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    Dictionary::Dictionary(ZVersion version, std::span<const Byte> memory, ByteAddress address, const Index* index)
+      : _index(index)
+      , _version(version)
+      , _memory(memory)
+      , _address(address)
+      {
+        // the header must be read before the entries can be found
+        if (address + 4u > memory.size() or this->_entries() > memory.size()) {
+            throw Exception(); // ERROR! dictionary runs beyond the end of memory
+        }
+        if ((this->_entries_count() != 0 and this->_entry_length() < this->encoded_length()) or this->end() > memory.size()) {
+            throw Exception(); // ERROR! dictionary entries are malformed or run beyond the end of memory
+        }
+      }
+
+    std::span<const Byte> Dictionary::separators() const {
+        return this->_memory.subspan(this->_address + 1u, this->_memory[this->_address]);
+    }
+
+    bool Dictionary::is_separator(Byte zscii) const {
+        auto separators = this->separators();
+        return std::find(separators.begin(), separators.end(), zscii) != separators.end();
+    }
+
+    std::size_t Dictionary::encoded_length() const {
+        return this->_version < ZVersion::V4 ? 4 : 6;
+    }
+
+    Dictionary::EncodedWord Dictionary::encode(std::span<const Byte> zscii) const {
+        // 3 Z-chars per Word, 2 Words in V1-3 and 3 Words in V4+
+        std::size_t length = this->encoded_length() / 2 * 3;
+        std::array<ZChar, 9> z_chars;
+        std::size_t z = 0;
+        auto emit = [&](ZChar c) {
+            if (z < length) {
+                z_chars[z++] = c;
+            }
+        };
+        for (Byte c : zscii) {
+            if ('a' <= c and c <= 'z') {
+                emit((ZChar)(c - 'a' + 6));
+            } else if (auto found = A2_CHARACTERS.find((char)c); c != 0 and found != std::string_view::npos) {
+                emit(5); // shift to A2 for the next character only
+                emit((ZChar)(found + 7));
+            } else {
+                // ZSCII escape sequence --the 10-bit code is split across two Z-chars
+                emit(5);
+                emit(6);
+                emit((ZChar)(c >> 5));
+                emit((ZChar)(c & 0b11111));
+            }
+        }
+        // pad out with shift characters
+        while (z < length) {
+            z_chars[z++] = 5;
+        }
+        EncodedWord encoded = {};
+        for (std::size_t w = 0; w < length / 3; w++) {
+            Word word = (Word)((z_chars[w * 3] << 10) | (z_chars[w * 3 + 1] << 5) | z_chars[w * 3 + 2]);
+            // the last Word has its top bit set to mark the end of the string
+            if (w == length / 3 - 1) {
+                word |= 0x8000;
+            }
+            encoded[w * 2] = (Byte)(word >> 8);
+            encoded[w * 2 + 1] = (Byte)word;
+        }
+        return encoded;
+    }
+
+    ByteAddress Dictionary::lookup(const EncodedWord& word) const {
+        if (this->_index != nullptr) {
+            return this->_index->lookup(word);
+        }
+        std::size_t entry_length = this->_entry_length();
+        SWord entries_count = this->_entries_count();
+        std::size_t entries = this->_entries();
+        std::size_t length = this->encoded_length();
+        if (entries_count < 0) {
+            // a negative count indicates an unsorted dictionary which must be searched linearly
+            for (std::size_t i = 0; i < (std::size_t)-entries_count; i++) {
+                std::size_t entry = entries + i * entry_length;
+                if (std::memcmp(&this->_memory[entry], word.data(), length) == 0) {
+                    return (ByteAddress)entry;
+                }
+            }
+            return 0;
+        }
+        // entries are sorted in numerical order of their encoded form, so we can binary search them
+        std::size_t low = 0;
+        std::size_t high = (std::size_t)entries_count;
+        while (low < high) {
+            std::size_t middle = low + (high - low) / 2;
+            std::size_t entry = entries + middle * entry_length;
+            int comparison = std::memcmp(&this->_memory[entry], word.data(), length);
+            if (comparison == 0) {
+                return (ByteAddress)entry;
+            } else if (comparison < 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return 0;
+    }
+
+    ByteAddress Dictionary::lookup(std::span<const Byte> zscii) const {
+        return this->lookup(this->encode(zscii));
+    }
+
+    Address Dictionary::end() const {
+        SWord entries_count = this->_entries_count();
+        std::size_t count = (std::size_t)(entries_count < 0 ? -entries_count : entries_count);
+        return (Address)(this->_entries() + count * this->_entry_length());
+    }
+
+    SWord Dictionary::_entries_count() const {
+        return (SWord)load_word(this->_memory, this->_address + 2u + this->_memory[this->_address]);
+    }
+
+    std::size_t Dictionary::_entries() const {
+        return this->_address + 4u + this->_memory[this->_address];
+    }
+
+    std::size_t Dictionary::_entry_length() const {
+        return this->_memory[this->_address + 1u + this->_memory[this->_address]];
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_DICTIONARY_HPP
+#define COM_SAXBOPHONE_ZENCH_DICTIONARY_HPP
+
+#include <cstddef>         // size_t
+#include <cstdint>         // uint64_t
+
+#include <array>           // array
+#include <span>            // span
+#include <vector>          // vector
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+namespace com::saxbophone::zench {
+    /*
+     * Read-only view of a dictionary table in story memory, used to look up
+     * words typed by the player.
+     * NOTE: without an Index, the dictionary is read from memory on every
+     * lookup, so it stays correct even if the table lives in dynamic memory
+     * and is modified.
+     */
+    class Dictionary {
+    public:
+        // words are encoded into 4 bytes (V1-3) or 6 bytes (V4+), so this holds either
+        using EncodedWord = std::array<Byte, 6>;
+
+        /*
+         * A hash table of a dictionary's entries by their encoded words, so
+         * that looking a word up takes a probe or two rather than a search of
+         * the whole table. It's built from the dictionary as it was at the
+         * time, so it must be rebuilt if the dictionary is modified.
+         */
+        class Index {
+        public:
+            Index(const Dictionary& dictionary);
+            // returns the address of the dictionary entry for the word, or 0 if it's not in the dictionary
+            ByteAddress lookup(const EncodedWord& word) const;
+        private:
+            struct Slot {
+                std::uint64_t key;
+                ByteAddress entry; // 0 if the slot is empty
+            };
+
+            static std::uint64_t _key(const Byte* word, std::size_t length);
+            std::size_t _slot_for(std::uint64_t key) const;
+
+            std::size_t _length; // bytes of each encoded word
+            std::size_t _shift; // to take the top bits of a hash, as the slot to start probing from
+            std::vector<Slot> _slots; // a power of two of them, always at least one empty
+        };
+
+        Dictionary(ZVersion version, std::span<const Byte> memory, ByteAddress address, const Index* index = nullptr);
+        // the ZSCII characters which are treated as words in their own right
+        std::span<const Byte> separators() const;
+        bool is_separator(Byte zscii) const;
+        // number of bytes of each entry which make up the encoded word
+        std::size_t encoded_length() const;
+        /*
+         * Encodes a word of (lower-case) ZSCII text into the form used for
+         * dictionary entries, truncating it as required.
+         */
+        EncodedWord encode(std::span<const Byte> zscii) const;
+        // returns the address of the dictionary entry for the word, or 0 if it's not in the dictionary
+        ByteAddress lookup(const EncodedWord& word) const;
+        ByteAddress lookup(std::span<const Byte> zscii) const;
+        // the address just past the last entry
+        Address end() const;
+    private:
+        // the number of entries, negative if they aren't sorted
+        SWord _entries_count() const;
+        // the address of the first entry
+        std::size_t _entries() const;
+        std::size_t _entry_length() const;
+
+        const Index* _index;
+        ZVersion _version;
+        std::span<const Byte> _memory;
+        ByteAddress _address;
+    };
+}
+
+#endif // include guard
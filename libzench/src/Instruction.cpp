@@ -0,0 +1,501 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>   // size_t
+
+#include <array>     // array
+#include <iomanip>   // setfill
+#include <span>      // span
+#include <string>    // string
+#include <sstream>   // stringstream
+
+#include <zench/zench.hpp>
+#include "Instruction.hpp"
+#include "ZStringDecoder.hpp"
+
+namespace com::saxbophone::zench {
+    Byte Instruction::_next_byte(Address& pc, std::span<const Byte> memory_view) {
+        if (pc >= memory_view.size()) {
+            throw Exception(); // ERROR! instruction runs beyond the end of memory
+        }
+        return memory_view[pc++];
+    }
+
+    void Instruction::_determine_opcode_type(
+        Address& pc,
+        std::span<const Byte> memory_view,
+        Instruction& instruction,
+        std::array<Instruction::OperandType, Instruction::MAX_OPERANDS>& operand_types
+    ) {
+        Byte first = Instruction::_next_byte(pc, memory_view); // first byte of instruction
+        instruction.opcode_byte = first;
+        // determine the instruction's form first, this is useful mainly for categorising instructions
+        if (first == 0xBE) { // extended mode
+            // NOTE: extended form is V5+, and StoryImage only accepts V3 stories
+            throw UnsupportedVersionException();
+        } else {
+            // read top two bits to determine instruction form
+            Byte top_bits = first >> 6;
+            switch (top_bits) {
+            case 0b11: {
+                instruction.form = Instruction::Form::VARIABLE;
+                // if bit 5 is not set, then it's *categorised* as 2-OP but it's not actually limited to only 2 operands!
+                if ((first & 0b00100000) == 0) {
+                    // in other words, a 2OP-category opcode assembled in variable form
+                    instruction.category = Instruction::Category::_2OP;
+                } else {
+                    // otherwise, it is in fact a *true* VAR opcode assembled in variable form!
+                    instruction.category = Instruction::Category::VAR;
+                }
+                // opcode is always bottom 5 bits
+                instruction.opcode = first & 0b00011111;
+                // read operand types from the next byte, or the next two for the double-VAR opcodes call_vs2 and call_vn2
+                bool double_var =
+                    instruction.category == Instruction::Category::VAR
+                    and (instruction.opcode == 12 or instruction.opcode == 26);
+                std::size_t types_count = double_var ? 8 : 4;
+                Word types = Instruction::_next_byte(pc, memory_view);
+                if (double_var) {
+                    types = (Word)((types << 8) | Instruction::_next_byte(pc, memory_view));
+                }
+                for (std::size_t i = types_count; i --> 0;) {
+                    Instruction::OperandType type = (Instruction::OperandType)((types >> i * 2) & 0b11);
+                    if (type == Instruction::OperandType::OMITTED) {
+                        break;
+                    }
+                    operand_types[instruction.operand_count++] = type;
+                }
+                break;
+            }
+            case 0b10: {
+                instruction.form = Instruction::Form::SHORT;
+                // determine argument type and opcode --type is bits 4 and 5
+                Instruction::OperandType type = (Instruction::OperandType)((first & 0b00110000) >> 4);
+                // don't push OMITTED types into operand list
+                if (type != Instruction::OperandType::OMITTED) {
+                    instruction.category = Instruction::Category::_1OP;
+                    operand_types[instruction.operand_count++] = type;
+                } else {
+                    instruction.category = Instruction::Category::_0OP;
+                }
+                // opcode is always bottom 4 bits
+                instruction.opcode = first & 0b00001111;
+                break;
+            }
+            default:
+                instruction.form = Instruction::Form::LONG;
+                instruction.category = Instruction::Category::_2OP;
+                // long form is always 2-OP --op types are packed into bits 6 and 5
+                operand_types[0] = first & 0b01000000 ? Instruction::OperandType::VARIABLE : Instruction::OperandType::SMALL_CONSTANT;
+                operand_types[1] = first & 0b00100000 ? Instruction::OperandType::VARIABLE : Instruction::OperandType::SMALL_CONSTANT;
+                instruction.operand_count = 2;
+                // opcode is always bottom 5 bits
+                instruction.opcode = first & 0b00011111;
+                break;
+            }
+        }
+    }
+
+    void Instruction::_read_in_operand_values(
+        Address& pc,
+        std::span<const Byte> memory_view,
+        Instruction& instruction,
+        const std::array<Instruction::OperandType, Instruction::MAX_OPERANDS>& operand_types
+    ) {
+        for (std::size_t i = 0; i < instruction.operand_count; i++) {
+            // this is the only type that pulls a word rather than a byte
+            if (operand_types[i] == Instruction::OperandType::LARGE_CONSTANT) {
+                // would use ZMachine.load_word() but it's not accessible
+                Word high = Instruction::_next_byte(pc, memory_view);
+                instruction.operands[i] = (Word)((high << 8) + Instruction::_next_byte(pc, memory_view));
+            } else {
+                // both SMALL_CONSTANT and VARIABLE are byte-sized
+                instruction.operands[i] = Instruction::_next_byte(pc, memory_view);
+                if (operand_types[i] == Instruction::OperandType::VARIABLE) {
+                    instruction.variable_operands |= (Byte)(1u << i);
+                }
+            }
+        }
+    }
+
+    bool Instruction::_is_instruction_store() const {
+        // NOTE: store opcodes from versions greater than v3 ignored
+        // also extended form, but we're not handling those right now
+        if (this->category == Instruction::Category::VAR) {
+            switch (this->opcode) {
+            case 0x00: case 0x07: case 0x0c: // call_vs2 is V4+ but is the only double-VAR opcode that stores
+                return true;
+            default:
+                return false;
+            }
+        } else if (this->form == Instruction::Form::EXTENDED) {
+            // let's trap on extended instructions anyway (should never reach here)
+            throw UnsupportedVersionException();
+        }
+        // otherwise...
+        switch (this->category) {
+        case Instruction::Category::_0OP: // 0OP
+            return false; // no 0OP opcodes store in v3 (v5 does have one)
+        case Instruction::Category::_1OP: // 1OP
+            switch (this->opcode) {
+            case 0x01: case 0x02: case 0x03: case 0x04: case 0x0e: case 0x0f:
+                return true;
+            default:
+                return false;
+            }
+        case Instruction::Category::_2OP: // 2OP
+            switch (this->opcode) {
+            case 0x08: case 0x09: case 0x0f: case 0x10: case 0x11: case 0x12:
+            case 0x13: case 0x14: case 0x15: case 0x16: case 0x17: case 0x18:
+                return true;
+            default:
+                return false;
+            }
+        default: // VAR and EXT are handled above
+            throw Exception(); // ERROR! unknown instruction category
+        }
+        return false;
+    }
+
+    bool Instruction::_is_instruction_branch() const {
+        // NOTE: branch opcodes from versions greater than v3 ignored
+        // also extended form, but we're not handling those right now
+        if (this->category == Instruction::Category::VAR) {
+            return false; // There are NO branching VAR instructions in v3!
+        } else if (this->form == Instruction::Form::EXTENDED) {
+            // let's trap on extended instructions anyway (should never reach here)
+            throw UnsupportedVersionException();
+        }
+        // otherwise...
+        switch (this->category) {
+        case Instruction::Category::_0OP: // 0OP
+            switch (this->opcode) {
+            case 0x05: case 0x06: case 0x0d:
+                return true;
+            default:
+                return false;
+            }
+        case Instruction::Category::_1OP: // 1OP
+            return this->opcode < 3; // 0, 1 and 2 all branch
+        case Instruction::Category::_2OP: // 2OP
+            return
+                (0 < this->opcode and this->opcode < 8)
+                or this->opcode == 0x0a;
+        default: // VAR and EXT are handled above
+            throw Exception(); // ERROR! unknown instruction category
+        }
+        return false;
+    }
+
+    void Instruction::_handle_branch(
+        Address& pc,
+        std::span<const Byte> memory_view,
+        Instruction& instruction
+    ) {
+        // decode branch address and store in branch_offset
+        Byte branch = Instruction::_next_byte(pc, memory_view);
+        instruction.has_branch = true;
+        instruction.branch = Instruction::Branch{
+            .on_true = (branch & 0b10000000) != 0,
+            .offset = 0,
+        };
+        // bit 6 of the first branch byte is set if the offset value is 1 byte only
+        if ((branch & 0b01000000) != 0) { // it's a 1-byte branch
+            // use bottom 6 bits for offset
+            instruction.branch.offset = branch & 0b00111111;
+        } else { // it's a 2-byte branch
+            // use bottom 6 bits of first byte and all 8 of the second
+            instruction.branch.offset = ((Word)(branch & 0b00111111) << 8) + Instruction::_next_byte(pc, memory_view);
+        }
+    }
+
+    bool Instruction::_has_string_literal() const {
+        if (this->category == Instruction::Category::_0OP) {
+            if (this->opcode == 2 or this->opcode == 3) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Instruction::_handle_string_literal(
+        Address& pc,
+        std::span<const Byte> memory_view,
+        Instruction& instruction
+    ) {
+        // the Z-char string starts here, the rest of the instruction is never longer than a Byte can count
+        instruction.literal_offset = (Byte)(pc - instruction.location);
+        // Z-characters are encoded in 2-byte chunks, the string ends with a chunk whose first byte has its highest bit set
+        while ((Instruction::_next_byte(pc, memory_view) & 0b10000000) == 0) {
+            pc++;
+        }
+        // the second byte of the last chunk
+        Instruction::_next_byte(pc, memory_view);
+    }
+
+    std::string Instruction::_address_string() const {
+        std::stringstream address;
+        address << std::hex << std::setw(6) << this->location;
+        return address.str();
+    }
+
+    std::string Instruction::_get_2op_name() const {
+        switch (opcode) {
+        case 0x01: return "je";
+        case 0x02: return "jl";
+        case 0x03: return "jg";
+        case 0x04: return "dec_chk";
+        case 0x05: return "inc_chk";
+        case 0x06: return "jin";
+        case 0x07: return "test";
+        case 0x08: return "or";
+        case 0x09: return "and";
+        case 0x0a: return "test_attr";
+        case 0x0b: return "set_attr";
+        case 0x0c: return "clear_attr";
+        case 0x0d: return "store";
+        case 0x0e: return "insert_obj";
+        case 0x0f: return "loadw";
+        case 0x10: return "loadb";
+        case 0x11: return "get_prop";
+        case 0x12: return "get_prop_addr";
+        case 0x13: return "get_next_prop";
+        case 0x14: return "add";
+        case 0x15: return "sub";
+        case 0x16: return "mul";
+        case 0x17: return "div";
+        case 0x18: return "mod";
+        default: return "mnemonic?";
+        }
+    }
+
+    std::string Instruction::_get_1op_name() const {
+        switch (opcode) {
+        case 0x0: return "jz";
+        case 0x1: return "get_sibling";
+        case 0x2: return "get_child";
+        case 0x3: return "get_parent";
+        case 0x4: return "get_prop_len";
+        case 0x5: return "inc";
+        case 0x6: return "dec";
+        case 0x7: return "print_addr";
+        case 0x9: return "remove_obj";
+        case 0xa: return "print_obj";
+        case 0xb: return "ret";
+        case 0xc: return "jump";
+        case 0xd: return "print_paddr";
+        case 0xe: return "load";
+        case 0xf: return "not";
+        default: return "mnemonic?";
+        }
+    }
+
+    std::string Instruction::_get_0op_name() const {
+        switch (opcode) {
+        case 0x0: return "rtrue";
+        case 0x1: return "rfalse";
+        case 0x2: return "print";
+        case 0x3: return "print_ret";
+        case 0x4: return "nop";
+        case 0x5: return "save";
+        case 0x6: return "restore";
+        case 0x7: return "restart";
+        case 0x8: return "ret_popped";
+        case 0x9: return "pop";
+        case 0xa: return "quit";
+        case 0xb: return "new_line";
+        case 0xc: return "show_status";
+        case 0xd: return "verify";
+        default: return "mnemonic?";
+        }
+    }
+
+    std::string Instruction::_get_var_name() const {
+        switch (opcode) {
+        case 0x00: return "call";
+        case 0x01: return "storew";
+        case 0x02: return "storeb";
+        case 0x03: return "put_prop";
+        case 0x04: return "sread";
+        case 0x05: return "print_char";
+        case 0x06: return "print_num";
+        case 0x07: return "random";
+        case 0x08: return "push";
+        case 0x09: return "pull";
+        case 0x0a: return "split_window";
+        case 0x0b: return "set_window";
+        case 0x13: return "output_stream";
+        case 0x14: return "input_stream";
+        case 0x15: return "sound_effect"; // V3 too, though only The Lurking Horror uses it
+        default: return "mnemonic?";
+        }
+    }
+
+    std::string Instruction::_get_ext_name() const {
+        return "EXT";
+    }
+
+    std::string Instruction::_mnemonic_string() const {
+        switch (category) {
+        case Category::_0OP:
+            return _get_0op_name();
+        case Category::_1OP:
+            return _get_1op_name();
+        case Category::_2OP:
+            return _get_2op_name();
+        case Category::VAR:
+            return _get_var_name();
+        case Category::EXT:
+            return _get_ext_name();
+        default:
+            return "op-count?";
+        }
+    }
+
+    std::string Instruction::_arguments_string(const Metadata& metadata) const {
+        std::stringstream arguments;
+        if (operand_count > 0) {
+            arguments << " ";
+        }
+        for (std::size_t i = 0; i < operand_count; i++) {
+            if (metadata.operand_types[i] != OperandType::VARIABLE) {
+                arguments << "#";
+            }
+            arguments << std::hex;
+            if (metadata.operand_types[i] == OperandType::LARGE_CONSTANT) {
+                arguments << std::setfill('0') << std::setw(4);
+            } else {
+                arguments << std::setfill('0') << std::setw(2);
+            }
+            arguments << operands[i];
+            if (i < operand_count - 1u) {
+                arguments << ",";
+            }
+        }
+        return arguments.str();
+    }
+
+    std::string Instruction::_literal_string(std::span<const Byte> memory_view) const {
+        if (literal_offset == 0) { return ""; }
+        std::stringstream str;
+        str << " \"";
+        str << ZStringDecoder(ZVersion::V3).decode(trailing_string_literal(memory_view));
+        str << "\"";
+        return str.str();
+    }
+
+    std::string Instruction::_store_string() const {
+        if (not has_store) { return ""; }
+        std::stringstream store;
+        store << " -> " << std::hex << std::setfill('0') << std::setw(2) << (Word)store_variable;
+        return store.str();
+    }
+
+    std::string Instruction::_branch_string() const {
+        if (not has_branch) { return ""; }
+        std::stringstream jump;
+        jump << " ?" << (branch.on_true ? " " : "! ");
+        jump << branch.offset;
+        return jump.str();
+    }
+
+    std::string Instruction::bytecode_string(const Metadata& metadata) const {
+        std::stringstream bytes;
+        for (std::size_t i = 0; i < metadata.bytecode.size(); i++) {
+            if (i != 0) {
+                bytes << " ";
+            }
+            bytes << std::hex << std::setfill('0') << std::setw(2) << (Word)metadata.bytecode[i];
+        }
+        return bytes.str();
+    }
+
+    std::string Instruction::_metadata() const {
+        std::stringstream data;
+        switch (form) {
+        case Form::LONG:
+            data << "long";
+            break;
+        case Form::SHORT:
+            data << "short";
+            break;
+        case Form::EXTENDED:
+            data << "extended";
+            break;
+        case Form::VARIABLE:
+            data << "variable";
+            break;
+        default:
+            data << "????";
+        }
+        // data << " " << bytecode_string(metadata);
+        return data.str();
+    }
+
+    // NOTE: modifies pc in-place!
+    Instruction Instruction::decode(Address& pc, std::span<const Byte> memory_view) {
+        Instruction instruction = {};
+        // operand types are only needed while decoding, the interpreter only cares which operands are variables
+        std::array<Instruction::OperandType, Instruction::MAX_OPERANDS> operand_types;
+        // store instruction origin address
+        instruction.location = pc;
+        // determines form, category, operand types and number of the opcode
+        Instruction::_determine_opcode_type(pc, memory_view, instruction, operand_types);
+        // now we can read in the actual operand values
+        Instruction::_read_in_operand_values(pc, memory_view, instruction, operand_types);
+        // handle store if this instruction stores a result
+        if (instruction._is_instruction_store()) {
+            instruction.has_store = true;
+            instruction.store_variable = Instruction::_next_byte(pc, memory_view);
+        }
+        // handle branch if this instruction is branching
+        if (instruction._is_instruction_branch()) {
+            Instruction::_handle_branch(pc, memory_view, instruction);
+        }
+        // as a special case, instructions *print* and *print_ret* have a literal string following them, which we need to skip
+        if (instruction._has_string_literal()) {
+            Instruction::_handle_string_literal(pc, memory_view, instruction);
+        }
+        instruction.length = (Word)(pc - instruction.location);
+        return instruction;
+    }
+
+    Instruction::Metadata Instruction::metadata(std::span<const Byte> memory_view) const {
+        Metadata metadata = {};
+        // the operand types are cheap enough to recover by decoding the start of the instruction again
+        Address pc = this->location;
+        Instruction scratch = {};
+        Instruction::_determine_opcode_type(pc, memory_view, scratch, metadata.operand_types);
+        metadata.bytecode = memory_view.subspan(this->location, this->length);
+        return metadata;
+    }
+
+    std::span<const Byte> Instruction::trailing_string_literal(std::span<const Byte> memory_view) const {
+        if (this->literal_offset == 0) {
+            return {};
+        }
+        return memory_view.subspan(
+            this->location + this->literal_offset,
+            this->length - this->literal_offset
+        );
+    }
+
+    std::string Instruction::to_string(std::span<const Byte> memory_view) const {
+        Metadata metadata = this->metadata(memory_view);
+        return
+            _address_string() + ": @" + _mnemonic_string() +
+            _arguments_string(metadata) + _literal_string(memory_view) +
+            _store_string() + _branch_string() + "; " + _metadata();
+    }
+}
@@ -0,0 +1,147 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_INSTRUCTION_HPP
+#define COM_SAXBOPHONE_ZENCH_INSTRUCTION_HPP
+
+#include <array>       // array
+#include <cstddef>     // size_t
+#include <span>        // span
+#include <string>      // string
+#include <type_traits> // is_trivially_copyable
+
+#include <zench/zench.hpp>
+
+namespace com::saxbophone::zench {
+    /*
+     * A decoded instruction.
+     * This is what the interpreter executes, so it's kept small and trivially
+     * copyable and decoding one never allocates. Anything only needed for
+     * disassembly is recovered from memory on demand with metadata().
+     */
+    struct Instruction {
+    public:
+        // double-VAR opcodes take up to 8 operands, everything else up to 4
+        static constexpr std::size_t MAX_OPERANDS = 8;
+
+        // NOTE: modifies pc in-place!
+        static Instruction decode(Address& pc, std::span<const Byte> memory_view);
+
+        using Opcode = Byte; // NOTE: only unique within a Category, so not an enum
+        enum OperandType : Byte {
+            LARGE_CONSTANT = 0b00,
+            SMALL_CONSTANT = 0b01,
+            VARIABLE = 0b10,
+            OMITTED = 0b11,
+        };
+
+        enum class Form : Byte {
+            LONG, SHORT, EXTENDED, VARIABLE,
+        };
+
+        enum class Category : Byte {
+            _0OP, _1OP, _2OP, VAR, EXT,
+        };
+
+        struct Branch {
+            bool on_true; // whether branch is on true (otherwise, on false)
+            SWord offset : 14; // branch offset
+        };
+
+        // strictly metadata fields for assembly output
+        struct Metadata {
+            std::array<OperandType, MAX_OPERANDS> operand_types;
+            std::span<const Byte> bytecode; // the raw bytes that encode this instruction
+        };
+
+        // NOTE: memory_view must be the same memory this instruction was decoded from
+        Metadata metadata(std::span<const Byte> memory_view) const;
+
+        std::string to_string(std::span<const Byte> memory_view) const;
+
+        // whether the given operand names a variable (otherwise, it's a constant)
+        constexpr bool is_variable(std::size_t operand) const {
+            return (this->variable_operands >> operand) & 1u;
+        }
+
+        // address of the byte following this instruction
+        constexpr Address end() const {
+            return this->location + this->length;
+        }
+
+        // the Z-chars of the string literal following print and print_ret, empty for all others
+        std::span<const Byte> trailing_string_literal(std::span<const Byte> memory_view) const;
+
+        Address location; // address of the first byte of this instruction
+        Word length; // number of bytes encoding this instruction, including any string literal
+        std::array<Word, MAX_OPERANDS> operands; // values of constant operands, or numbers of variable ones
+        Opcode opcode;
+        Byte opcode_byte; // the whole first byte, which identifies the opcode without needing form or category
+        Form form; // form specifies the structure of an instruction
+        Category category; // categories are rather misleadingly named after their operand counts, a trait that doesn't quite hold true
+        Byte operand_count;
+        Byte variable_operands; // bit n is set if operand n is a variable
+        bool has_store;
+        Byte store_variable;
+        bool has_branch;
+        Byte literal_offset; // offset from location of the trailing string literal, 0 if there isn't one
+        Branch branch;
+    private:
+        // reads the byte at pc and advances past it, throwing if it's beyond the end of memory
+        static Byte _next_byte(Address& pc, std::span<const Byte> memory_view);
+        static void _determine_opcode_type(
+            Address& pc,
+            std::span<const Byte> memory_view,
+            Instruction& instruction,
+            std::array<OperandType, MAX_OPERANDS>& operand_types
+        );
+        static void _read_in_operand_values(
+            Address& pc,
+            std::span<const Byte> memory_view,
+            Instruction& instruction,
+            const std::array<OperandType, MAX_OPERANDS>& operand_types
+        );
+        bool _is_instruction_store() const;
+        bool _is_instruction_branch() const;
+        static void _handle_branch(
+            Address& pc,
+            std::span<const Byte> memory_view,
+            Instruction& instruction
+        );
+        bool _has_string_literal() const;
+        static void _handle_string_literal(
+            Address& pc,
+            std::span<const Byte> memory_view,
+            Instruction& instruction
+        );
+        std::string _address_string() const;
+        std::string _get_2op_name() const;
+        std::string _get_1op_name() const;
+        std::string _get_0op_name() const;
+        std::string _get_var_name() const;
+        std::string _get_ext_name() const;
+        std::string _mnemonic_string() const;
+        std::string _arguments_string(const Metadata& metadata) const;
+        std::string _literal_string(std::span<const Byte> memory_view) const;
+        std::string _store_string() const;
+        std::string _branch_string() const;
+        std::string bytecode_string(const Metadata& metadata) const;
+        std::string _metadata() const;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Instruction>);
+    static_assert(sizeof(Instruction) <= 64, "Instruction should fit in a cache line");
+}
+
+#endif // include guard
@@ -0,0 +1,89 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>         // size_t
+
+#include <span>            // span
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+#include "ObjectTable.hpp"
+
+namespace {
+    // the property defaults table comes first, one Word for each property
+    constexpr std::size_t DEFAULTS_SIZE = 2 * 31;
+    // each entry holds 4 bytes of attributes, the parent, sibling and child, then the property table address
+    constexpr std::size_t ENTRY_SIZE = 9;
+}
+
+namespace com::saxbophone::zench {
+    ObjectTable::ObjectTable(std::span<const Byte> memory, ByteAddress address)
+      : _memory(memory)
+      , _address(address)
+      {}
+
+    Word ObjectTable::parent(Word object) const {
+        return this->_load_byte(this->_entry(object) + 4);
+    }
+
+    Word ObjectTable::sibling(Word object) const {
+        return this->_load_byte(this->_entry(object) + 5);
+    }
+
+    Word ObjectTable::child(Word object) const {
+        return this->_load_byte(this->_entry(object) + 6);
+    }
+
+    bool ObjectTable::attribute(Word object, Word attribute) const {
+        if (attribute > MAX_ATTRIBUTE) {
+            throw Exception(); // ERROR! no such attribute
+        }
+        // attribute 0 is the top bit of the first byte
+        Byte flags = this->_load_byte(this->_entry(object) + attribute / 8u);
+        return (flags & (0x80u >> attribute % 8u)) != 0;
+    }
+
+    Word ObjectTable::property_default(Word property) const {
+        if (property == 0 or property > MAX_PROPERTY) {
+            throw Exception(); // ERROR! no such property
+        }
+        return this->_load_word(this->_address + 2u * (property - 1u));
+    }
+
+    void ObjectTable::invalidate() {
+        this->_generation++;
+    }
+
+    void ObjectTable::rebind(std::span<const Byte> memory) {
+        this->_memory = memory;
+    }
+
+    Address ObjectTable::_entry(Word object) const {
+        if (object == 0 or object > MAX_OBJECT) {
+            throw Exception(); // ERROR! no such object
+        }
+        return (Address)(this->_address + DEFAULTS_SIZE + ENTRY_SIZE * (object - 1u));
+    }
+
+    Byte ObjectTable::_load_byte(Address address) const {
+        if (address >= this->_memory.size()) {
+            throw Exception(); // ERROR! object table runs off the end of memory
+        }
+        return this->_memory[address];
+    }
+
+    Word ObjectTable::_load_word(Address address) const {
+        return (Word)(this->_load_byte(address) << 8 | this->_load_byte(address + 1));
+    }
+}
@@ -0,0 +1,128 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_OBJECT_TABLE_HPP
+#define COM_SAXBOPHONE_ZENCH_OBJECT_TABLE_HPP
+
+#include <cstddef>         // size_t
+#include <cstdint>         // uint32_t
+
+#include <array>           // array
+#include <span>            // span
+#include <vector>          // vector
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+namespace com::saxbophone::zench {
+    /*
+     * The object tree of a V1-3 story, with the layout of each object's
+     * property list cached once it has been decoded, so that finding any
+     * property takes constant time.
+     *
+     * NOTE: the cached layouts are only correct for as long as the bytes they
+     * were decoded from are unchanged, so whoever writes to memory must call
+     * invalidate() when any of those bytes are written to.
+     */
+    class ObjectTable {
+    public:
+        // V1-3 have up to 255 objects and 31 properties, numbered from 1
+        static constexpr Word MAX_OBJECT = 255;
+        static constexpr Word MAX_PROPERTY = 31;
+        static constexpr Word MAX_ATTRIBUTE = 31;
+
+        struct Property {
+            ByteAddress data = 0; // 0 if the object doesn't have this property
+            Byte length = 0;
+            Byte next = 0; // the number of the property after this one in the list, 0 if none
+        };
+        // indexed by property number --the next of entry 0 is the first property in the list
+        using Properties = std::array<Property, MAX_PROPERTY + 1>;
+
+        ObjectTable() = default;
+        // memory must hold the object table and all of the property tables
+        ObjectTable(std::span<const Byte> memory, ByteAddress address);
+        // these all throw Exception if there's no such object or attribute
+        Word parent(Word object) const;
+        Word sibling(Word object) const;
+        Word child(Word object) const;
+        bool attribute(Word object, Word attribute) const;
+        // the value of a property which an object doesn't have
+        Word property_default(Word property) const;
+        /*
+         * The layout of an object's property list, decoded on first use and
+         * cached until invalidate(). Each byte the layout is decoded from is
+         * passed to watch(address).
+         */
+        template <typename Watch>
+        const Properties& properties(Word object, Watch watch) {
+            Address entry = this->_entry(object);
+            if (object >= this->_cache.size()) {
+                this->_cache.resize(object + 1u);
+            }
+            Cached& cached = this->_cache[object];
+            if (cached.generation == this->_generation) {
+                return cached.properties;
+            }
+            cached.properties = {};
+            // the address of the property table is the last Word of the object's entry
+            watch(entry + 7);
+            watch(entry + 8);
+            Address address = this->_load_word(entry + 7);
+            // skip over the short name, whose length in Words comes first
+            watch(address);
+            address += 1u + 2u * this->_load_byte(address);
+            Byte previous = 0;
+            while (true) {
+                watch(address);
+                Byte size = this->_load_byte(address);
+                if (size == 0) {
+                    break;
+                }
+                Byte number = size & 0b11111;
+                Byte length = (Byte)((size >> 5) + 1);
+                // a property listed twice is found at its first entry, as if searching
+                if (number != 0 and cached.properties[number].data == 0) {
+                    cached.properties[number].data = (ByteAddress)(address + 1);
+                    cached.properties[number].length = length;
+                    cached.properties[previous].next = number;
+                    previous = number;
+                }
+                address += 1u + length;
+            }
+            cached.generation = this->_generation;
+            return cached.properties;
+        }
+        // forgets every cached layout
+        void invalidate();
+        // memory has moved without changing, so cached layouts are kept
+        void rebind(std::span<const Byte> memory);
+    private:
+        struct Cached {
+            std::uint32_t generation = 0; // layout is only valid if this matches _generation
+            Properties properties;
+        };
+
+        // the address of an object's entry in the table
+        Address _entry(Word object) const;
+        Byte _load_byte(Address address) const;
+        Word _load_word(Address address) const;
+
+        std::span<const Byte> _memory;
+        ByteAddress _address = 0;
+        std::uint32_t _generation = 1;
+        std::vector<Cached> _cache; // indexed by object
+    };
+}
+
+#endif // include guard
@@ -0,0 +1,42 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_OPCODES_HPP
+#define COM_SAXBOPHONE_ZENCH_OPCODES_HPP
+
+/*
+ * Lists every opcode handler implemented by ZMachineImpl, as an "X-macro".
+ * Each entry X(name) corresponds to a method ZMachineImpl::_opcode_name(),
+ * from which the handler declarations, the Handler enum, the dispatch tables
+ * and the labels of the threaded dispatch engine are all generated, so that
+ * they can't fall out of step with one another.
+ * NOTE: entries are named after the opcode mnemonics where possible.
+ */
+#define ZENCH_OPCODES(X) \
+    /* placeholder for any opcode we don't implement (yet) */ \
+    X(unimplemented) \
+    /* 2OP */ \
+    X(je) X(jl) X(jg) X(dec_chk) X(inc_chk) X(test) X(or) X(and) X(test_attr) X(store) \
+    X(loadw) X(loadb) X(get_prop) X(get_prop_addr) X(get_next_prop) X(add) X(sub) X(mul) X(div) X(mod) \
+    /* 1OP */ \
+    X(jz) X(get_sibling) X(get_child) X(get_parent) X(get_prop_len) X(inc) X(dec) X(print_addr) X(ret) \
+    X(jump) X(print_paddr) X(load) X(not) \
+    /* 0OP */ \
+    X(rtrue) X(rfalse) X(print) X(print_ret) X(nop) X(save) X(restore) X(ret_popped) X(pop) X(quit) \
+    X(new_line) \
+    /* VAR */ \
+    X(call) X(storew) X(storeb) X(sread) X(print_char) X(print_num) X(push) X(pull) \
+    X(output_stream)
+
+#endif // include guard
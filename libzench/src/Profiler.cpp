@@ -0,0 +1,82 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>         // size_t
+#include <cstdint>         // uint64_t
+
+#include <charconv>        // to_chars
+#include <iterator>        // begin, end
+#include <string>          // string, to_string
+
+#include <zench/zench.hpp>
+
+#include "Profiler.hpp"
+#include "Stack.hpp"
+
+namespace com::saxbophone::zench {
+    Profiler::Profiler(std::size_t interval)
+      : _interval(interval < 1 ? 1 : interval)
+      , _until_sample(this->_interval)
+      {}
+
+    std::size_t Profiler::interval() const {
+        return this->_interval;
+    }
+
+    std::size_t Profiler::until_sample() const {
+        return this->_until_sample;
+    }
+
+    bool Profiler::advance(std::size_t executed) {
+        if (executed < this->_until_sample) {
+            this->_until_sample -= executed;
+            return false;
+        }
+        // instructions beyond the one due to be sampled count towards the next
+        this->_until_sample = this->_interval - (executed - this->_until_sample) % this->_interval;
+        return true;
+    }
+
+    void Profiler::sample(const Stack& stack) {
+        stack.routines(this->_routines);
+        this->_stacks[this->_routines]++;
+        this->_samples++;
+    }
+
+    std::uint64_t Profiler::samples() const {
+        return this->_samples;
+    }
+
+    std::string Profiler::folded() const {
+        std::string folded;
+        for (const auto& [routines, count] : this->_stacks) {
+            folded += "main";
+            // the first is always the entrypoint
+            for (std::size_t r = 1; r < routines.size(); r++) {
+                if (routines[r] == 0) {
+                    folded += ";?";
+                    continue;
+                }
+                char digits[8];
+                auto [end, error] = std::to_chars(std::begin(digits), std::end(digits), routines[r], 16);
+                folded += ";0x";
+                folded.append(digits, end);
+            }
+            folded += ' ';
+            folded += std::to_string(count);
+            folded += '\n';
+        }
+        return folded;
+    }
+}
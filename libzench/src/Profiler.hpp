@@ -0,0 +1,71 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_PROFILER_HPP
+#define COM_SAXBOPHONE_ZENCH_PROFILER_HPP
+
+#include <cstddef>         // size_t
+#include <cstdint>         // uint64_t
+
+#include <map>             // map
+#include <string>          // string
+#include <vector>          // vector
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+#include "Stack.hpp"
+
+namespace com::saxbophone::zench {
+    /*
+     * Samples the Z-code call stack once every so many instructions, counting
+     * how often each distinct chain of routines is seen, so that the story's
+     * hot routines can be found with flame graph tools.
+     *
+     * The profiler doesn't count instructions itself: whoever runs them tells
+     * it how many with advance(), typically by running no more than
+     * until_sample() at a time, so it costs nothing between samples.
+     */
+    class Profiler {
+    public:
+        // interval is in instructions, and at least 1
+        Profiler(std::size_t interval);
+        std::size_t interval() const;
+        // instructions left to execute before the next sample is due
+        std::size_t until_sample() const;
+        // counts instructions executed, returning true if a sample is now due
+        bool advance(std::size_t executed);
+        // takes a sample of the routines on the stack
+        void sample(const Stack& stack);
+        // number of samples taken
+        std::uint64_t samples() const;
+        /*
+         * The samples in folded-stack format: one line for each distinct call
+         * stack, naming its routines from outermost to innermost separated by
+         * semicolons, followed by a space and the number of samples of it.
+         * The entrypoint is "main" and the rest are routine addresses in hex,
+         * or "?" where not known.
+         */
+        std::string folded() const;
+    private:
+        std::size_t _interval;
+        std::size_t _until_sample;
+        std::uint64_t _samples = 0;
+        // the number of samples of each call stack, outermost routine first
+        std::map<std::vector<Address>, std::uint64_t> _stacks;
+        // the stack being sampled, kept to avoid allocating
+        std::vector<Address> _routines;
+    };
+}
+
+#endif // include guard
@@ -0,0 +1,348 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>              // size_t
+#include <cstdint>              // uint32_t, uint64_t
+#include <cstring>              // memcmp, memcpy
+
+#include <algorithm>            // copy, min
+#include <bit>                  // popcount
+#include <optional>             // optional
+#include <span>                 // span
+#include <string_view>          // string_view
+#include <vector>               // vector
+
+#if defined(__SSE2__)
+#include <emmintrin.h>          // SSE2 intrinsics
+#endif
+
+#include <zench/FileSystem.hpp>
+#include <zench/zench.hpp>      // base library definitions of core types
+
+#include "Quetzal.hpp"
+#include "Stack.hpp"
+
+namespace {
+    using namespace com::saxbophone::zench;
+
+    constexpr std::size_t IFHD_SIZE = 13;
+    // far bigger than any saved game for a V1-3 story can be, so that we don't try to read in anything silly
+    constexpr std::size_t MAX_SAVED_GAME_SIZE = 16 * 1024 * 1024;
+    constexpr std::size_t FRAME_HEADER_SIZE = 8; // size of a Stks frame, before its locals and evaluation stack
+
+    // IFF stores everything big-endian
+    void put_word(std::vector<Byte>& out, Word value) {
+        out.push_back((Byte)(value >> 8));
+        out.push_back((Byte)value);
+    }
+
+    void put_address(std::vector<Byte>& out, Address value) {
+        out.push_back((Byte)(value >> 16));
+        out.push_back((Byte)(value >> 8));
+        out.push_back((Byte)value);
+    }
+
+    void put_length(std::vector<Byte>& out, std::size_t at, std::size_t length) {
+        out[at] = (Byte)(length >> 24);
+        out[at + 1] = (Byte)(length >> 16);
+        out[at + 2] = (Byte)(length >> 8);
+        out[at + 3] = (Byte)length;
+    }
+
+    Word get_word(std::span<const Byte> in, std::size_t at) {
+        return (Word)(in[at] << 8 | in[at + 1]);
+    }
+
+    Address get_address(std::span<const Byte> in, std::size_t at) {
+        return (Address)(in[at] << 16 | in[at + 1] << 8 | in[at + 2]);
+    }
+
+    std::size_t get_length(std::span<const Byte> in, std::size_t at) {
+        return (std::size_t)in[at] << 24 | (std::size_t)in[at + 1] << 16 | (std::size_t)in[at + 2] << 8 | in[at + 3];
+    }
+
+    bool is_id(std::span<const Byte> in, std::size_t at, std::string_view id) {
+        return std::memcmp(&in[at], id.data(), 4) == 0;
+    }
+
+    // starts a chunk, returning where its length goes so that it can be filled in by end_chunk()
+    std::size_t begin_chunk(std::vector<Byte>& out, std::string_view id) {
+        out.insert(out.end(), id.begin(), id.end());
+        std::size_t length_at = out.size();
+        out.resize(out.size() + 4);
+        return length_at;
+    }
+
+    void end_chunk(std::vector<Byte>& out, std::size_t length_at) {
+        std::size_t length = out.size() - length_at - 4;
+        put_length(out, length_at, length);
+        // chunks are padded to an even length, the pad byte isn't counted in the length
+        if (length % 2 != 0) {
+            out.push_back(0);
+        }
+    }
+
+    // the IFhd chunk identifies the story that a saved game belongs to
+    void put_ifhd(std::vector<Byte>& out, std::span<const Byte> story, Address pc) {
+        std::size_t length_at = begin_chunk(out, "IFhd");
+        out.insert(out.end(), story.begin() + 0x02, story.begin() + 0x04); // release number
+        out.insert(out.end(), story.begin() + 0x12, story.begin() + 0x18); // serial number
+        out.insert(out.end(), story.begin() + 0x1c, story.begin() + 0x1e); // checksum
+        put_address(out, pc);
+        end_chunk(out, length_at);
+    }
+
+    void put_stks(std::vector<Byte>& out, const Stack& stack) {
+        std::size_t length_at = begin_chunk(out, "Stks");
+        for (const Stack::Frame& frame : stack.frames()) {
+            put_address(out, frame.return_pc);
+            out.push_back((Byte)frame.locals.size()); // flags --we never discard results in V1-3
+            out.push_back(frame.result_ref);
+            out.push_back((Byte)((1u << frame.argument_count) - 1u)); // one bit per argument supplied
+            put_word(out, (Word)frame.evaluation_stack.size());
+            for (Word local : frame.locals) {
+                put_word(out, local);
+            }
+            for (Word value : frame.evaluation_stack) {
+                put_word(out, value);
+            }
+        }
+        end_chunk(out, length_at);
+    }
+
+    // returns false if stks is malformed or doesn't fit in stack
+    bool get_stks(std::span<const Byte> stks, Stack& stack) {
+        std::size_t cursor = 0;
+        bool first = true;
+        try {
+            while (cursor < stks.size()) {
+                if (stks.size() - cursor < FRAME_HEADER_SIZE) {
+                    return false;
+                }
+                Address return_pc = get_address(stks, cursor);
+                Byte flags = stks[cursor + 3];
+                Byte result_ref = stks[cursor + 4];
+                Byte arguments = stks[cursor + 5];
+                std::size_t locals_count = flags & 0x0f;
+                std::size_t evaluation_count = get_word(stks, cursor + 6);
+                cursor += FRAME_HEADER_SIZE;
+                if (stks.size() - cursor < 2u * (locals_count + evaluation_count)) {
+                    return false;
+                }
+                if (first) {
+                    // the dummy entrypoint frame has no locals and is already on the stack
+                    if (locals_count != 0) {
+                        return false;
+                    }
+                    first = false;
+                } else {
+                    // V1-3 has no way of calling a routine and discarding its result
+                    if ((flags & 0x10) != 0) {
+                        return false;
+                    }
+                    stack.push_frame(return_pc, result_ref, (std::size_t)std::popcount(arguments), locals_count);
+                    for (std::size_t l = 0; l < locals_count; l++) {
+                        stack.local((Byte)(l + 1u)) = get_word(stks, cursor + 2u * l);
+                    }
+                }
+                cursor += 2u * locals_count;
+                for (std::size_t e = 0; e < evaluation_count; e++) {
+                    stack.push(get_word(stks, cursor + 2u * e));
+                }
+                cursor += 2u * evaluation_count;
+            }
+        } catch (const StackOverflowException&) {
+            return false;
+        }
+        return not first;
+    }
+
+    // appends a run of count zero bytes to CMem, each encoded as a zero followed by a count of up to 255 more
+    void put_zero_run(std::vector<Byte>& out, std::size_t count) {
+        while (count > 0) {
+            std::size_t run = std::min(count, (std::size_t)256);
+            out.push_back(0);
+            out.push_back((Byte)(run - 1u));
+            count -= run;
+        }
+    }
+}
+
+namespace com::saxbophone::zench {
+    void Quetzal::encode_cmem(std::span<const Byte> memory, std::span<const Byte> original, std::vector<Byte>& out) {
+        std::size_t size = memory.size();
+        std::size_t zeroes = 0; // length of the run of unchanged bytes not yet written
+        std::size_t i = 0;
+        // adds the XOR difference of a single byte
+        auto put_difference = [&](std::size_t at) {
+            Byte difference = memory[at] ^ original[at];
+            if (difference == 0) {
+                zeroes++;
+            } else {
+                put_zero_run(out, zeroes);
+                zeroes = 0;
+                out.push_back(difference);
+            }
+        };
+        /*
+         * Most of dynamic memory is usually unchanged, so we compare it in
+         * blocks first and only need to look at individual bytes within the
+         * blocks which differ.
+         */
+#if defined(__SSE2__)
+        constexpr std::size_t BLOCK = 16;
+        for (; i + BLOCK <= size; i += BLOCK) {
+            __m128i a = _mm_loadu_si128((const __m128i*)&memory[i]);
+            __m128i b = _mm_loadu_si128((const __m128i*)&original[i]);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xffff) {
+                zeroes += BLOCK;
+                continue;
+            }
+            for (std::size_t j = i; j < i + BLOCK; j++) {
+                put_difference(j);
+            }
+        }
+#else
+        constexpr std::size_t BLOCK = sizeof(std::uint64_t);
+        for (; i + BLOCK <= size; i += BLOCK) {
+            std::uint64_t a, b;
+            std::memcpy(&a, &memory[i], BLOCK);
+            std::memcpy(&b, &original[i], BLOCK);
+            if ((a ^ b) == 0) {
+                zeroes += BLOCK;
+                continue;
+            }
+            for (std::size_t j = i; j < i + BLOCK; j++) {
+                put_difference(j);
+            }
+        }
+#endif
+        for (; i < size; i++) {
+            put_difference(i);
+        }
+        // a trailing run of zeroes is left implicit
+    }
+
+    bool Quetzal::decode_cmem(std::span<const Byte> cmem, std::span<const Byte> original, std::span<Byte> memory) {
+        std::copy(original.begin(), original.end(), memory.begin());
+        std::size_t at = 0;
+        for (std::size_t i = 0; i < cmem.size(); i++) {
+            if (cmem[i] == 0) {
+                // a run of unchanged bytes
+                if (i + 1u == cmem.size()) {
+                    return false;
+                }
+                at += cmem[++i] + 1u;
+                if (at > memory.size()) {
+                    return false;
+                }
+            } else {
+                if (at >= memory.size()) {
+                    return false;
+                }
+                memory[at] = original[at] ^ cmem[i];
+                at++;
+            }
+        }
+        return true;
+    }
+
+    std::vector<Byte> Quetzal::save(
+        std::span<const Byte> story,
+        std::span<const Byte> dynamic_memory,
+        const Stack& stack,
+        Address pc
+    ) {
+        std::vector<Byte> out;
+        std::size_t form_length_at = begin_chunk(out, "FORM");
+        out.insert(out.end(), {'I', 'F', 'Z', 'S'});
+        put_ifhd(out, story, pc);
+        std::size_t length_at = begin_chunk(out, "CMem");
+        encode_cmem(dynamic_memory, story.first(dynamic_memory.size()), out);
+        end_chunk(out, length_at);
+        put_stks(out, stack);
+        put_length(out, form_length_at, out.size() - 8u);
+        return out;
+    }
+
+    std::optional<Quetzal::SavedGame> Quetzal::restore(
+        std::span<const Byte> story,
+        std::span<const Byte> saved_game,
+        std::size_t stack_capacity
+    ) {
+        if (saved_game.size() < 12 or not is_id(saved_game, 0, "FORM") or not is_id(saved_game, 8, "IFZS")) {
+            return std::nullopt;
+        }
+        std::size_t form_end = std::min(saved_game.size(), 8u + get_length(saved_game, 4));
+        std::optional<std::span<const Byte>> ifhd, cmem, umem, stks;
+        for (std::size_t cursor = 12; cursor + 8u <= form_end;) {
+            std::size_t length = get_length(saved_game, cursor + 4);
+            if (length > form_end - cursor - 8u) {
+                return std::nullopt;
+            }
+            std::span<const Byte> data = saved_game.subspan(cursor + 8u, length);
+            if (is_id(saved_game, cursor, "IFhd")) {
+                ifhd = data;
+            } else if (is_id(saved_game, cursor, "CMem")) {
+                cmem = data;
+            } else if (is_id(saved_game, cursor, "UMem")) {
+                umem = data;
+            } else if (is_id(saved_game, cursor, "Stks")) {
+                stks = data;
+            }
+            // other chunks are optional and are skipped
+            cursor += 8u + length + length % 2u;
+        }
+        // the saved game must belong to this story
+        if (
+            not ifhd or ifhd->size() < IFHD_SIZE
+            or not std::equal(ifhd->begin(), ifhd->begin() + 2, story.begin() + 0x02)
+            or not std::equal(ifhd->begin() + 2, ifhd->begin() + 8, story.begin() + 0x12)
+            or not std::equal(ifhd->begin() + 8, ifhd->begin() + 10, story.begin() + 0x1c)
+        ) {
+            return std::nullopt;
+        }
+        std::size_t dynamic_size = get_word(story, 0x0e);
+        SavedGame saved{get_address(*ifhd, 10), std::vector<Byte>(dynamic_size), Stack(stack_capacity)};
+        if (cmem) {
+            if (not decode_cmem(*cmem, story.first(dynamic_size), saved.dynamic_memory)) {
+                return std::nullopt;
+            }
+        } else if (umem and umem->size() == dynamic_size) {
+            std::copy(umem->begin(), umem->end(), saved.dynamic_memory.begin());
+        } else {
+            return std::nullopt;
+        }
+        if (not stks or not get_stks(*stks, saved.stack)) {
+            return std::nullopt;
+        }
+        return saved;
+    }
+
+    std::vector<Byte> Quetzal::read(FileSystem::InputFile& file) {
+        // the length of the FORM tells us how much more to read
+        std::vector<Byte> saved_game(8);
+        if (file.read_into(saved_game) != saved_game.size() or not is_id(saved_game, 0, "FORM")) {
+            return {};
+        }
+        std::size_t length = get_length(saved_game, 4);
+        if (length > MAX_SAVED_GAME_SIZE) {
+            return {};
+        }
+        saved_game.resize(8u + length);
+        std::size_t read = file.read_into(std::span<Byte>{saved_game}.subspan(8));
+        saved_game.resize(8u + read);
+        return saved_game;
+    }
+}
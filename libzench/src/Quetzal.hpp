@@ -0,0 +1,79 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_QUETZAL_HPP
+#define COM_SAXBOPHONE_ZENCH_QUETZAL_HPP
+
+#include <cstddef>              // size_t
+
+#include <optional>             // optional
+#include <span>                 // span
+#include <vector>               // vector
+
+#include <zench/FileSystem.hpp>
+#include <zench/zench.hpp>      // base library definitions of core types
+
+#include "Stack.hpp"
+
+namespace com::saxbophone::zench {
+    /*
+     * Reads and writes saved games in Quetzal, the standard saved game format
+     * for the Z-machine. See: https://inform-fiction.org/zmachine/standards/quetzal/
+     * NOTE: dynamic memory is always saved compressed (as CMem), but either
+     * compressed or uncompressed (UMem) saves can be restored.
+     */
+    class Quetzal {
+    public:
+        // the state of a ZMachine, as read from a saved game
+        struct SavedGame {
+            // in V1-3, the address of the branch data of the save instruction which made this saved game
+            Address pc;
+            std::vector<Byte> dynamic_memory;
+            Stack stack;
+        };
+
+        /*
+         * Appends the CMem encoding of memory to out: memory is XORed against
+         * the original, then runs of zeroes are run-length encoded, since
+         * most of dynamic memory is usually unchanged.
+         */
+        static void encode_cmem(std::span<const Byte> memory, std::span<const Byte> original, std::vector<Byte>& out);
+        /*
+         * Decodes CMem into memory, which must be the same size as original.
+         * Returns false if cmem is malformed.
+         */
+        static bool decode_cmem(std::span<const Byte> cmem, std::span<const Byte> original, std::span<Byte> memory);
+        // produces a complete saved game file
+        static std::vector<Byte> save(
+            std::span<const Byte> story,
+            std::span<const Byte> dynamic_memory,
+            const Stack& stack,
+            Address pc
+        );
+        /*
+         * Reads a saved game for the given story, returning nothing if it's
+         * malformed, was made by a different story or doesn't fit within a
+         * stack of the given capacity.
+         */
+        static std::optional<SavedGame> restore(
+            std::span<const Byte> story,
+            std::span<const Byte> saved_game,
+            std::size_t stack_capacity
+        );
+        // reads a whole saved game from file, returning nothing if it's not a Quetzal file
+        static std::vector<Byte> read(FileSystem::InputFile& file);
+    };
+}
+
+#endif // include guard
@@ -0,0 +1,69 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>  // size_t
+
+#include <atomic>   // memory_order
+#include <bit>      // bit_ceil
+#include <memory>   // make_unique
+#include <optional> // optional
+#include <vector>   // vector
+
+#include <zench/RingKeyboard.hpp>
+
+namespace com::saxbophone::zench {
+    RingKeyboard::RingKeyboard(std::size_t capacity)
+      : _mask(std::bit_ceil(capacity < 1 ? 1 : capacity) - 1)
+      , _slots(std::make_unique<EncodedEvent[]>(this->_mask + 1))
+      {}
+
+    std::size_t RingKeyboard::capacity() const {
+        return this->_mask + 1;
+    }
+
+    bool RingKeyboard::push(Event event) {
+        std::size_t tail = this->_tail.load(std::memory_order_relaxed);
+        if (tail - this->_cached_head == this->capacity()) {
+            // only look at the consumer's index (and its cache line) when the ring seems full
+            this->_cached_head = this->_head.load(std::memory_order_acquire);
+            if (tail - this->_cached_head == this->capacity()) {
+                return false;
+            }
+        }
+        this->_slots[tail & this->_mask] = encode(event);
+        this->_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<Keyboard::Event> RingKeyboard::pop() {
+        std::size_t head = this->_head.load(std::memory_order_relaxed);
+        if (head == this->_cached_tail) {
+            this->_cached_tail = this->_tail.load(std::memory_order_acquire);
+            if (head == this->_cached_tail) {
+                return {};
+            }
+        }
+        Event event = decode(this->_slots[head & this->_mask]);
+        this->_head.store(head + 1, std::memory_order_release);
+        return event;
+    }
+
+    std::vector<Keyboard::Event> RingKeyboard::get_input() {
+        std::vector<Event> events;
+        while (std::optional<Event> event = this->pop()) {
+            events.push_back(*event);
+        }
+        return events;
+    }
+}
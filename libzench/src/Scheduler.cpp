@@ -0,0 +1,304 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>            // size_t
+
+#include <atomic>             // atomic
+#include <condition_variable> // condition_variable
+#include <deque>              // deque
+#include <memory>             // unique_ptr
+#include <mutex>              // lock_guard, mutex, unique_lock
+#include <thread>             // thread
+#include <unordered_map>      // unordered_map
+#include <utility>            // move
+#include <vector>             // vector
+
+#include <zench/Scheduler.hpp>
+#include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+namespace com::saxbophone::zench {
+    class Scheduler::SchedulerImpl {
+    public:
+        SchedulerImpl(std::size_t threads, Callback on_stop, std::size_t time_slice);
+        ~SchedulerImpl();
+        SessionId add(std::unique_ptr<ZMachine> machine);
+        bool notify(SessionId id);
+        std::size_t session_count() const;
+        void wait_until_idle();
+    private:
+        /*
+         * A session is only ever in one queue, or being run by one worker, at
+         * a time. Its state decides who may put it in a queue next.
+         */
+        enum class State {
+            Queued, // in a worker's queue
+            Running, // being run by a worker
+            Notified, // being run by a worker, and input has arrived since it started
+            Parked, // waiting for input, in no queue
+        };
+
+        struct Session {
+            SessionId id;
+            std::unique_ptr<ZMachine> machine;
+            std::atomic<State> state = State::Queued;
+        };
+
+        // the sessions waiting to be run by one worker, which the others can steal from
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<Session*> sessions;
+        };
+
+        // the main loop of each worker thread
+        void _work(std::size_t worker);
+        // runs one time slice of a session and decides what happens to it next
+        void _run(Session& session);
+        /*
+         * Puts a session into a queue --the current worker's, if called from
+         * a worker thread, otherwise each in turn. Sessions which weren't
+         * runnable before (new or parked) count towards being busy. One which
+         * used up its time slice goes to the front, where its worker takes it
+         * last and others steal it first, so that it gives way to the rest.
+         */
+        void _enqueue(Session* session, bool newly_runnable, bool sliced = false);
+        // takes the newest session from the worker's own queue, or else steals the oldest from another
+        Session* _take(std::size_t worker);
+        // a session has stopped being runnable
+        void _became_idle();
+
+        Callback _on_stop;
+        std::size_t _time_slice;
+        std::vector<std::unique_ptr<WorkQueue>> _queues;
+        std::vector<std::thread> _workers;
+        std::atomic<std::size_t> _next_queue = 0;
+
+        // guards _sessions and _next_id
+        mutable std::mutex _sessions_mutex;
+        std::unordered_map<SessionId, std::unique_ptr<Session>> _sessions;
+        SessionId _next_id = 1;
+
+        // guards _queued, _busy and setting _stopping, and is used for sleeping on
+        std::mutex _mutex;
+        std::condition_variable _work_available;
+        std::condition_variable _idle;
+        std::size_t _queued = 0; // sessions in all queues
+        std::size_t _busy = 0; // sessions which are queued or running
+        std::atomic<bool> _stopping = false; // read without the lock between time slices
+    };
+
+    namespace {
+        // which scheduler and worker the current thread belongs to, if any
+        thread_local const void* current_scheduler = nullptr;
+        thread_local std::size_t current_worker = 0;
+    }
+
+    Scheduler::SchedulerImpl::SchedulerImpl(std::size_t threads, Callback on_stop, std::size_t time_slice)
+      : _on_stop(std::move(on_stop))
+      , _time_slice(time_slice)
+      {
+        if (threads == 0 or time_slice == 0) {
+            throw Exception();
+        }
+        for (std::size_t t = 0; t < threads; t++) {
+            this->_queues.push_back(std::make_unique<WorkQueue>());
+        }
+        for (std::size_t t = 0; t < threads; t++) {
+            this->_workers.emplace_back([this, t] { this->_work(t); });
+        }
+      }
+
+    Scheduler::SchedulerImpl::~SchedulerImpl() {
+        {
+            std::lock_guard lock(this->_mutex);
+            this->_stopping = true;
+        }
+        this->_work_available.notify_all();
+        for (auto& worker : this->_workers) {
+            worker.join();
+        }
+    }
+
+    Scheduler::SessionId Scheduler::SchedulerImpl::add(std::unique_ptr<ZMachine> machine) {
+        Session* session;
+        {
+            std::lock_guard lock(this->_sessions_mutex);
+            SessionId id = this->_next_id++;
+            auto added = std::make_unique<Session>(id, std::move(machine));
+            session = added.get();
+            this->_sessions.emplace(id, std::move(added));
+        }
+        SessionId id = session->id; // the session might have finished by the time _enqueue() returns
+        this->_enqueue(session, true);
+        return id;
+    }
+
+    bool Scheduler::SchedulerImpl::notify(SessionId id) {
+        // held throughout so that the session can't finish and be destroyed meanwhile
+        std::lock_guard lock(this->_sessions_mutex);
+        auto found = this->_sessions.find(id);
+        if (found == this->_sessions.end()) {
+            return false;
+        }
+        Session* session = found->second.get();
+        State state = session->state.load();
+        while (true) {
+            if (state == State::Parked) {
+                if (session->state.compare_exchange_weak(state, State::Queued)) {
+                    this->_enqueue(session, true);
+                    return true;
+                }
+            } else if (state == State::Running) {
+                // the worker running it will requeue it rather than park it
+                if (session->state.compare_exchange_weak(state, State::Notified)) {
+                    return true;
+                }
+            } else {
+                // already due to run again
+                return true;
+            }
+        }
+    }
+
+    std::size_t Scheduler::SchedulerImpl::session_count() const {
+        std::lock_guard lock(this->_sessions_mutex);
+        return this->_sessions.size();
+    }
+
+    void Scheduler::SchedulerImpl::wait_until_idle() {
+        std::unique_lock lock(this->_mutex);
+        this->_idle.wait(lock, [this] { return this->_busy == 0; });
+    }
+
+    void Scheduler::SchedulerImpl::_work(std::size_t worker) {
+        current_scheduler = this;
+        current_worker = worker;
+        // checked before every time slice, so that sessions which never stop don't keep the workers going
+        while (not this->_stopping) {
+            if (Session* session = this->_take(worker); session != nullptr) {
+                this->_run(*session);
+                continue;
+            }
+            std::unique_lock lock(this->_mutex);
+            this->_work_available.wait(lock, [this] { return this->_stopping or this->_queued > 0; });
+        }
+    }
+
+    void Scheduler::SchedulerImpl::_run(Session& session) {
+        session.state = State::Running;
+        ZMachine::Status status = session.machine->run(this->_time_slice);
+        if (status == ZMachine::Status::BudgetExhausted) {
+            // give way to the other sessions
+            session.state = State::Queued;
+            return this->_enqueue(&session, false, true);
+        }
+        // called before parking, so that the callback has the session to itself
+        if (this->_on_stop) {
+            this->_on_stop(session.id, *session.machine, status);
+        }
+        if (status == ZMachine::Status::WaitingForInput) {
+            State running = State::Running;
+            if (not session.state.compare_exchange_strong(running, State::Parked)) {
+                // input arrived whilst it was running, so it mustn't wait for another notify()
+                session.state = State::Queued;
+                return this->_enqueue(&session, false);
+            }
+        } else {
+            // finished for good
+            std::lock_guard lock(this->_sessions_mutex);
+            this->_sessions.erase(session.id);
+        }
+        this->_became_idle();
+    }
+
+    void Scheduler::SchedulerImpl::_enqueue(Session* session, bool newly_runnable, bool sliced) {
+        std::size_t queue = current_scheduler == this ?
+            current_worker :
+            this->_next_queue.fetch_add(1, std::memory_order_relaxed) % this->_queues.size();
+        {
+            std::lock_guard lock(this->_queues[queue]->mutex);
+            if (sliced) {
+                this->_queues[queue]->sessions.push_front(session);
+            } else {
+                this->_queues[queue]->sessions.push_back(session);
+            }
+        }
+        {
+            std::lock_guard lock(this->_mutex);
+            this->_queued++;
+            if (newly_runnable) {
+                this->_busy++;
+            }
+        }
+        this->_work_available.notify_one();
+    }
+
+    Scheduler::SchedulerImpl::Session* Scheduler::SchedulerImpl::_take(std::size_t worker) {
+        Session* session = nullptr;
+        for (std::size_t q = 0; q < this->_queues.size() and session == nullptr; q++) {
+            std::size_t victim = (worker + q) % this->_queues.size();
+            WorkQueue& queue = *this->_queues[victim];
+            std::lock_guard lock(queue.mutex);
+            if (queue.sessions.empty()) {
+                continue;
+            }
+            // the newest of our own is most likely still in cache, the oldest of another's has waited longest
+            if (victim == worker) {
+                session = queue.sessions.back();
+                queue.sessions.pop_back();
+            } else {
+                session = queue.sessions.front();
+                queue.sessions.pop_front();
+            }
+        }
+        if (session != nullptr) {
+            std::lock_guard lock(this->_mutex);
+            this->_queued--;
+        }
+        return session;
+    }
+
+    void Scheduler::SchedulerImpl::_became_idle() {
+        bool idle;
+        {
+            std::lock_guard lock(this->_mutex);
+            idle = --this->_busy == 0;
+        }
+        if (idle) {
+            this->_idle.notify_all();
+        }
+    }
+
+    Scheduler::Scheduler(std::size_t threads, Callback on_stop, std::size_t time_slice)
+      : _impl(new SchedulerImpl(threads, std::move(on_stop), time_slice))
+      {}
+
+    Scheduler::~Scheduler() = default;
+
+    Scheduler::SessionId Scheduler::add(std::unique_ptr<ZMachine> machine) {
+        return this->_impl->add(std::move(machine));
+    }
+
+    bool Scheduler::notify(SessionId session) {
+        return this->_impl->notify(session);
+    }
+
+    std::size_t Scheduler::session_count() const {
+        return this->_impl->session_count();
+    }
+
+    void Scheduler::wait_until_idle() {
+        this->_impl->wait_until_idle();
+    }
+}
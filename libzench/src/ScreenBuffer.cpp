@@ -0,0 +1,81 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstdint>          // uint8_t, uint32_t
+
+#include <string_view>      // string_view
+
+#include <zench/Screen.hpp>
+
+#include "ScreenBuffer.hpp"
+
+namespace com::saxbophone::zench {
+    ScreenBuffer::ScreenBuffer(Screen& screen) : _screen(screen) {
+        this->_commands.reserve(MAX_COMMANDS);
+        this->_text.reserve(MAX_TEXT);
+    }
+
+    void ScreenBuffer::print(std::string_view text, std::uint8_t style) {
+        if (text.empty()) {
+            return;
+        }
+        this->_begin_print(style);
+        this->_text.append(text);
+        this->_commands.back().length += (std::uint32_t)text.size();
+        this->_flush_if_full();
+    }
+
+    void ScreenBuffer::print(char character, std::uint8_t style) {
+        this->_begin_print(style);
+        this->_text.push_back(character);
+        this->_commands.back().length++;
+        this->_flush_if_full();
+    }
+
+    void ScreenBuffer::new_line() {
+        this->_add({Screen::Command::Type::NewLine, 0, 0, 0});
+    }
+
+    void ScreenBuffer::flush() {
+        if (this->_commands.empty()) {
+            return;
+        }
+        this->_screen.render(this->_commands, this->_text);
+        // keeps the capacity, so that the buffer doesn't allocate again
+        this->_commands.clear();
+        this->_text.clear();
+    }
+
+    void ScreenBuffer::_begin_print(std::uint8_t style) {
+        if (
+            not this->_commands.empty()
+            and this->_commands.back().type == Screen::Command::Type::Print
+            and this->_commands.back().style == style
+        ) {
+            return;
+        }
+        this->_commands.push_back({Screen::Command::Type::Print, style, (std::uint32_t)this->_text.size(), 0});
+    }
+
+    void ScreenBuffer::_add(Screen::Command command) {
+        this->_commands.push_back(command);
+        this->_flush_if_full();
+    }
+
+    void ScreenBuffer::_flush_if_full() {
+        if (this->_commands.size() >= MAX_COMMANDS or this->_text.size() >= MAX_TEXT) {
+            this->flush();
+        }
+    }
+}
@@ -0,0 +1,59 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_SCREEN_BUFFER_HPP
+#define COM_SAXBOPHONE_ZENCH_SCREEN_BUFFER_HPP
+
+#include <cstddef>          // size_t
+#include <cstdint>          // uint8_t
+
+#include <string>           // string
+#include <string_view>      // string_view
+#include <vector>           // vector
+
+#include <zench/Screen.hpp>
+
+namespace com::saxbophone::zench {
+    /*
+     * Records the operations made on a Screen, so that they can be handed to
+     * its driver in one go with flush(), rather than one virtual call each.
+     * Text printed in the same style as the text before it is appended to the
+     * same Print command.
+     */
+    class ScreenBuffer {
+    public:
+        // the buffer is flushed by itself once it holds this many commands or bytes of text
+        static constexpr std::size_t MAX_COMMANDS = 1024;
+        static constexpr std::size_t MAX_TEXT = 16 * 1024;
+
+        ScreenBuffer(Screen& screen);
+
+        void print(std::string_view text, std::uint8_t style = Screen::Style::Roman);
+        void print(char character, std::uint8_t style = Screen::Style::Roman);
+        void new_line();
+        // hands everything recorded so far to the Screen, if there's anything
+        void flush();
+    private:
+        // starts a new Print command, unless the last command can be extended
+        void _begin_print(std::uint8_t style);
+        void _add(Screen::Command command);
+        void _flush_if_full();
+
+        Screen& _screen;
+        std::vector<Screen::Command> _commands;
+        std::string _text;
+    };
+}
+
+#endif // include guard
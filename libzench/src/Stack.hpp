@@ -0,0 +1,242 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_STACK_HPP
+#define COM_SAXBOPHONE_ZENCH_STACK_HPP
+
+#include <cstddef>         // size_t
+
+#include <algorithm>       // copy
+#include <span>            // span
+#include <vector>          // vector
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+namespace com::saxbophone::zench {
+    /*
+     * The Z-machine's stack, holding the locals and evaluation stack of every
+     * routine in the call chain in one contiguous block of Words which is
+     * allocated up front, so that calling and returning never allocate.
+     *
+     * Each frame is laid out as:
+     *
+     *     fp + 0, 1   return address (high Word, low Word)
+     *     fp + 2      frame pointer of the caller's frame
+     *     fp + 3      locals count << 12 | argument count << 8 | result variable
+     *     fp + 4, 5   address of the routine (high Word, low Word), 0 if not known
+     *     fp + 6...   locals, followed by the routine's evaluation stack
+     *
+     * NOTE: to make things more consistent across different Z-code versions,
+     * when not in V6 (which has an explicit "main" routine), the stack starts
+     * with a dummy frame which represents the execution entrypoint. Just like
+     * V6's explicit main, it is a fatal error to return or catch from this
+     * frame, or to throw to it.
+     */
+    class Stack {
+    public:
+        static constexpr std::size_t FRAME_HEADER_SIZE = 6;
+
+        // where to resume, and what to do with the result, after returning from a routine
+        struct Return {
+            Address pc;
+            Byte result_ref;
+        };
+
+        // a read-only view of one frame, for saving the stack
+        struct Frame {
+            Address return_pc;
+            Byte result_ref;
+            std::size_t argument_count;
+            std::span<const Word> locals;
+            std::span<const Word> evaluation_stack;
+        };
+
+        // capacity is the total number of Words available to all frames
+        Stack(std::size_t capacity)
+          : _words(capacity)
+          {
+            if (capacity < FRAME_HEADER_SIZE) {
+                throw StackOverflowException();
+            }
+            // the dummy entrypoint frame
+            this->_sp = FRAME_HEADER_SIZE;
+            this->_base = FRAME_HEADER_SIZE;
+          }
+
+        void push(Word value) {
+            if (this->_sp == this->_words.size()) {
+                throw StackOverflowException();
+            }
+            this->_words[this->_sp++] = value;
+        }
+
+        Word pop() {
+            if (this->_sp == this->_base) {
+                throw StackUnderflowException();
+            }
+            return this->_words[--this->_sp];
+        }
+
+        // the top of the current routine's evaluation stack, without popping it
+        Word& top() {
+            if (this->_sp == this->_base) {
+                throw StackUnderflowException();
+            }
+            return this->_words[this->_sp - 1];
+        }
+
+        // local variable number 1..15 of the current routine
+        Word& local(Byte number) {
+            if (number == 0 or number > this->_locals_count) {
+                throw Exception(); // ERROR! routine doesn't have this many locals
+            }
+            return this->_words[this->_fp + FRAME_HEADER_SIZE + number - 1u];
+        }
+
+        /*
+         * Enters a new routine with the given number of locals, all
+         * initialised to zero. The routine's address is only kept for
+         * profiling, so may be 0 where it isn't known (as when restoring).
+         */
+        void push_frame(
+            Address return_pc,
+            Byte result_ref,
+            std::size_t argument_count,
+            std::size_t locals_count,
+            Address routine = 0
+        ) {
+            std::size_t fp = this->_sp;
+            if (this->_words.size() - fp < FRAME_HEADER_SIZE + locals_count) {
+                throw StackOverflowException();
+            }
+            this->_words[fp] = (Word)(return_pc >> 16);
+            this->_words[fp + 1] = (Word)return_pc;
+            this->_words[fp + 2] = (Word)this->_fp;
+            this->_words[fp + 3] = (Word)(locals_count << 12 | argument_count << 8 | result_ref);
+            this->_words[fp + 4] = (Word)(routine >> 16);
+            this->_words[fp + 5] = (Word)routine;
+            for (std::size_t l = 0; l < locals_count; l++) {
+                this->_words[fp + FRAME_HEADER_SIZE + l] = 0;
+            }
+            this->_enter(fp);
+            this->_sp = this->_base;
+            this->_depth++;
+        }
+
+        // discards the current routine's frame, returning where its caller wanted to resume
+        Return pop_frame() {
+            // it is a fatal error to return from the dummy entrypoint frame
+            if (this->_depth == 1) {
+                throw Exception();
+            }
+            std::size_t fp = this->_fp;
+            Return caller{
+                (Address)(this->_words[fp] << 16 | this->_words[fp + 1]),
+                (Byte)this->_words[fp + 3],
+            };
+            this->_enter(this->_words[fp + 2]);
+            this->_sp = fp;
+            this->_depth--;
+            return caller;
+        }
+
+        // number of arguments the current routine was called with
+        std::size_t argument_count() const {
+            return (this->_words[this->_fp + 3] >> 8) & 0xf;
+        }
+
+        // number of frames on the stack, including the dummy entrypoint frame
+        std::size_t depth() const {
+            return this->_depth;
+        }
+
+        // every frame on the stack, starting with the dummy entrypoint frame
+        std::vector<Frame> frames() const {
+            std::vector<Frame> frames(this->_depth);
+            std::size_t fp = this->_fp;
+            std::size_t top = this->_sp;
+            for (std::size_t f = this->_depth; f --> 0;) {
+                std::size_t locals_count = this->_words[fp + 3] >> 12;
+                std::size_t base = fp + FRAME_HEADER_SIZE + locals_count;
+                frames[f] = {
+                    (Address)(this->_words[fp] << 16 | this->_words[fp + 1]),
+                    (Byte)this->_words[fp + 3],
+                    (std::size_t)(this->_words[fp + 3] >> 8) & 0xf,
+                    std::span<const Word>{this->_words}.subspan(fp + FRAME_HEADER_SIZE, locals_count),
+                    std::span<const Word>{this->_words}.subspan(base, top - base),
+                };
+                top = fp;
+                fp = this->_words[fp + 2];
+            }
+            return frames;
+        }
+
+        // replaces routines with the routine of every frame, starting with the dummy entrypoint frame (0)
+        void routines(std::vector<Address>& routines) const {
+            routines.resize(this->_depth);
+            std::size_t fp = this->_fp;
+            for (std::size_t f = this->_depth; f --> 0;) {
+                routines[f] = (Address)(this->_words[fp + 4] << 16 | this->_words[fp + 5]);
+                fp = this->_words[fp + 2];
+            }
+        }
+
+        // the Words in use by all frames, in the order they were pushed
+        std::span<const Word> words() const {
+            return {this->_words.data(), this->_sp};
+        }
+
+        // start of the current frame, which along with words() and depth() is the whole state of the stack
+        std::size_t frame_pointer() const {
+            return this->_fp;
+        }
+
+        /*
+         * Replaces the contents of the stack with that previously taken from
+         * words(), frame_pointer() and depth(), without reallocating.
+         */
+        void assign(std::span<const Word> words, std::size_t frame_pointer, std::size_t depth) {
+            if (words.size() > this->_words.size()) {
+                throw StackOverflowException();
+            }
+            if (
+                frame_pointer + FRAME_HEADER_SIZE > words.size()
+                or frame_pointer + FRAME_HEADER_SIZE + (words[frame_pointer + 3] >> 12) > words.size()
+                or depth == 0
+            ) {
+                throw Exception(); // ERROR! not a stack
+            }
+            std::copy(words.begin(), words.end(), this->_words.begin());
+            this->_enter(frame_pointer);
+            this->_sp = words.size();
+            this->_depth = depth;
+        }
+    private:
+        // makes the frame at fp the current one
+        void _enter(std::size_t fp) {
+            this->_fp = fp;
+            this->_locals_count = this->_words[fp + 3] >> 12;
+            this->_base = fp + FRAME_HEADER_SIZE + this->_locals_count;
+        }
+
+        std::vector<Word> _words;
+        std::size_t _fp = 0; // start of the current frame
+        std::size_t _base = 0; // bottom of the current routine's evaluation stack
+        std::size_t _sp = 0; // the next free Word
+        std::size_t _locals_count = 0;
+        std::size_t _depth = 1;
+    };
+}
+
+#endif // include guard
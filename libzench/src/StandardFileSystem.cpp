@@ -12,12 +12,196 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <cstddef>    // size_t
+#include <cstring>    // memcpy
+
+#include <algorithm>  // min
+#include <fstream>    // ifstream
+#include <memory>     // unique_ptr
+#include <optional>   // optional
+#include <span>       // span
+#include <string>     // string
+#include <utility>    // move
+
+#if __has_include(<sys/mman.h>)
+#define ZENCH_HAVE_MMAP
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+#endif
+
 #include <zench/StandardFileSystem.hpp>
+#include <zench/zench.hpp>
+
+namespace {
+    using namespace com::saxbophone::zench;
+
+#ifdef ZENCH_HAVE_MMAP
+    // maps the whole file read-only, returning nullptr if it can't be (such as for pipes or empty files)
+    const Byte* map_file(const std::string& path, std::size_t& size) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            return nullptr;
+        }
+        struct stat status;
+        const Byte* data = nullptr;
+        if (::fstat(fd, &status) == 0 and S_ISREG(status.st_mode) and status.st_size > 0) {
+            void* mapping = ::mmap(nullptr, (std::size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                data = (const Byte*)mapping;
+                size = (std::size_t)status.st_size;
+            }
+        }
+        // the mapping stays valid once the descriptor is closed
+        ::close(fd);
+        return data;
+    }
+#endif
+}
 
 namespace com::saxbophone::zench {
-    StandardFileSystem::StandardFileSystem(StandardFilePicker& picker) {}
-    std::unique_ptr<FileSystem::InputFile> StandardFileSystem::open_for_read() { return {}; }
-    std::unique_ptr<FileSystem::InputFile> StandardFileSystem::open_for_read(std::string filename) { return {}; }
-    std::unique_ptr<FileSystem::OutputFile> StandardFileSystem::open_for_write() { return {}; }
-    std::unique_ptr<FileSystem::OutputFile> StandardFileSystem::open_for_write(std::string filename) { return {}; }
+    StandardFileSystem::InputFile::InputFile(std::string path)
+      : _path(std::move(path))
+      {
+        this->open();
+      }
+
+    StandardFileSystem::InputFile::~InputFile() {
+        if (this->is_open()) {
+            this->close();
+        }
+    }
+
+    bool StandardFileSystem::InputFile::is_open() {
+        return this->_is_open;
+    }
+
+    void StandardFileSystem::InputFile::close() {
+#ifdef ZENCH_HAVE_MMAP
+        if (this->_is_mapped) {
+            ::munmap((void*)this->_data, this->_size);
+        }
+#endif
+        this->_buffer = {};
+        this->_data = nullptr;
+        this->_size = 0;
+        this->_cursor = 0;
+        this->_is_mapped = false;
+        this->_is_open = false;
+    }
+
+    bool StandardFileSystem::InputFile::open() {
+        if (this->_path.empty()) {
+            return false;
+        }
+#ifdef ZENCH_HAVE_MMAP
+        if (const Byte* data = map_file(this->_path, this->_size); data != nullptr) {
+            this->_data = data;
+            this->_is_mapped = true;
+            this->_is_open = true;
+            return true;
+        }
+#endif
+        // fall back to reading the whole file into memory in one go
+        std::ifstream file(this->_path, std::ios::binary | std::ios::ate);
+        if (not file) {
+            return false;
+        }
+        std::streamoff size = file.tellg();
+        if (size < 0) {
+            return false;
+        }
+        this->_buffer.resize((std::size_t)size);
+        file.seekg(0);
+        if (not file.read((char*)this->_buffer.data(), size)) {
+            this->_buffer = {};
+            return false;
+        }
+        this->_data = this->_buffer.data();
+        this->_size = this->_buffer.size();
+        this->_is_open = true;
+        return true;
+    }
+
+    char StandardFileSystem::InputFile::read() {
+        return this->_cursor < this->_size ? (char)this->_data[this->_cursor++] : '\0';
+    }
+
+    std::size_t StandardFileSystem::InputFile::read_into(std::span<Byte> buffer) {
+        std::size_t count = std::min(buffer.size(), this->_size - this->_cursor);
+        if (count > 0) {
+            std::memcpy(buffer.data(), this->_data + this->_cursor, count);
+        }
+        this->_cursor += count;
+        return count;
+    }
+
+    std::optional<std::size_t> StandardFileSystem::InputFile::size() {
+        return this->_size;
+    }
+
+    std::span<const Byte> StandardFileSystem::InputFile::contents() {
+        return {this->_data, this->_size};
+    }
+
+    StandardFileSystem::OutputFile::OutputFile(std::string path)
+      : _path(std::move(path))
+      , _file(this->_path, std::ios::binary | std::ios::trunc)
+      {}
+
+    StandardFileSystem::OutputFile::~OutputFile() {
+        if (this->is_open()) {
+            this->close();
+        }
+    }
+
+    bool StandardFileSystem::OutputFile::is_open() {
+        return this->_file.is_open();
+    }
+
+    void StandardFileSystem::OutputFile::close() {
+        this->_file.close();
+    }
+
+    bool StandardFileSystem::OutputFile::open() {
+        // re-opening carries on from the end of what was already written
+        this->_file.clear();
+        this->_file.open(this->_path, std::ios::binary | std::ios::app);
+        return this->_file.is_open();
+    }
+
+    bool StandardFileSystem::OutputFile::write(std::span<const Byte> bytes) {
+        this->_file.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+        return (bool)this->_file;
+    }
+
+    StandardFileSystem::StandardFileSystem(StandardFilePicker& picker) : _picker(picker) {}
+
+    std::unique_ptr<FileSystem::InputFile> StandardFileSystem::open_for_read() {
+        return this->open_for_read(this->_picker.get_filename());
+    }
+
+    std::unique_ptr<FileSystem::InputFile> StandardFileSystem::open_for_read(std::string filename) {
+        auto file = std::make_unique<StandardFileSystem::InputFile>(std::move(filename));
+        if (not file->is_open()) {
+            return {};
+        }
+        return file;
+    }
+
+    std::unique_ptr<FileSystem::OutputFile> StandardFileSystem::open_for_write() {
+        return this->open_for_write(this->_picker.get_filename());
+    }
+
+    std::unique_ptr<FileSystem::OutputFile> StandardFileSystem::open_for_write(std::string filename) {
+        if (filename.empty()) {
+            return {};
+        }
+        auto file = std::make_unique<StandardFileSystem::OutputFile>(std::move(filename));
+        if (not file->is_open()) {
+            return {};
+        }
+        return file;
+    }
 }
@@ -0,0 +1,137 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>               // size_t
+
+#include <bitset>                // bitset
+#include <memory>                // make_unique, shared_ptr
+#include <span>                  // span
+#include <utility>               // move
+#include <vector>                // vector
+
+#include <zench/FileSystem.hpp>
+#include <zench/StoryImage.hpp>
+#include <zench/zench.hpp>
+
+#include "StringCache.hpp"
+
+namespace {
+    using namespace com::saxbophone::zench;
+                                                     // v87654321
+    constexpr std::bitset<8> SUPPORTED_VERSIONS = {0b00000100};
+    constexpr std::size_t STORY_FILE_MAX_SIZE = 128 * 1024; // Version 1-3: 128KiB
+
+    Word load_word(std::span<const Byte> memory, std::size_t address) {
+        return (Word)((memory[address] << 8) | memory[address + 1]);
+    }
+}
+
+namespace com::saxbophone::zench {
+    std::shared_ptr<const StoryImage> StoryImage::load(FileSystem::InputFile& story_file) {
+        // check file can be read from
+        if (not story_file.is_open()) {
+            throw CantReadStoryFileException();
+        }
+        // load header first
+        std::vector<Byte> bytes(HEADER_SIZE);
+        if (story_file.read_into(bytes) != HEADER_SIZE) {
+            throw InvalidStoryFileException();
+        }
+        // check file version
+        Byte file_version = bytes[0x00];
+        if (0 < file_version and file_version < 9) {
+            if (not SUPPORTED_VERSIONS.test(file_version - 1u)) {
+                throw UnsupportedVersionException(file_version);
+            }
+        } else {
+            // invalid version byte (not a well-formed story file)
+            throw InvalidStoryFileException();
+        }
+        // validate the memory map
+        ByteAddress static_memory_begin = load_word(bytes, 0x0e);
+        // validate size of dynamic memory (must be at least 64 bytes)
+        if (static_memory_begin < HEADER_SIZE) {
+            throw InvalidStoryFileException();
+        }
+        // bottom of high memory must not overlap top of dynamic memory
+        if (load_word(bytes, 0x04) < static_memory_begin) {
+            throw InvalidStoryFileException();
+        }
+        /*
+         * Not every InputFile can tell us its size, so we rely on the file
+         * length given in the header instead (stored divided by 2 in V1-3).
+         * Some early story files leave it as zero, in which case we need the
+         * size of the file itself.
+         */
+        std::size_t file_length = load_word(bytes, 0x1a) * 2u;
+        if (file_length == 0) {
+            file_length = story_file.size().value_or(0);
+        }
+        if (file_length < static_memory_begin or file_length > STORY_FILE_MAX_SIZE) {
+            throw InvalidStoryFileException();
+        }
+        // the tables the header points to must be where they can be used from (0 means a story has no such table)
+        ByteAddress globals = load_word(bytes, 0x0c);
+        if (globals < HEADER_SIZE or globals >= static_memory_begin) {
+            throw InvalidStoryFileException(); // global variables must be in dynamic memory
+        }
+        ByteAddress objects = load_word(bytes, 0x0a);
+        if (objects != 0 and (objects < HEADER_SIZE or objects >= static_memory_begin)) {
+            throw InvalidStoryFileException(); // the object table must be in dynamic memory
+        }
+        // the dictionary's length is only known from its own header, it is checked when it's first used
+        ByteAddress dictionary = load_word(bytes, 0x08);
+        if (dictionary != 0 and (dictionary < HEADER_SIZE or dictionary >= file_length)) {
+            throw InvalidStoryFileException();
+        }
+        // 96 abbreviations, each one Word
+        ByteAddress abbreviations = load_word(bytes, 0x18);
+        if (abbreviations != 0 and (abbreviations < HEADER_SIZE or abbreviations + 192u > file_length)) {
+            throw InvalidStoryFileException();
+        }
+        if (load_word(bytes, 0x06) >= file_length) { // initial program counter
+            throw InvalidStoryFileException();
+        }
+        // read in the remainder of the storyfile
+        bytes.resize(file_length);
+        std::span<Byte> remainder = std::span<Byte>{bytes}.subspan(HEADER_SIZE);
+        if (story_file.read_into(remainder) != remainder.size()) {
+            throw InvalidStoryFileException();
+        }
+        return std::shared_ptr<const StoryImage>(new StoryImage(std::move(bytes)));
+    }
+
+    StoryImage::StoryImage(std::vector<Byte> bytes)
+      : _bytes(std::move(bytes))
+      , _strings(std::make_unique<StringCache>())
+      {}
+
+    StoryImage::~StoryImage() = default;
+
+    std::span<const Byte> StoryImage::bytes() const {
+        return this->_bytes;
+    }
+
+    ZVersion StoryImage::version() const {
+        return (ZVersion)this->_bytes[0x00];
+    }
+
+    ByteAddress StoryImage::static_memory_begin() const {
+        return load_word(this->_bytes, 0x0e);
+    }
+
+    StringCache& StoryImage::strings() const {
+        return *this->_strings;
+    }
+}
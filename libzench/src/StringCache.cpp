@@ -0,0 +1,111 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>         // size_t
+#include <cstdint>         // uint32_t
+
+#include <algorithm>       // copy
+#include <memory>          // make_unique
+#include <mutex>           // lock_guard
+#include <optional>        // optional
+#include <shared_mutex>    // shared_lock
+#include <string_view>     // string_view
+#include <utility>         // move
+#include <vector>          // vector
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+#include "StringCache.hpp"
+
+namespace com::saxbophone::zench {
+    StringCache::StringCache(std::size_t budget) : _shard_budget(budget / SHARDS) {}
+
+    std::optional<std::size_t> StringCache::find(Address address, std::vector<char>& text) const {
+        const Shard& shard = this->_shards[_shard_for(address)];
+        std::shared_lock lock(shard.mutex);
+        auto found = shard.index.find(address);
+        if (found == shard.index.end()) {
+            return {};
+        }
+        const Entry& entry = *found->second;
+        // only a hint for eviction, so it needn't be ordered with anything else
+        entry.referenced.store(true, std::memory_order_relaxed);
+        if (text.size() < entry.text.size()) {
+            text.resize(entry.text.size());
+        }
+        std::copy(entry.text.begin(), entry.text.end(), text.begin());
+        return entry.text.size();
+    }
+
+    void StringCache::insert(Address address, std::string_view text) {
+        std::size_t bytes = _bytes_used(text);
+        if (bytes > this->_shard_budget) {
+            return;
+        }
+        Shard& shard = this->_shards[_shard_for(address)];
+        std::lock_guard lock(shard.mutex);
+        if (shard.index.contains(address)) {
+            // another machine got there first
+            return;
+        }
+        while (shard.used + bytes > this->_shard_budget) {
+            shard.hand %= shard.clock.size();
+            Entry& candidate = *shard.clock[shard.hand];
+            if (candidate.referenced.exchange(false, std::memory_order_relaxed)) {
+                shard.hand++;
+                continue;
+            }
+            shard.index.erase(candidate.address);
+            shard.used -= _bytes_used(candidate.text);
+            // the last string takes the evicted one's place, to be visited next
+            shard.clock[shard.hand] = std::move(shard.clock.back());
+            shard.clock.pop_back();
+        }
+        auto entry = std::make_unique<Entry>(address, std::string(text));
+        shard.index.emplace(address, entry.get());
+        shard.clock.push_back(std::move(entry));
+        shard.used += bytes;
+    }
+
+    std::size_t StringCache::budget() const {
+        return this->_shard_budget * SHARDS;
+    }
+
+    std::size_t StringCache::used() const {
+        std::size_t used = 0;
+        for (const Shard& shard : this->_shards) {
+            std::shared_lock lock(shard.mutex);
+            used += shard.used;
+        }
+        return used;
+    }
+
+    std::size_t StringCache::size() const {
+        std::size_t size = 0;
+        for (const Shard& shard : this->_shards) {
+            std::shared_lock lock(shard.mutex);
+            size += shard.clock.size();
+        }
+        return size;
+    }
+
+    std::size_t StringCache::_bytes_used(std::string_view text) {
+        return sizeof(Entry) + text.size();
+    }
+
+    std::size_t StringCache::_shard_for(Address address) {
+        // Fibonacci hashing, as strings are often found at regularly spaced addresses
+        return (std::uint32_t)(address * 0x9E3779B1u) >> (32 - SHARD_BITS);
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_STRING_CACHE_HPP
+#define COM_SAXBOPHONE_ZENCH_STRING_CACHE_HPP
+
+#include <cstddef>         // size_t
+
+#include <array>           // array
+#include <atomic>          // atomic
+#include <memory>          // unique_ptr
+#include <optional>        // optional
+#include <shared_mutex>    // shared_mutex
+#include <string>          // string
+#include <string_view>     // string_view
+#include <unordered_map>   // unordered_map
+#include <vector>          // vector
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+namespace com::saxbophone::zench {
+    /*
+     * The decoded text of Z-strings which Z-code can't modify, by address,
+     * shared by all ZMachines playing the same story.
+     *
+     * Any number of threads may look strings up and add them at once. The
+     * addresses are spread over several shards, each with its own lock, so
+     * lookups only ever share a lock. Once the cache would exceed its budget,
+     * strings are evicted by the CLOCK algorithm: each shard sweeps over its
+     * strings in turn, sparing (once) those which were looked up since it
+     * last passed.
+     */
+    class StringCache {
+    public:
+        static constexpr std::size_t DEFAULT_BUDGET = 1024 * 1024;
+
+        // budget is in bytes, counting each string's text and bookkeeping
+        StringCache(std::size_t budget = DEFAULT_BUDGET);
+        /*
+         * Copies the text cached for address into the start of text, which is
+         * grown to fit if needed. Returns its length, or nothing if not cached.
+         */
+        std::optional<std::size_t> find(Address address, std::vector<char>& text) const;
+        /*
+         * Caches the text decoded from address, evicting other strings to make
+         * room if need be. Does nothing if it's cached already or is too long
+         * to ever fit.
+         */
+        void insert(Address address, std::string_view text);
+        std::size_t budget() const;
+        // bytes currently used by the strings cached
+        std::size_t used() const;
+        // number of strings cached
+        std::size_t size() const;
+    private:
+        static constexpr std::size_t SHARD_BITS = 4;
+        static constexpr std::size_t SHARDS = 1u << SHARD_BITS;
+
+        struct Entry {
+            Address address;
+            std::string text;
+            // set by lookups, cleared as the clock hand passes
+            mutable std::atomic<bool> referenced = false;
+        };
+
+        struct Shard {
+            mutable std::shared_mutex mutex;
+            std::unordered_map<Address, const Entry*> index;
+            // the order in which the clock hand visits the strings
+            std::vector<std::unique_ptr<Entry>> clock;
+            std::size_t hand = 0;
+            std::size_t used = 0;
+        };
+
+        static std::size_t _bytes_used(std::string_view text);
+        static std::size_t _shard_for(Address address);
+
+        std::size_t _shard_budget;
+        std::array<Shard, SHARDS> _shards;
+    };
+}
+
+#endif // include guard
@@ -0,0 +1,135 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>         // size_t
+
+#include <algorithm>       // max, mismatch
+#include <span>            // span
+#include <utility>         // move
+#include <vector>          // vector
+
+#include <zench/zench.hpp>
+
+#include "Stack.hpp"
+#include "UndoRing.hpp"
+
+namespace com::saxbophone::zench {
+    UndoRing::UndoRing(std::size_t budget) : _budget(budget) {}
+
+    void UndoRing::set_budget(std::size_t budget) {
+        this->_budget = budget;
+        this->_trim();
+    }
+
+    std::size_t UndoRing::budget() const {
+        return this->_budget;
+    }
+
+    std::size_t UndoRing::used() const {
+        return this->_used + this->_memory.size() + this->_stack.size() * sizeof(Word);
+    }
+
+    std::size_t UndoRing::size() const {
+        return this->_snapshots.size();
+    }
+
+    void UndoRing::clear() {
+        this->_snapshots.clear();
+        this->_memory = {};
+        this->_stack = {};
+        this->_used = 0;
+        this->_touched = {};
+    }
+
+    bool UndoRing::save(std::span<const Byte> memory, const Stack& stack, Address pc) {
+        // delta runs can only address the first 64KiB, which is as large as dynamic memory gets
+        if (memory.size() > 0x10000) {
+            throw Exception();
+        }
+        std::span<const Word> words = stack.words();
+        Snapshot snapshot{pc, stack.frame_pointer(), stack.depth(), {}, 0, {}};
+        if (this->_snapshots.empty()) {
+            this->_memory.assign(memory.begin(), memory.end());
+            this->_touched = {};
+        } else {
+            // record the runs of bytes which differ from the newest snapshot, as they were there
+            std::vector<Byte>& delta = snapshot.memory_delta;
+            this->_for_each_touched_block(memory.size(), [&](std::size_t begin, std::size_t end) {
+                for (std::size_t a = begin; a < end;) {
+                    if (memory[a] == this->_memory[a]) {
+                        a++;
+                        continue;
+                    }
+                    // runs may carry on past the end of the block
+                    std::size_t run = a;
+                    while (run < memory.size() and run - a < 256 and memory[run] != this->_memory[run]) {
+                        run++;
+                    }
+                    delta.push_back((Byte)(a >> 8));
+                    delta.push_back((Byte)a);
+                    delta.push_back((Byte)(run - a - 1));
+                    for (; a < run; a++) {
+                        delta.push_back(this->_memory[a]);
+                        this->_memory[a] = memory[a];
+                    }
+                    end = std::max(end, run);
+                }
+            });
+            delta.shrink_to_fit();
+            auto [old_end, new_end] = std::mismatch(this->_stack.begin(), this->_stack.end(), words.begin(), words.end());
+            snapshot.stack_prefix = (std::size_t)(old_end - this->_stack.begin());
+            snapshot.stack_suffix.assign(old_end, this->_stack.end());
+        }
+        this->_used += _bytes_used(snapshot);
+        this->_stack.assign(words.begin(), words.end());
+        this->_snapshots.push_back(std::move(snapshot));
+        this->_trim();
+        return not this->_snapshots.empty();
+    }
+
+    std::size_t UndoRing::_bytes_used(const Snapshot& snapshot) {
+        return sizeof(Snapshot) + snapshot.memory_delta.size() + snapshot.stack_suffix.size() * sizeof(Word);
+    }
+
+    void UndoRing::_forget_newest() {
+        // the snapshot's delta has already been applied to the full copy by the caller
+        this->_used -= _bytes_used(this->_snapshots.back());
+        this->_snapshots.pop_back();
+        if (this->_snapshots.empty()) {
+            this->clear();
+        }
+    }
+
+    void UndoRing::_forget_oldest() {
+        this->_used -= _bytes_used(this->_snapshots.front());
+        this->_snapshots.pop_front();
+        if (this->_snapshots.empty()) {
+            this->clear();
+            return;
+        }
+        // there's nothing before the new oldest snapshot for its delta to lead to
+        Snapshot& oldest = this->_snapshots.front();
+        this->_used -= _bytes_used(oldest);
+        oldest.memory_delta = {};
+        oldest.stack_prefix = 0;
+        oldest.stack_suffix = {};
+        this->_used += _bytes_used(oldest);
+    }
+
+    void UndoRing::_trim() {
+        while (this->used() > this->_budget and not this->_snapshots.empty()) {
+            this->_forget_oldest();
+        }
+    }
+}
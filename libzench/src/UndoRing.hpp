@@ -0,0 +1,182 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_UNDO_RING_HPP
+#define COM_SAXBOPHONE_ZENCH_UNDO_RING_HPP
+
+#include <cstddef>         // size_t
+#include <cstdint>         // uint64_t
+
+#include <algorithm>       // min
+#include <array>           // array
+#include <bit>             // countr_zero
+#include <deque>           // deque
+#include <optional>        // optional
+#include <span>            // span
+#include <utility>         // exchange
+#include <vector>          // vector
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+#include "Stack.hpp"
+
+namespace com::saxbophone::zench {
+    /*
+     * A history of snapshots of a ZMachine's dynamic memory and stack, for
+     * undoing turns, which uses no more than a fixed number of bytes.
+     *
+     * Only the newest snapshot is held in full. Each older one is held as a
+     * reverse delta --the bytes and stack Words it has which differ from the
+     * snapshot after it-- so a turn usually costs a few dozen bytes however
+     * large dynamic memory is. Once the budget is exceeded, the oldest
+     * snapshots are forgotten.
+     *
+     * The owner reports every byte it writes through touch(), so that only
+     * the blocks of memory written to are compared against the newest snapshot.
+     */
+    class UndoRing {
+    public:
+        // budget is in bytes, including the full copy of the newest snapshot
+        UndoRing(std::size_t budget);
+        // changes the budget, forgetting old snapshots to fit within it
+        void set_budget(std::size_t budget);
+        std::size_t budget() const;
+        // bytes currently used by the snapshots held
+        std::size_t used() const;
+        // number of snapshots held
+        std::size_t size() const;
+        // forgets all snapshots
+        void clear();
+        // marks the block holding the byte at address (which must be below 64KiB) as written to
+        void touch(Address address) {
+            std::size_t block = address / BLOCK_SIZE;
+            this->_touched[block / 64] |= std::uint64_t{1} << (block % 64);
+        }
+        /*
+         * Takes a snapshot of the given state, which is resumed at pc.
+         * Returns false if even this snapshot alone doesn't fit in the budget.
+         * NOTE: dynamic memory must be the same size on every call, and every
+         * byte of it written since the last save or restore must have been
+         * passed to touch().
+         */
+        bool save(std::span<const Byte> memory, const Stack& stack, Address pc);
+        /*
+         * Rewinds to the snapshot steps back (1 being the newest), discarding
+         * it and all newer snapshots. Each byte of memory to change is passed
+         * to store(address, value) and stack is replaced.
+         * Returns the pc of the snapshot, or nothing if there aren't that many.
+         * Takes time proportional to the bytes changed since that snapshot.
+         */
+        template <typename Store>
+        std::optional<Address> restore(std::size_t steps, std::span<const Byte> memory, Stack& stack, Store store) {
+            if (steps == 0 or steps > this->_snapshots.size()) {
+                return {};
+            }
+            // first put back whatever has changed since the newest snapshot
+            this->_for_each_touched_block(memory.size(), [&](std::size_t begin, std::size_t end) {
+                for (std::size_t a = begin; a < end; a++) {
+                    if (memory[a] != this->_memory[a]) {
+                        store((Address)a, this->_memory[a]);
+                    }
+                }
+            });
+            // then walk back through the deltas to the snapshot wanted
+            for (std::size_t s = 1; s < steps; s++) {
+                this->_apply(this->_snapshots.back(), store);
+                this->_forget_newest();
+            }
+            const Snapshot& restored = this->_snapshots.back();
+            Address pc = restored.pc;
+            stack.assign(this->_stack, restored.frame_pointer, restored.depth);
+            /*
+             * the snapshot before it, if any, becomes the newest, and memory
+             * now differs from it by exactly the bytes in the restored delta
+             */
+            this->_touched = {};
+            this->_apply(restored, [this](Address address, Byte) { this->touch(address); });
+            this->_forget_newest();
+            return pc;
+        }
+    private:
+        // memory is compared in blocks this size, as most of it is unchanged between snapshots
+        static constexpr std::size_t BLOCK_SIZE = 64;
+        // dynamic memory is never larger than 64KiB
+        static constexpr std::size_t MAX_BLOCKS = 0x10000 / BLOCK_SIZE;
+
+        struct Snapshot {
+            Address pc;
+            std::size_t frame_pointer;
+            std::size_t depth;
+            /*
+             * The reverse delta to the snapshot before this one, as runs of
+             * bytes which differ, each prefixed by its address (2 bytes) and
+             * its length minus one (1 byte). Empty for the oldest snapshot.
+             */
+            std::vector<Byte> memory_delta;
+            // the Words of the previous snapshot's stack which differ, after those they have in common
+            std::size_t stack_prefix = 0;
+            std::vector<Word> stack_suffix;
+        };
+
+        // bytes used by a snapshot, besides the full copy of the newest
+        static std::size_t _bytes_used(const Snapshot& snapshot);
+        // turns the newest snapshot (held in full) into the one before it
+        template <typename Store>
+        void _apply(const Snapshot& snapshot, Store store) {
+            const std::vector<Byte>& delta = snapshot.memory_delta;
+            for (std::size_t i = 0; i < delta.size();) {
+                std::size_t address = (std::size_t)(delta[i] << 8 | delta[i + 1]);
+                std::size_t length = delta[i + 2] + 1u;
+                i += 3;
+                for (std::size_t b = 0; b < length; b++) {
+                    this->_memory[address + b] = delta[i + b];
+                    store((Address)(address + b), delta[i + b]);
+                }
+                i += length;
+            }
+            this->_stack.resize(snapshot.stack_prefix);
+            this->_stack.insert(this->_stack.end(), snapshot.stack_suffix.begin(), snapshot.stack_suffix.end());
+        }
+        // calls visit(begin, end) for each block touched within size bytes, then forgets they were
+        template <typename Visit>
+        void _for_each_touched_block(std::size_t size, Visit visit) {
+            for (std::size_t i = 0; i < this->_touched.size(); i++) {
+                // visit() may touch blocks again, which are then left marked
+                std::uint64_t blocks = std::exchange(this->_touched[i], 0);
+                while (blocks != 0) {
+                    std::size_t begin = (i * 64 + (std::size_t)std::countr_zero(blocks)) * BLOCK_SIZE;
+                    blocks &= blocks - 1;
+                    if (begin < size) {
+                        visit(begin, std::min(begin + BLOCK_SIZE, size));
+                    }
+                }
+            }
+        }
+        void _forget_newest();
+        void _forget_oldest();
+        // forgets the oldest snapshots until within budget
+        void _trim();
+
+        std::size_t _budget;
+        std::size_t _used = 0; // by the snapshots, besides the full copy of the newest
+        std::deque<Snapshot> _snapshots;
+        // dynamic memory and stack of the newest snapshot, in full
+        std::vector<Byte> _memory;
+        std::vector<Word> _stack;
+        // one bit for each block of memory written to since the last save or restore
+        std::array<std::uint64_t, MAX_BLOCKS / 64> _touched{};
+    };
+}
+
+#endif // include guard
@@ -12,9 +12,18 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <cstddef>   // size_t
+#include <cstdint>   // SIZE_MAX, uint64_t
+
+#include <exception> // exception_ptr
+#include <memory>    // shared_ptr
+#include <string>    // string
+#include <utility>   // move
+
 #include <zench/FileSystem.hpp>
 #include <zench/Keyboard.hpp>
 #include <zench/Screen.hpp>
+#include <zench/StoryImage.hpp>
 #include <zench/ZMachine.hpp>
 
 #include "ZMachineImpl.hpp"
@@ -24,13 +33,84 @@ namespace com::saxbophone::zench {
         FileSystem::InputFile& story_file,
         FileSystem& fs,
         Screen& screen,
-        Keyboard& keyboard
-    ) : _impl(new ZMachineImpl(story_file, fs, screen, keyboard)) {}
+        Keyboard& keyboard,
+        Dispatch dispatch
+    ) : ZMachine(StoryImage::load(story_file), fs, screen, keyboard, dispatch) {}
+
+    ZMachine::ZMachine(
+        std::shared_ptr<const StoryImage> story,
+        FileSystem& fs,
+        Screen& screen,
+        Keyboard& keyboard,
+        Dispatch dispatch
+    ) : _impl(new ZMachineImpl(std::move(story), fs, screen, keyboard, dispatch)) {}
 
     ZMachine::~ZMachine() = default; // needed to allow pimpl idiom to work
     // see: https://www.fluentcpp.com/2017/09/22/make-pimpl-using-unique_ptr/
     // returns true if ZMachine instance is ready to execute an instruction
-    bool ZMachine::is_ready() { return false; } // STUB
+    bool ZMachine::is_ready() {
+        return this->_impl->is_ready();
+    }
     // executes one instruction
-    void ZMachine::execute() { return; } // STUB
+    void ZMachine::execute() {
+        this->_impl->execute_next_instruction();
+    }
+
+    ZMachine::Status ZMachine::run(std::size_t max_instructions) {
+        return this->_impl->run(max_instructions);
+    }
+
+    ZMachine::Status ZMachine::run_until_blocked() {
+        return this->_impl->run(SIZE_MAX);
+    }
+
+    std::exception_ptr ZMachine::error() const {
+        return this->_impl->error();
+    }
+
+    void ZMachine::flush_screen() {
+        this->_impl->flush_screen();
+    }
+
+    ZMachine::Task ZMachine::play() {
+        while (true) {
+            Status status = this->run_until_blocked();
+            if (status != Status::WaitingForInput) {
+                co_return status;
+            }
+            co_yield status;
+        }
+    }
+
+    void ZMachine::set_undo_budget(std::size_t bytes) {
+        this->_impl->set_undo_budget(bytes);
+    }
+
+    std::size_t ZMachine::undo_depth() const {
+        return this->_impl->undo_depth();
+    }
+
+    bool ZMachine::undo(std::size_t turns) {
+        return this->_impl->undo(turns);
+    }
+
+    ZMachine::Stats ZMachine::stats() const {
+        return this->_impl->stats();
+    }
+
+    void ZMachine::reset_stats() {
+        this->_impl->reset_stats();
+    }
+
+    std::uint64_t ZMachine::instructions() const {
+        return this->_impl->instructions();
+    }
+
+    void ZMachine::set_profiling_interval(std::size_t instructions) {
+        this->_impl->set_profiling_interval(instructions);
+    }
+
+    std::string ZMachine::profile() const {
+        return this->_impl->profile();
+    }
 }
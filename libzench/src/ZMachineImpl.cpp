@@ -12,22 +12,1447 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <cstddef>    // size_t
+#include <cstdint>    // uint16_t
+#include <cstring>    // memcmp
+
+#include <algorithm>  // erase_if, min
+#include <array>      // array
+#include <charconv>   // to_chars
+#include <exception>  // current_exception, exception, exception_ptr
+#include <functional> // less, greater
+#include <iterator>   // begin, end
+#include <memory>     // shared_ptr
+#include <optional>   // optional
+#include <span>       // span
+#include <string>     // string
+#include <string_view> // string_view
+#include <utility>    // move
+#include <variant>    // get_if
+#include <vector>     // vector
+
 #include <zench/FileSystem.hpp>
 #include <zench/Keyboard.hpp>
+#include <zench/RingKeyboard.hpp>
 #include <zench/Screen.hpp>
+#include <zench/StoryImage.hpp>
 #include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
 
+#include "AsyncWriter.hpp"
+#include "Dictionary.hpp"
+#include "Instruction.hpp"
+#include "ObjectTable.hpp"
+#include "Profiler.hpp"
+#include "Quetzal.hpp"
+#include "ScreenBuffer.hpp"
+#include "StringCache.hpp"
 #include "ZMachineImpl.hpp"
+#include "ZStringDecoder.hpp"
 
 namespace com::saxbophone::zench {
     ZMachine::ZMachineImpl::ZMachineImpl(
-        FileSystem::InputFile& story_file,
+        std::shared_ptr<const StoryImage> story,
         FileSystem& fs,
         Screen& screen,
-        Keyboard& keyboard
+        Keyboard& keyboard,
+        ZMachine::Dispatch dispatch
     )
       : _filesystem(fs)
       , _screen(screen)
+      , _output(screen)
       , _keyboard(keyboard)
-      {}
+      , _ring_keyboard(dynamic_cast<RingKeyboard*>(&keyboard))
+      , _dispatch(dispatch)
+      , _story(std::move(story))
+      , _image(this->_story->bytes())
+      {
+        this->_map_memory();
+        this->_pc = this->_load_word(0x06); // load initial program counter
+        this->_is_running = true;
+      }
+
+    bool ZMachine::ZMachineImpl::is_ready() const {
+        return this->_is_running;
+    }
+
+    ZMachine::Status ZMachine::ZMachineImpl::run(std::size_t max_instructions) {
+        // a READ which blocked last time gets to try again
+        this->_waiting_for_input = false;
+        try {
+            std::size_t executed;
+            if (not this->_profiler) {
+                return this->_run_dispatch(max_instructions, executed);
+            }
+            // run in slices which end where samples are due, so that profiling costs nothing in between
+            while (true) {
+                ZMachine::Status status = this->_run_dispatch(
+                    std::min(max_instructions, this->_profiler->until_sample()),
+                    executed
+                );
+                max_instructions -= executed;
+                if (this->_profiler->advance(executed)) {
+                    this->_profiler->sample(this->_stack);
+                }
+                if (status != ZMachine::Status::BudgetExhausted or max_instructions == 0) {
+                    return status;
+                }
+            }
+        } catch (const std::exception&) {
+            // errors are fatal, the machine is left in an undefined state
+            // NOTE: whatever was printed up to the error is still shown
+            this->_flush_output(true);
+            this->_error = std::current_exception();
+            this->_is_running = false;
+            return ZMachine::Status::Error;
+        }
+    }
+
+    std::exception_ptr ZMachine::ZMachineImpl::error() const {
+        return this->_error;
+    }
+
+    void ZMachine::ZMachineImpl::set_undo_budget(std::size_t bytes) {
+        this->_undo.set_budget(bytes);
+    }
+
+    std::size_t ZMachine::ZMachineImpl::undo_depth() const {
+        // when waiting at a READ, the newest snapshot is of the turn in progress
+        std::size_t snapshots = this->_undo.size();
+        return this->_reading and snapshots > 0 ? snapshots - 1 : snapshots;
+    }
+
+    bool ZMachine::ZMachineImpl::undo(std::size_t turns) {
+        if (turns == 0 or turns > this->undo_depth() or this->_error) {
+            return false;
+        }
+        Byte flags2 = this->_dynamic_memory[0x11];
+        // written through the write barrier so any cached instructions are dropped
+        std::optional<Address> pc = this->_undo.restore(
+            this->_reading ? turns + 1 : turns,
+            std::span<const Byte>{this->_dynamic_memory}.first(this->_static_memory_begin),
+            this->_stack,
+            [this](Address address, Byte value) { this->_store_byte(address, value); }
+        );
+        // the transcripting and fixed-pitch bits of Flags 2 survive an undo, as for restore
+        this->_store_byte(0x11, (Byte)((this->_dynamic_memory[0x11] & ~0b11u) | (flags2 & 0b11u)));
+        // resume at the READ, which asks for the line again
+        this->_pc = *pc;
+        this->_reading = false;
+        this->_input_line.clear();
+        this->_is_running = true;
+        return true;
+    }
+
+    void ZMachine::ZMachineImpl::_map_memory() {
+        // the story image has already been validated, so we can trust the memory map
+        this->_version = this->_story->version();
+        this->_static_memory_begin = this->_story->static_memory_begin();
+        // copy dynamic memory, plus the overhang into static memory
+        std::size_t copied = std::min(
+            this->_image.size(),
+            this->_static_memory_begin + DYNAMIC_MEMORY_OVERHANG
+        );
+        this->_dynamic_memory.assign(this->_image.begin(), this->_image.begin() + (std::ptrdiff_t)copied);
+        this->_watched_memory.assign(this->_static_memory_begin, 0);
+        this->_high_memory_begin = this->_load_word(0x04);
+        // global variables base address is given in Word 6 (the 7th Word)
+        this->_globals_address = this->_load_word(0x0c);
+        this->_dictionary_address = this->_load_word(0x08);
+        this->_dictionary_index.reset();
+        this->_indexed_dictionary_length = 0;
+        ByteAddress objects = this->_load_word(0x0a);
+        this->_objects = ObjectTable(this->_memory_view(objects), objects);
+    }
+
+    const Instruction& ZMachine::ZMachineImpl::_fetch_instruction() {
+        if (not this->_stale_code.empty()) {
+            this->_invalidate_stale_instructions();
+        }
+        CachedInstruction* cached;
+        // straight-line code can follow the link from the last instruction without a lookup
+        if (this->_last_fetched != nullptr and this->_pc == this->_last_fetched->instruction.end()) {
+            cached = this->_last_fetched->next;
+            if (cached == nullptr) {
+                cached = &this->_cache_instruction(this->_pc);
+                this->_last_fetched->next = cached;
+            }
+        } else {
+            cached = &this->_cache_instruction(this->_pc);
+        }
+        this->_last_fetched = cached;
+        this->_pc = cached->instruction.end();
+        return cached->instruction;
+    }
+
+    ZMachine::ZMachineImpl::CachedInstruction& ZMachine::ZMachineImpl::_cache_instruction(Address location) {
+        auto cached = this->_instruction_cache.find(location);
+        if (cached != this->_instruction_cache.end()) {
+            return cached->second;
+        }
+        Address end;
+        Instruction instruction = this->_covering([&] {
+            end = location;
+            return Instruction::decode(end, this->_memory_view(location)); // modifies end in-place
+        });
+        // remember which bytes of dynamic memory this instruction covers
+        if (location < this->_static_memory_begin) {
+            Address covered_end = std::min(end, (Address)this->_static_memory_begin);
+            for (Address a = location; a < covered_end; a++) {
+                this->_watched_memory[a] |= WATCH_CODE;
+            }
+            this->_cached_dynamic_instructions.push_back(location);
+        }
+        return this->_instruction_cache.emplace(
+            location,
+            CachedInstruction{instruction}
+        ).first->second;
+    }
+
+    void ZMachine::ZMachineImpl::_invalidate_stale_instructions() {
+        // find and drop every cached instruction that covers a written byte
+        std::erase_if(
+            this->_cached_dynamic_instructions,
+            [&](Address location) {
+                Address end = this->_instruction_cache.at(location).instruction.end();
+                for (Address written : this->_stale_code) {
+                    if (location <= written and written < end) {
+                        this->_instruction_cache.erase(location);
+                        return true;
+                    }
+                }
+                return false;
+            }
+        );
+        // rebuild the map of covered bytes from the instructions that remain
+        for (Byte& watched : this->_watched_memory) {
+            watched &= (Byte)~WATCH_CODE;
+        }
+        for (Address location : this->_cached_dynamic_instructions) {
+            Address end = this->_instruction_cache.at(location).instruction.end();
+            Address covered_end = std::min(end, (Address)this->_static_memory_begin);
+            for (Address a = location; a < covered_end; a++) {
+                this->_watched_memory[a] |= WATCH_CODE;
+            }
+        }
+        // links may point at dropped instructions, this is rare enough that we can just unlink everything
+        for (auto& [location, cached] : this->_instruction_cache) {
+            cached.next = nullptr;
+        }
+        this->_last_fetched = nullptr;
+        this->_stale_code.clear();
+    }
+
+    std::span<const Byte> ZMachine::ZMachineImpl::_memory_view(Address address) const {
+        if (address < this->_static_memory_begin) {
+            return this->_dynamic_memory;
+        }
+        return this->_image;
+    }
+
+    bool ZMachine::ZMachineImpl::_cover_more_of_static_memory() {
+        std::size_t covered = this->_dynamic_memory.size();
+        if (covered == this->_image.size()) {
+            return false;
+        }
+        // twice as much each time, so that even the largest table is covered after a few tries
+        std::size_t wanted = std::min(this->_image.size(), covered + (covered - this->_static_memory_begin));
+        this->_dynamic_memory.insert(
+            this->_dynamic_memory.end(),
+            this->_image.begin() + (std::ptrdiff_t)covered,
+            this->_image.begin() + (std::ptrdiff_t)wanted
+        );
+        // the object table is always in dynamic memory, which has just moved
+        this->_objects.rebind(this->_dynamic_memory);
+        return true;
+    }
+
+    Byte ZMachine::ZMachineImpl::_load_byte(Address address) const {
+        if (address < this->_static_memory_begin) {
+            return this->_dynamic_memory[address];
+        }
+        if (address >= this->_image.size()) {
+            throw Exception(); // ERROR! read beyond the end of memory
+        }
+        return this->_image[address];
+    }
+
+    Word ZMachine::ZMachineImpl::_load_word(Address address) const {
+        if (address + 1 >= this->_image.size()) {
+            throw Exception(); // ERROR! read beyond the end of memory
+        }
+        // the overhang means that a Word straddling the end of dynamic memory can be read from either view
+        std::span<const Byte> memory = this->_memory_view(address);
+        return (Word)((memory[address] << 8) | memory[address + 1]);
+    }
+
+    void ZMachine::ZMachineImpl::_store_byte(Address address, Byte value) {
+        this->_dynamic_memory[address] = value;
+        this->_undo.touch(address);
+        if (Byte watched = this->_watched_memory[address]; watched != 0) {
+            if (watched & WATCH_CODE) {
+                this->_stale_code.push_back(address);
+            }
+            if (watched & WATCH_PROPERTY_LAYOUT) {
+                // rare enough that every layout can be decoded again
+                this->_objects.invalidate();
+                for (Byte& flags : this->_watched_memory) {
+                    flags &= (Byte)~WATCH_PROPERTY_LAYOUT;
+                }
+            }
+        }
+        if ((Address)(address - this->_dictionary_address) < this->_indexed_dictionary_length) {
+            this->_dictionary_index.reset();
+            this->_indexed_dictionary_length = 0;
+        }
+    }
+
+    void ZMachine::ZMachineImpl::_store_word(Address address, Word value) {
+        this->_store_byte(address, (Byte)(value >> 8));
+        this->_store_byte(address + 1, (Byte)(value & 0x00ff));
+    }
+
+    bool ZMachine::ZMachineImpl::_writable(Address address) const {
+        // of the header, only Flags 2 may be changed by Z-code
+        if (address < StoryImage::HEADER_SIZE) {
+            return address == 0x10 or address == 0x11;
+        }
+        return address < this->_static_memory_begin;
+    }
+
+    Word ZMachine::ZMachineImpl::_load_variable(Byte number) {
+        if (number == 0x00) { // stack pointer
+            return this->_stack.pop();
+        }
+        return this->_load_variable_in_place(number);
+    }
+
+    void ZMachine::ZMachineImpl::_store_variable(Byte number, Word value) {
+        if (number == 0x00) { // stack pointer
+            this->_stack.push(value);
+        } else {
+            this->_store_variable_in_place(number, value);
+        }
+    }
+
+    Word ZMachine::ZMachineImpl::_load_variable_in_place(Byte number) {
+        if (number == 0x00) { // top of stack
+            return this->_stack.top();
+        } else if (number <= 0x0f) { // locals = 0x01..0x0f
+            return this->_stack.local(number);
+        } else { // globals = 0x10..0xff
+            return this->_load_word(this->_globals_address + 2u * (number - 0x10u));
+        }
+    }
+
+    void ZMachine::ZMachineImpl::_store_variable_in_place(Byte number, Word value) {
+        if (number == 0x00) { // top of stack
+            this->_stack.top() = value;
+        } else if (number <= 0x0f) { // locals = 0x01..0x0f
+            this->_stack.local(number) = value;
+        } else { // globals = 0x10..0xff
+            Address address = this->_globals_address + 2u * (number - 0x10u);
+            if (address + 1u >= this->_static_memory_begin) {
+                throw Exception(); // ERROR! global variable is outside of dynamic memory
+            }
+            this->_store_word(address, value);
+        }
+    }
+
+    const ObjectTable::Properties& ZMachine::ZMachineImpl::_properties(Word object) {
+        return this->_covering([&]() -> const ObjectTable::Properties& {
+            return this->_objects.properties(object, [this](Address address) {
+                // static memory can't change under us
+                if (address < this->_static_memory_begin) {
+                    this->_watched_memory[address] |= WATCH_PROPERTY_LAYOUT;
+                }
+            });
+        });
+    }
+
+    const ObjectTable::Property& ZMachine::ZMachineImpl::_property(Word object, Word property) {
+        if (property == 0 or property > ObjectTable::MAX_PROPERTY) {
+            throw Exception(); // ERROR! no such property
+        }
+        return this->_properties(object)[property];
+    }
+
+    std::span<const Byte> ZMachine::ZMachineImpl::_z_string_at(Address address) {
+        return this->_covering([&] {
+            std::span<const Byte> memory = this->_memory_view(address);
+            // the last Word of a Z-string has its top bit set
+            Address end = address;
+            do {
+                if (end + 1u >= memory.size()) {
+                    throw Exception(); // ERROR! Z-string runs off the end of memory
+                }
+                end += 2;
+            } while ((memory[end - 2u] & 0x80) == 0);
+            return memory.subspan(address, end - address);
+        });
+    }
+
+    void ZMachine::ZMachineImpl::_print_z_string(Address address, std::span<const Byte> z_string) {
+        bool unmodifiable = address >= this->_static_memory_begin;
+        if (unmodifiable) {
+            if (std::optional<std::size_t> length = this->_story->strings().find(address, this->_decoded_text)) {
+                return this->_print(std::string_view(this->_decoded_text.data(), *length));
+            }
+        }
+        if (z_string.empty()) {
+            z_string = this->_z_string_at(address);
+        }
+        std::size_t length = this->_decoder.decode(z_string, this->_decoded_text);
+        if (length > this->_decoded_text.size()) {
+            // only grows until it fits the longest string printed yet
+            this->_decoded_text.resize(length);
+            this->_decoder.decode(z_string, this->_decoded_text);
+        }
+        std::string_view text(this->_decoded_text.data(), length);
+        if (unmodifiable) {
+            this->_story->strings().insert(address, text);
+        }
+        this->_print(text);
+    }
+
+    void ZMachine::ZMachineImpl::_print(std::string_view text) {
+        if (this->_screen_selected) {
+            this->_output.print(text);
+        }
+        if (this->_transcribing()) {
+            this->_transcript->write(text);
+        }
+    }
+
+    void ZMachine::ZMachineImpl::_print(char character) {
+        if (this->_screen_selected) {
+            this->_output.print(character);
+        }
+        if (this->_transcribing()) {
+            this->_transcript->write(character);
+        }
+    }
+
+    void ZMachine::ZMachineImpl::_new_line() {
+        if (this->_screen_selected) {
+            this->_output.new_line();
+        }
+        if (this->_transcribing()) {
+            this->_transcript->write('\n');
+        }
+    }
+
+    bool ZMachine::ZMachineImpl::_transcribing() {
+        // Z-code may also select the transcript by setting the bit itself
+        if ((this->_dynamic_memory[0x11] & 0b1u) == 0) {
+            return false;
+        }
+        if (this->_transcript == nullptr) {
+            std::unique_ptr<FileSystem::OutputFile> file = this->_filesystem.open_for_write();
+            if (file == nullptr) {
+                // there's nowhere to write it, so the transcript is deselected again
+                this->_store_byte(0x11, (Byte)(this->_dynamic_memory[0x11] & ~0b1u));
+                return false;
+            }
+            this->_transcript = std::make_unique<AsyncWriter>(std::move(file));
+        }
+        return true;
+    }
+
+    void ZMachine::ZMachineImpl::_flush_output(bool wait) {
+        this->_output.flush();
+        for (AsyncWriter* writer : {this->_transcript.get(), this->_commands_script.get()}) {
+            if (writer == nullptr) {
+                continue;
+            }
+            if (wait) {
+                // NOTE: a failed write loses some of the file but needn't stop the game
+                writer->flush();
+            } else {
+                writer->submit();
+            }
+        }
+    }
+
+    void ZMachine::ZMachineImpl::set_profiling_interval(std::size_t instructions) {
+        if (instructions == 0) {
+            this->_profiler.reset();
+        } else {
+            this->_profiler.emplace(instructions);
+        }
+    }
+
+    std::string ZMachine::ZMachineImpl::profile() const {
+        return this->_profiler ? this->_profiler->folded() : std::string();
+    }
+
+    void ZMachine::ZMachineImpl::flush_screen() {
+        this->_output.flush();
+    }
+
+    std::uint64_t ZMachine::ZMachineImpl::instructions() const {
+        return this->_instructions;
+    }
+
+    ZMachine::Stats ZMachine::ZMachineImpl::stats() const {
+        ZMachine::Stats stats;
+    #ifdef ZENCH_STATS
+        stats.enabled = true;
+        for (std::size_t h = 0; h < this->_opcode_stats.size(); h++) {
+            ZMachine::OpcodeStats& opcode = stats.opcodes.emplace_back(this->_opcode_stats[h]);
+            opcode.name = HANDLER_NAMES[h];
+            stats.instructions += opcode.count;
+        }
+    #endif
+        return stats;
+    }
+
+    void ZMachine::ZMachineImpl::reset_stats() {
+    #ifdef ZENCH_STATS
+        this->_opcode_stats = {};
+    #endif
+    }
+
+    Address ZMachine::ZMachineImpl::_expand_packed_address(PackedAddress packed) const {
+        // NOTE: StoryImage only accepts V3 stories, whose packed addresses are all Word addresses
+        return 2u * packed;
+    }
+
+    Word ZMachine::ZMachineImpl::_operand_value(const Instruction& instruction, std::size_t operand) {
+        if (instruction.is_variable(operand)) {
+            return this->_load_variable((Byte)instruction.operands[operand]);
+        }
+        return instruction.operands[operand];
+    }
+
+    void ZMachine::ZMachineImpl::_return_value(Word value) {
+        // pop the stack, moving pc to the return address
+        Stack::Return caller = this->_stack.pop_frame();
+        this->_pc = caller.pc;
+        // set result variable
+        this->_store_variable(caller.result_ref, value);
+    }
+
+    void ZMachine::ZMachineImpl::_branch(const Instruction& instruction, bool condition) {
+        // obey branch instruction's on-true/on-false specifier
+        if (condition != instruction.branch.on_true) {
+            return;
+        }
+        SWord offset = instruction.branch.offset;
+        // special cases are offsets 0 and 1, which return false or true from the current routine
+        if (offset == 0 or offset == 1) {
+            return this->_return_value((Word)offset);
+        }
+        // new address = address after branch data + offset - 2
+        // pc is already at "address after branch data", so thus:
+        this->_pc = (Address)((int)this->_pc + offset - 2);
+    }
+
+    bool ZMachine::ZMachineImpl::_read_line() {
+        if (this->_ring_keyboard == nullptr) {
+            for (auto event : this->_keyboard.get_input()) {
+                this->_pending_input.push_back(event);
+            }
+        }
+        while (not this->_pending_input.empty()) {
+            Keyboard::Event event = this->_pending_input.front();
+            this->_pending_input.pop_front();
+            if (this->_type_key(event)) {
+                return true;
+            }
+        }
+        // a RingKeyboard is read directly, leaving any events after the newline in the ring
+        if (this->_ring_keyboard != nullptr) {
+            while (std::optional<Keyboard::Event> event = this->_ring_keyboard->pop()) {
+                if (this->_type_key(*event)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool ZMachine::ZMachineImpl::_type_key(Keyboard::Event event) {
+        if (auto key = std::get_if<Keyboard::SpecialKey>(&event)) {
+            if (*key == Keyboard::SpecialKey::Newline) {
+                return true;
+            } else if (*key == Keyboard::SpecialKey::Delete and not this->_input_line.empty()) {
+                this->_input_line.pop_back();
+            }
+            // other special keys are not meaningful to READ in V3
+        } else {
+            std::uint16_t codepoint = std::get<std::uint16_t>(event);
+            if (codepoint == '\n' or codepoint == '\r') {
+                return true;
+            } else if (codepoint == '\b' and not this->_input_line.empty()) {
+                this->_input_line.pop_back();
+            } else if (Byte zscii = this->_decoder.zscii_from_unicode(codepoint); zscii != 0) {
+                this->_input_line.push_back(zscii);
+            }
+        }
+        return false;
+    }
+
+    void ZMachine::ZMachineImpl::_tokenise(ByteAddress text, ByteAddress parse, const Dictionary& dictionary) {
+        std::size_t max_words = this->_load_byte(parse);
+        if (parse + 2u + 4u * max_words > this->_static_memory_begin) {
+            throw IllegalMemoryWriteException();
+        }
+        std::size_t words = 0;
+        // writes a parse block for the word starting at begin and ending before end
+        auto add_word = [&](Address begin, Address end) {
+            if (words == max_words) {
+                return;
+            }
+            // the text buffer has already been checked to lie within dynamic memory
+            std::span<const Byte> word{&this->_dynamic_memory[begin], end - begin};
+            Address block = parse + 2u + 4u * words;
+            this->_store_word(block, dictionary.lookup(word));
+            this->_store_byte(block + 2, (Byte)(end - begin)); // number of letters
+            this->_store_byte(block + 3, (Byte)(begin - text)); // position in text buffer
+            words++;
+        };
+        // in V1-4, the text starts at byte 1 and is terminated by a zero byte
+        Address begin = text + 1u;
+        Address cursor = begin;
+        for (; this->_load_byte(cursor) != 0; cursor++) {
+            Byte c = this->_load_byte(cursor);
+            if (c == ' ' or dictionary.is_separator(c)) {
+                if (cursor > begin) {
+                    add_word(begin, cursor);
+                }
+                // separators are words in their own right, but spaces aren't
+                if (c != ' ') {
+                    add_word(cursor, cursor + 1);
+                }
+                begin = cursor + 1;
+            }
+        }
+        if (cursor > begin) {
+            add_word(begin, cursor);
+        }
+        this->_store_byte(parse + 1u, (Byte)words);
+    }
+
+    constexpr ZMachine::ZMachineImpl::Handler ZMachine::ZMachineImpl::_handler_for(
+        Instruction::Category category,
+        Instruction::Opcode opcode
+    ) {
+        switch (category) {
+        case Instruction::Category::VAR:
+            switch (opcode) {
+            case 0x00: return Handler::op_call;
+            case 0x01: return Handler::op_storew;
+            case 0x02: return Handler::op_storeb;
+            case 0x04: return Handler::op_sread;
+            case 0x05: return Handler::op_print_char;
+            case 0x06: return Handler::op_print_num;
+            case 0x08: return Handler::op_push;
+            case 0x09: return Handler::op_pull;
+            case 0x13: return Handler::op_output_stream;
+            default: return Handler::op_unimplemented;
+            }
+        case Instruction::Category::_2OP:
+            switch (opcode) {
+            case 0x01: return Handler::op_je;
+            case 0x02: return Handler::op_jl;
+            case 0x03: return Handler::op_jg;
+            case 0x04: return Handler::op_dec_chk;
+            case 0x05: return Handler::op_inc_chk;
+            case 0x07: return Handler::op_test;
+            case 0x08: return Handler::op_or;
+            case 0x09: return Handler::op_and;
+            case 0x0a: return Handler::op_test_attr;
+            case 0x0d: return Handler::op_store;
+            case 0x0f: return Handler::op_loadw;
+            case 0x10: return Handler::op_loadb;
+            case 0x11: return Handler::op_get_prop;
+            case 0x12: return Handler::op_get_prop_addr;
+            case 0x13: return Handler::op_get_next_prop;
+            case 0x14: return Handler::op_add;
+            case 0x15: return Handler::op_sub;
+            case 0x16: return Handler::op_mul;
+            case 0x17: return Handler::op_div;
+            case 0x18: return Handler::op_mod;
+            default: return Handler::op_unimplemented;
+            }
+        case Instruction::Category::_1OP:
+            switch (opcode) {
+            case 0x0: return Handler::op_jz;
+            case 0x1: return Handler::op_get_sibling;
+            case 0x2: return Handler::op_get_child;
+            case 0x3: return Handler::op_get_parent;
+            case 0x4: return Handler::op_get_prop_len;
+            case 0x5: return Handler::op_inc;
+            case 0x6: return Handler::op_dec;
+            case 0x7: return Handler::op_print_addr;
+            case 0xb: return Handler::op_ret;
+            case 0xc: return Handler::op_jump;
+            case 0xd: return Handler::op_print_paddr;
+            case 0xe: return Handler::op_load;
+            case 0xf: return Handler::op_not;
+            default: return Handler::op_unimplemented;
+            }
+        case Instruction::Category::_0OP:
+            switch (opcode) {
+            case 0x0: return Handler::op_rtrue;
+            case 0x1: return Handler::op_rfalse;
+            case 0x2: return Handler::op_print;
+            case 0x3: return Handler::op_print_ret;
+            case 0x4: return Handler::op_nop;
+            case 0x5: return Handler::op_save;
+            case 0x6: return Handler::op_restore;
+            case 0x8: return Handler::op_ret_popped;
+            case 0x9: return Handler::op_pop;
+            case 0xa: return Handler::op_quit;
+            case 0xb: return Handler::op_new_line;
+            default: return Handler::op_unimplemented;
+            }
+        default:
+            return Handler::op_unimplemented;
+        }
+    }
+
+    constexpr std::array<ZMachine::ZMachineImpl::Handler, 256> ZMachine::ZMachineImpl::_build_handler_table() {
+        std::array<Handler, 256> table = {};
+        for (std::size_t i = 0; i < table.size(); i++) {
+            Byte first = (Byte)i;
+            // this follows the same rules as Instruction::decode() uses to categorise instructions
+            switch (first >> 6) {
+            case 0b11: // variable form --bit 5 distinguishes 2OP from VAR
+                table[i] = _handler_for(
+                    (first & 0b00100000) == 0 ? Instruction::Category::_2OP : Instruction::Category::VAR,
+                    first & 0b00011111
+                );
+                break;
+            case 0b10: // short form --operand type of OMITTED means 0OP
+                table[i] = _handler_for(
+                    (first & 0b00110000) == 0b00110000 ? Instruction::Category::_0OP : Instruction::Category::_1OP,
+                    first & 0b00001111
+                );
+                break;
+            default: // long form is always 2OP
+                table[i] = _handler_for(Instruction::Category::_2OP, first & 0b00011111);
+                break;
+            }
+        }
+        return table;
+    }
+
+    const std::array<ZMachine::ZMachineImpl::Handler, 256> ZMachine::ZMachineImpl::HANDLER_TABLE = _build_handler_table();
+
+    bool ZMachine::ZMachineImpl::_is_blocked() const {
+        return not this->_is_running or this->_waiting_for_input;
+    }
+
+    ZMachine::Status ZMachine::ZMachineImpl::_blocked_status() const {
+        return this->_is_running ? ZMachine::Status::WaitingForInput : ZMachine::Status::Quit;
+    }
+
+// executes the given call of a handler, counting it if opcode stats are built in
+#ifdef ZENCH_STATS
+    #define ZENCH_EXECUTE(handler, call) this->_execute_counted(handler, [&] { call; })
+#else
+    #define ZENCH_EXECUTE(handler, call) call
+#endif
+
+    void ZMachine::ZMachineImpl::execute_next_instruction() {
+        const Instruction& instruction = this->_fetch_instruction(); // advances pc
+        Handler handler = this->_dispatch == ZMachine::Dispatch::Threaded ?
+            HANDLER_TABLE[instruction.opcode_byte] :
+            _handler_for(instruction.category, instruction.opcode);
+        ZENCH_EXECUTE(handler, (this->*HANDLERS[(std::size_t)handler])(instruction));
+        this->_instructions++;
+        if (this->_profiler and this->_profiler->advance(1)) {
+            this->_profiler->sample(this->_stack);
+        }
+    }
+
+    ZMachine::Status ZMachine::ZMachineImpl::_run_dispatch(std::size_t max_instructions, std::size_t& executed) {
+        // counted once per run rather than per instruction, so it costs nothing in the loops
+        try {
+            ZMachine::Status status = this->_dispatch == ZMachine::Dispatch::Threaded ?
+                this->_run_threaded(max_instructions, executed) :
+                this->_run_switch(max_instructions, executed);
+            this->_instructions += executed;
+            return status;
+        } catch (...) {
+            // the loops leave executed as the instructions completed before the one which threw
+            this->_instructions += executed;
+            throw;
+        }
+    }
+
+    ZMachine::Status ZMachine::ZMachineImpl::_run_switch(std::size_t max_instructions, std::size_t& executed) {
+        for (executed = 0; executed < max_instructions; executed++) {
+            if (this->_is_blocked()) {
+                return this->_blocked_status();
+            }
+            const Instruction& instruction = this->_fetch_instruction(); // advances pc
+            Handler handler = _handler_for(instruction.category, instruction.opcode);
+            ZENCH_EXECUTE(handler, (this->*HANDLERS[(std::size_t)handler])(instruction));
+        }
+        return this->_is_blocked() ? this->_blocked_status() : ZMachine::Status::BudgetExhausted;
+    }
+
+// computed goto ("labels as values") is a GNU extension, which Clang also supports
+#if defined(__GNUC__)
+    #define ZENCH_COMPUTED_GOTO
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+    ZMachine::Status ZMachine::ZMachineImpl::_run_threaded(std::size_t max_instructions, std::size_t& executed) {
+    #ifdef ZENCH_COMPUTED_GOTO
+        /*
+         * Each handler gets its own label, which ends by fetching the next
+         * instruction and jumping straight to the label for its opcode byte.
+         * That gives every handler its own indirect branch, which the CPU can
+         * predict far better than the single one in a loop.
+         */
+        static void* const LABELS[] = {
+        #define ZENCH_HANDLER_LABEL_ADDRESS(name) &&label_##name,
+            ZENCH_OPCODES(ZENCH_HANDLER_LABEL_ADDRESS)
+        #undef ZENCH_HANDLER_LABEL_ADDRESS
+        };
+        // label addresses are constant, so the table is only built on the first run
+        static const std::array<void*, 256> dispatch_table = [] {
+            std::array<void*, 256> table;
+            for (std::size_t i = 0; i < table.size(); i++) {
+                table[i] = LABELS[(std::size_t)HANDLER_TABLE[i]];
+            }
+            return table;
+        }();
+        std::size_t remaining = max_instructions;
+        const Instruction* instruction = nullptr;
+        try {
+        dispatch:
+            if (this->_is_blocked()) {
+                executed = max_instructions - remaining;
+                return this->_blocked_status();
+            }
+            if (remaining == 0) {
+                executed = max_instructions;
+                return ZMachine::Status::BudgetExhausted;
+            }
+            remaining--;
+            instruction = &this->_fetch_instruction(); // advances pc
+            goto *dispatch_table[instruction->opcode_byte];
+        #define ZENCH_HANDLER_LABEL(name) \
+            label_##name: \
+                ZENCH_EXECUTE(Handler::op_##name, this->_opcode_##name(*instruction)); \
+                goto dispatch;
+            ZENCH_OPCODES(ZENCH_HANDLER_LABEL)
+        #undef ZENCH_HANDLER_LABEL
+        } catch (...) {
+            // the instruction which threw was counted off before it was fetched
+            executed = max_instructions - remaining - 1;
+            throw;
+        }
+    #else
+        // no computed goto, so fall back to calling through the flat table
+        for (executed = 0; executed < max_instructions; executed++) {
+            if (this->_is_blocked()) {
+                return this->_blocked_status();
+            }
+            const Instruction& instruction = this->_fetch_instruction(); // advances pc
+            Handler handler = HANDLER_TABLE[instruction.opcode_byte];
+            ZENCH_EXECUTE(handler, (this->*HANDLERS[(std::size_t)handler])(instruction));
+        }
+        return this->_is_blocked() ? this->_blocked_status() : ZMachine::Status::BudgetExhausted;
+    #endif
+    }
+#if defined(__GNUC__)
+    #pragma GCC diagnostic pop
+#endif
+#undef ZENCH_EXECUTE
+
+    void ZMachine::ZMachineImpl::_read_2op(const Instruction& instruction, Word& a, Word& b) {
+        if (instruction.operand_count != 2) {
+            throw WrongNumberOfInstructionOperandsException();
+        }
+        a = this->_operand_value(instruction, 0);
+        b = this->_operand_value(instruction, 1);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_unimplemented(const Instruction&) {
+        throw UnimplementedInstructionException();
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_je(const Instruction& instruction) {
+        // je with just 1 operand is not permitted
+        if (instruction.operand_count < 2) {
+            throw WrongNumberOfInstructionOperandsException();
+        }
+        // jump if first operand is equal to any subsequent operands
+        // NOTE: every operand is read, so the stack is popped consistently
+        Word first = this->_operand_value(instruction, 0);
+        bool equal = false;
+        for (std::size_t i = 1; i < instruction.operand_count; i++) {
+            equal = (this->_operand_value(instruction, i) == first) or equal;
+        }
+        this->_branch(instruction, equal);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_jl(const Instruction& instruction) {
+        Word a, b;
+        this->_read_2op(instruction, a, b);
+        // comparison is *signed*
+        this->_branch(instruction, std::less<SWord>{}((SWord)a, (SWord)b));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_jg(const Instruction& instruction) {
+        Word a, b;
+        this->_read_2op(instruction, a, b);
+        // comparison is *signed*
+        this->_branch(instruction, std::greater<SWord>{}((SWord)a, (SWord)b));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_dec_chk(const Instruction& instruction) {
+        Word variable, threshold;
+        this->_read_2op(instruction, variable, threshold);
+        SWord value = (SWord)(this->_load_variable_in_place((Byte)variable) - 1);
+        this->_store_variable_in_place((Byte)variable, (Word)value);
+        this->_branch(instruction, value < (SWord)threshold);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_inc_chk(const Instruction& instruction) {
+        Word variable, threshold;
+        this->_read_2op(instruction, variable, threshold);
+        SWord value = (SWord)(this->_load_variable_in_place((Byte)variable) + 1);
+        this->_store_variable_in_place((Byte)variable, (Word)value);
+        this->_branch(instruction, value > (SWord)threshold);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_test(const Instruction& instruction) {
+        Word bitmap, flags;
+        this->_read_2op(instruction, bitmap, flags);
+        this->_branch(instruction, (bitmap & flags) == flags);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_or(const Instruction& instruction) {
+        Word a, b;
+        this->_read_2op(instruction, a, b);
+        this->_store_variable(instruction.store_variable, a | b);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_and(const Instruction& instruction) {
+        Word a, b;
+        this->_read_2op(instruction, a, b);
+        this->_store_variable(instruction.store_variable, a & b);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_test_attr(const Instruction& instruction) {
+        Word object, attribute;
+        this->_read_2op(instruction, object, attribute);
+        this->_branch(instruction, this->_covering([&] { return this->_objects.attribute(object, attribute); }));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_store(const Instruction& instruction) {
+        Word variable, value;
+        this->_read_2op(instruction, variable, value);
+        // set the variable referenced by the first operand to the value of the second
+        this->_store_variable_in_place((Byte)variable, value);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_loadw(const Instruction& instruction) {
+        Word array, word_index;
+        this->_read_2op(instruction, array, word_index);
+        // calculate absolute address of Word to load
+        ByteAddress address = (ByteAddress)(array + 2 * word_index); // may overflow, ignore
+        // read Word as long as address is in range of memory
+        Word value = address + 1u < this->_image.size() ? this->_load_word(address) : 0;
+        this->_store_variable(instruction.store_variable, value);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_loadb(const Instruction& instruction) {
+        Word array, byte_index;
+        this->_read_2op(instruction, array, byte_index);
+        // calculate absolute address of Byte to load
+        ByteAddress address = (ByteAddress)(array + byte_index); // may overflow, ignore
+        // read Byte as long as address is in range of memory
+        Word value = address < this->_image.size() ? this->_load_byte(address) : 0;
+        this->_store_variable(instruction.store_variable, value);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_get_prop(const Instruction& instruction) {
+        Word object, number;
+        this->_read_2op(instruction, object, number);
+        const ObjectTable::Property& property = this->_property(object, number);
+        Word value;
+        if (property.data == 0) {
+            value = this->_objects.property_default(number);
+        } else if (property.length == 1) {
+            value = this->_load_byte(property.data);
+        } else if (property.length == 2) {
+            value = this->_load_word(property.data);
+        } else {
+            throw Exception(); // ERROR! get_prop can only read properties of 1 or 2 bytes
+        }
+        this->_store_variable(instruction.store_variable, value);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_get_prop_addr(const Instruction& instruction) {
+        Word object, number;
+        this->_read_2op(instruction, object, number);
+        this->_store_variable(instruction.store_variable, this->_property(object, number).data);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_get_next_prop(const Instruction& instruction) {
+        Word object, number;
+        this->_read_2op(instruction, object, number);
+        // property 0 asks for the first property
+        if (number == 0) {
+            return this->_store_variable(instruction.store_variable, this->_properties(object)[0].next);
+        }
+        const ObjectTable::Property& property = this->_property(object, number);
+        if (property.data == 0) {
+            throw Exception(); // ERROR! the object hasn't got the property to find the next of
+        }
+        this->_store_variable(instruction.store_variable, property.next);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_add(const Instruction& instruction) {
+        Word a, b;
+        this->_read_2op(instruction, a, b);
+        this->_store_variable(instruction.store_variable, (Word)(a + b));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_sub(const Instruction& instruction) {
+        Word a, b;
+        this->_read_2op(instruction, a, b);
+        this->_store_variable(instruction.store_variable, (Word)(a - b));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_mul(const Instruction& instruction) {
+        Word a, b;
+        this->_read_2op(instruction, a, b);
+        this->_store_variable(instruction.store_variable, (Word)(a * b));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_div(const Instruction& instruction) {
+        Word a, b;
+        this->_read_2op(instruction, a, b);
+        if (b == 0) {
+            throw DivisionByZeroException();
+        }
+        // signed, rounding towards zero
+        this->_store_variable(instruction.store_variable, (Word)((SWord)a / (SWord)b));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_mod(const Instruction& instruction) {
+        Word a, b;
+        this->_read_2op(instruction, a, b);
+        if (b == 0) {
+            throw DivisionByZeroException();
+        }
+        // signed, sign of result follows the dividend
+        this->_store_variable(instruction.store_variable, (Word)((SWord)a % (SWord)b));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_jz(const Instruction& instruction) {
+        // jump if zero (also obey on-true/on-false specifier)
+        this->_branch(instruction, this->_operand_value(instruction, 0) == 0);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_get_sibling(const Instruction& instruction) {
+        Word object = this->_operand_value(instruction, 0);
+        Word sibling = this->_covering([&] { return this->_objects.sibling(object); });
+        this->_store_variable(instruction.store_variable, sibling);
+        this->_branch(instruction, sibling != 0);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_get_child(const Instruction& instruction) {
+        Word object = this->_operand_value(instruction, 0);
+        Word child = this->_covering([&] { return this->_objects.child(object); });
+        this->_store_variable(instruction.store_variable, child);
+        this->_branch(instruction, child != 0);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_get_parent(const Instruction& instruction) {
+        Word object = this->_operand_value(instruction, 0);
+        this->_store_variable(instruction.store_variable, this->_covering([&] { return this->_objects.parent(object); }));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_get_prop_len(const Instruction& instruction) {
+        Word address = this->_operand_value(instruction, 0);
+        // the size byte just before a property's data gives its length --0 is what get_prop_addr gives if there's none
+        Word length = address == 0 ? 0 : (Word)((this->_load_byte(address - 1u) >> 5) + 1);
+        this->_store_variable(instruction.store_variable, length);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_inc(const Instruction& instruction) {
+        Byte variable = (Byte)this->_operand_value(instruction, 0);
+        this->_store_variable_in_place(variable, (Word)(this->_load_variable_in_place(variable) + 1));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_dec(const Instruction& instruction) {
+        Byte variable = (Byte)this->_operand_value(instruction, 0);
+        this->_store_variable_in_place(variable, (Word)(this->_load_variable_in_place(variable) - 1));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_print_addr(const Instruction& instruction) {
+        this->_print_z_string(this->_operand_value(instruction, 0));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_ret(const Instruction& instruction) {
+        // return operand value
+        this->_return_value(this->_operand_value(instruction, 0));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_jump(const Instruction& instruction) {
+        // the jump address is a 2-byte signed offset to apply to the PC
+        SWord offset = (SWord)this->_operand_value(instruction, 0);
+        /*
+         * The destination of the jump opcode is:
+         * Address after instruction + Offset - 2
+         */
+        this->_pc = (Address)((int)this->_pc + offset - 2);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_print_paddr(const Instruction& instruction) {
+        this->_print_z_string(this->_expand_packed_address(this->_operand_value(instruction, 0)));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_load(const Instruction& instruction) {
+        // The value of the variable referred to by the operand is stored in the result.
+        Byte variable = (Byte)this->_operand_value(instruction, 0);
+        this->_store_variable(instruction.store_variable, this->_load_variable_in_place(variable));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_not(const Instruction& instruction) {
+        this->_store_variable(instruction.store_variable, (Word)~this->_operand_value(instruction, 0));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_rtrue(const Instruction&) {
+        this->_return_value(1); // true=1
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_rfalse(const Instruction&) {
+        this->_return_value(0); // false=0
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_print(const Instruction& instruction) {
+        this->_print_z_string(
+            instruction.location + instruction.literal_offset,
+            instruction.trailing_string_literal(this->_memory_view(instruction.location))
+        );
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_print_ret(const Instruction& instruction) {
+        this->_print_z_string(
+            instruction.location + instruction.literal_offset,
+            instruction.trailing_string_literal(this->_memory_view(instruction.location))
+        );
+        this->_new_line();
+        this->_return_value(1);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_nop(const Instruction&) {}
+
+    void ZMachine::ZMachineImpl::_opcode_save(const Instruction& instruction) {
+        // in V1-3, the saved PC is the address of this instruction's branch data, so that restore can take the branch
+        std::vector<Byte> saved_game = Quetzal::save(
+            this->_image,
+            std::span<const Byte>{this->_dynamic_memory}.first(this->_static_memory_begin),
+            this->_stack,
+            instruction.location + 1u
+        );
+        bool saved = false;
+        if (auto file = this->_filesystem.open_for_write(); file != nullptr) {
+            saved = file->write(saved_game);
+            file->close();
+        }
+        this->_branch(instruction, saved);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_restore(const Instruction& instruction) {
+        std::optional<Quetzal::SavedGame> saved_game;
+        if (auto file = this->_filesystem.open_for_read(); file != nullptr) {
+            saved_game = Quetzal::restore(this->_image, Quetzal::read(*file), STACK_SIZE);
+            file->close();
+        }
+        // the saved PC must point just after a save instruction (which is only ever 1 byte long)
+        Address save_location = saved_game ? saved_game->pc - 1u : 0;
+        auto saved_byte = [&](Address address) {
+            return address < this->_static_memory_begin ? saved_game->dynamic_memory[address] : this->_load_byte(address);
+        };
+        if (not saved_game or saved_game->pc == 0 or saved_game->pc >= this->_image.size() or saved_byte(save_location) != 0xB5) {
+            // restore failed, nothing has been changed
+            return this->_branch(instruction, false);
+        }
+        // the transcripting and fixed-pitch bits of Flags 2 survive a restore
+        saved_game->dynamic_memory[0x11] = (Byte)(
+            (saved_game->dynamic_memory[0x11] & ~0b11u) | (this->_dynamic_memory[0x11] & 0b11u)
+        );
+        /*
+         * only write the bytes which differ, through the write barrier so any
+         * cached instructions are dropped. Most blocks are unchanged and are
+         * skipped with a single comparison.
+         */
+        constexpr std::size_t BLOCK = 64;
+        for (Address block = 0; block < this->_static_memory_begin; block += BLOCK) {
+            std::size_t length = std::min<std::size_t>(BLOCK, this->_static_memory_begin - block);
+            if (std::memcmp(&this->_dynamic_memory[block], &saved_game->dynamic_memory[block], length) == 0) {
+                continue;
+            }
+            for (Address a = block; a < block + length; a++) {
+                if (this->_dynamic_memory[a] != saved_game->dynamic_memory[a]) {
+                    this->_store_byte(a, saved_game->dynamic_memory[a]);
+                }
+            }
+        }
+        this->_stack = std::move(saved_game->stack);
+        // carry on from the save instruction as though it had just succeeded
+        Address pc;
+        Instruction save = this->_covering([&] {
+            pc = save_location;
+            return Instruction::decode(pc, this->_memory_view(save_location));
+        });
+        this->_pc = pc;
+        this->_branch(save, true);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_ret_popped(const Instruction&) {
+        // pop top of stack and return that
+        this->_return_value(this->_load_variable(0x00));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_pop(const Instruction&) {
+        // throw top value of stack away
+        this->_load_variable(0x00);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_quit(const Instruction&) {
+        this->_flush_output(true);
+        this->_is_running = false;
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_new_line(const Instruction&) {
+        this->_new_line();
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_call(const Instruction& instruction) {
+        // must have 1..4 operands --routine address + 0..3 arguments
+        if (not (0 < instruction.operand_count and instruction.operand_count <= 4)) {
+            throw WrongNumberOfInstructionOperandsException();
+        }
+        // arguments must all be read, even for the null routine, so that the stack is popped consistently
+        Word arguments[3] = {};
+        Address routine_address = this->_expand_packed_address(this->_operand_value(instruction, 0));
+        std::size_t args_count = instruction.operand_count - 1;
+        for (std::size_t a = 0; a < args_count; a++) {
+            arguments[a] = this->_operand_value(instruction, 1 + a);
+        }
+        // handle special case: call address 0 returns false (0)
+        if (routine_address == 0) {
+            return this->_store_variable(instruction.store_variable, 0);
+        }
+        Byte locals_count = this->_load_byte(routine_address);
+        if (locals_count > 15) {
+            throw Exception(); // ERROR! routines can't have more than 15 locals
+        }
+        this->_stack.push_frame(
+            this->_pc, // return address, i.e. the byte after this call instruction
+            instruction.store_variable,
+            args_count,
+            locals_count,
+            routine_address
+        );
+        // populate local variables from the routine header
+        for (Byte l = 0; l < locals_count; l++) {
+            this->_stack.local(l + 1u) = this->_load_word(routine_address + 1u + l * 2u);
+        }
+        // now, write in any arguments to local variables, but stop when the range of either is exceeded
+        for (std::size_t a = 0; a < locals_count and a < args_count; a++) {
+            this->_stack.local((Byte)(a + 1u)) = arguments[a];
+        }
+        // finally, move PC to new routine
+        this->_pc = routine_address + 1u + locals_count * 2u; // start execution from end of routine header
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_storew(const Instruction& instruction) {
+        // must have three operands --array, word_index and value
+        if (instruction.operand_count != 3) {
+            throw WrongNumberOfInstructionOperandsException();
+        }
+        // gather operands
+        ByteAddress array = this->_operand_value(instruction, 0);
+        ByteAddress word_index = this->_operand_value(instruction, 1);
+        Word value = this->_operand_value(instruction, 2);
+        // calculate absolute address of Word to store
+        ByteAddress address = (ByteAddress)(array + 2 * word_index); // may overflow, ignore
+        // write Word as long as both of its bytes may be written by Z-code
+        if (this->_writable(address) and this->_writable(address + 1u)) {
+            this->_store_word(address, value);
+        }
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_storeb(const Instruction& instruction) {
+        // must have three operands --array, byte_index and value
+        if (instruction.operand_count != 3) {
+            throw WrongNumberOfInstructionOperandsException();
+        }
+        // gather operands
+        ByteAddress array = this->_operand_value(instruction, 0);
+        ByteAddress byte_index = this->_operand_value(instruction, 1);
+        Word value = this->_operand_value(instruction, 2);
+        // calculate absolute address of Byte to store
+        ByteAddress address = (ByteAddress)(array + byte_index); // may overflow, ignore
+        // write byte as long as it may be written by Z-code
+        if (this->_writable(address)) {
+            this->_store_byte(address, (Byte)value);
+        }
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_sread(const Instruction& instruction) {
+        // must have two operands --text buffer and parse buffer
+        if (instruction.operand_count != 2) {
+            throw WrongNumberOfInstructionOperandsException();
+        }
+        // NOTE: V3 redisplays the status line here, but Screen has nowhere to show one yet
+        // everything printed so far must be shown before the player can answer it
+        this->_flush_output(false);
+        // each turn starts at a READ, so that's where it can be undone back to
+        if (not this->_reading) {
+            this->_reading = true;
+            this->_undo.save(
+                std::span<const Byte>{this->_dynamic_memory}.first(this->_static_memory_begin),
+                this->_stack,
+                instruction.location
+            );
+        }
+        /*
+         * if the line isn't complete yet, rewind so that this instruction is
+         * re-executed next time round. Operands aren't read until the line is
+         * complete so that any stack operands are only popped once.
+         */
+        this->_waiting_for_input = not this->_read_line();
+        if (this->_waiting_for_input) {
+            this->_pc = instruction.location;
+            return;
+        }
+        this->_reading = false;
+        ByteAddress text = this->_operand_value(instruction, 0);
+        ByteAddress parse = this->_operand_value(instruction, 1);
+        // in V1-4, byte 0 of the text buffer holds the maximum number of characters plus one
+        std::size_t max_length = this->_load_byte(text) > 0 ? this->_load_byte(text) - 1u : 0u;
+        std::size_t length = std::min(max_length, this->_input_line.size());
+        if (text + 1u + length >= this->_static_memory_begin) {
+            throw IllegalMemoryWriteException();
+        }
+        for (std::size_t i = 0; i < length; i++) {
+            this->_store_byte(text + 1u + (Address)i, this->_input_line[i]);
+        }
+        this->_store_byte(text + 1u + (Address)length, 0);
+        // the command stored goes into the transcript after the prompt, and into the command script on its own
+        for (AsyncWriter* writer : {
+            this->_transcribing() ? this->_transcript.get() : nullptr,
+            this->_commands_script_selected ? this->_commands_script.get() : nullptr,
+        }) {
+            if (writer != nullptr) {
+                for (std::size_t i = 0; i < length; i++) {
+                    writer->write(this->_decoder.zscii_to_utf8(this->_input_line[i]));
+                }
+                writer->write('\n');
+            }
+        }
+        this->_input_line.clear();
+        // a dictionary in dynamic memory may run on into static memory
+        Dictionary dictionary = this->_covering([this] {
+            return Dictionary(this->_version, this->_memory_view(this->_dictionary_address), this->_dictionary_address);
+        });
+        if (not this->_dictionary_index) {
+            this->_dictionary_index.emplace(dictionary);
+            // Z-code may modify a dictionary in dynamic memory, which must then be indexed again
+            if (this->_dictionary_address < this->_static_memory_begin) {
+                this->_indexed_dictionary_length = dictionary.end() - this->_dictionary_address;
+            }
+        }
+        this->_tokenise(
+            text,
+            parse,
+            Dictionary(
+                this->_version,
+                this->_memory_view(this->_dictionary_address),
+                this->_dictionary_address,
+                &*this->_dictionary_index
+            )
+        );
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_print_char(const Instruction& instruction) {
+        // must have 1 operand only --the ZSCII character to print
+        if (instruction.operand_count != 1) {
+            throw WrongNumberOfInstructionOperandsException();
+        }
+        Word zscii = this->_operand_value(instruction, 0);
+        if (zscii == 13) {
+            this->_new_line();
+        } else {
+            this->_print(this->_decoder.zscii_to_utf8(zscii));
+        }
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_print_num(const Instruction& instruction) {
+        // must have 1 operand only --the signed number to print
+        if (instruction.operand_count != 1) {
+            throw WrongNumberOfInstructionOperandsException();
+        }
+        SWord number = (SWord)this->_operand_value(instruction, 0);
+        char digits[8];
+        auto [end, error] = std::to_chars(std::begin(digits), std::end(digits), number);
+        this->_print(std::string_view(digits, (std::size_t)(end - digits)));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_push(const Instruction& instruction) {
+        // must have 1 operand only --the value to push
+        if (instruction.operand_count != 1) {
+            throw WrongNumberOfInstructionOperandsException();
+        }
+        this->_store_variable(0x00, this->_operand_value(instruction, 0));
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_pull(const Instruction& instruction) {
+        // must have 1 operand only --the number of the variable to pull into
+        if (instruction.operand_count != 1) {
+            throw WrongNumberOfInstructionOperandsException();
+        }
+        Byte variable = (Byte)this->_operand_value(instruction, 0);
+        Word value = this->_load_variable(0x00);
+        this->_store_variable_in_place(variable, value);
+    }
+
+    void ZMachine::ZMachineImpl::_opcode_output_stream(const Instruction& instruction) {
+        // must have 1 operand only in V3 --the stream to select, or if negative to deselect
+        if (instruction.operand_count != 1) {
+            throw WrongNumberOfInstructionOperandsException();
+        }
+        int stream = (SWord)this->_operand_value(instruction, 0);
+        bool selected = stream > 0;
+        switch (selected ? stream : -stream) {
+        case 0: // selects nothing
+            break;
+        case 1: // the screen
+            this->_screen_selected = selected;
+            break;
+        case 2: // the transcript, which is opened the first time anything is printed to it
+            this->_store_byte(
+                0x11,
+                (Byte)(selected ? this->_dynamic_memory[0x11] | 0b1u : this->_dynamic_memory[0x11] & ~0b1u)
+            );
+            break;
+        case 3: // memory
+            throw Exception(); // ERROR! output stream 3 is not supported yet
+        case 4: // the script of commands typed, which stays selected only if there's somewhere to write it
+            if (selected and this->_commands_script == nullptr) {
+                if (auto file = this->_filesystem.open_for_write(); file != nullptr) {
+                    this->_commands_script = std::make_unique<AsyncWriter>(std::move(file));
+                }
+            }
+            this->_commands_script_selected = selected and this->_commands_script != nullptr;
+            break;
+        default:
+            throw Exception(); // ERROR! no such output stream
+        }
+    }
 }
@@ -15,31 +15,359 @@
 #ifndef COM_SAXBOPHONE_ZENCH_ZMACHINE_IMPL_HPP
 #define COM_SAXBOPHONE_ZENCH_ZMACHINE_IMPL_HPP
 
-#include <memory>   // unique_ptr
+#include <cstddef>       // size_t
+#include <cstdint>       // uint64_t
+
+#include <algorithm>     // min
+#include <array>         // array
+#include <bit>           // bit_width
+#include <chrono>        // duration_cast, nanoseconds, steady_clock
+#include <deque>         // deque
+#include <exception>     // exception_ptr
+#include <memory>        // shared_ptr, unique_ptr
+#include <optional>      // optional
+#include <span>          // span
+#include <string>        // string
+#include <string_view>   // string_view
+#include <unordered_map> // unordered_map
+#include <vector>        // vector
 
 #include <zench/FileSystem.hpp>
 #include <zench/Keyboard.hpp>
+#include <zench/RingKeyboard.hpp>
 #include <zench/Screen.hpp>
+#include <zench/StoryImage.hpp>
 #include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+#include "AsyncWriter.hpp"
+#include "Dictionary.hpp"
+#include "Instruction.hpp"
+#include "ObjectTable.hpp"
+#include "Opcodes.hpp"
+#include "Profiler.hpp"
+#include "ScreenBuffer.hpp"
+#include "Stack.hpp"
+#include "UndoRing.hpp"
+#include "ZStringDecoder.hpp"
 
 namespace com::saxbophone::zench {
     class ZMachine::ZMachineImpl {
     public:
+        /*
+         * Bytes of static memory copied along with dynamic memory, so that
+         * instructions and tables which straddle the end of dynamic memory
+         * can still be read contiguously. Anything running on further than
+         * this gets more of static memory copied when it's read.
+         */
+        static constexpr std::size_t DYNAMIC_MEMORY_OVERHANG = 256;
+        // in Words, shared by all routines --far deeper than any real story file needs
+        static constexpr std::size_t STACK_SIZE = 16 * 1024;
+
+        // identifies each of the opcode handlers listed in ZENCH_OPCODES
+        enum class Handler : Byte {
+        #define ZENCH_HANDLER_ENUM(name) op_##name,
+            ZENCH_OPCODES(ZENCH_HANDLER_ENUM)
+        #undef ZENCH_HANDLER_ENUM
+        };
+        using OpcodeHandler = void (ZMachineImpl::*)(const Instruction& instruction);
+        /*
+         * A decoded instruction, threaded to the instruction which follows it
+         * in memory, so that straight-line code can be fetched without
+         * looking each instruction up.
+         */
+        struct CachedInstruction {
+            Instruction instruction;
+            CachedInstruction* next = nullptr; // the instruction starting at end, once it's been cached
+        };
+
         ZMachineImpl(
-            FileSystem::InputFile& story_file,
+            std::shared_ptr<const StoryImage> story,
             FileSystem& fs,
             Screen& screen,
-            Keyboard& keyboard
+            Keyboard& keyboard,
+            ZMachine::Dispatch dispatch
         );
+        // returns true if a runnable machine has not quit
+        bool is_ready() const;
+        // NOTE: this method advances the Program Counter (_pc)
+        void execute_next_instruction();
+        // executes instructions until the budget runs out or execution can't continue
+        ZMachine::Status run(std::size_t max_instructions);
+        std::exception_ptr error() const;
+        void set_undo_budget(std::size_t bytes);
+        std::size_t undo_depth() const;
+        bool undo(std::size_t turns);
+        // hands everything printed so far to the Screen
+        void flush_screen();
+        ZMachine::Stats stats() const;
+        void reset_stats();
+        std::uint64_t instructions() const;
+        void set_profiling_interval(std::size_t instructions);
+        std::string profile() const;
     private:
+        // with opcode stats built in, one in this many executions is timed
+        static constexpr std::size_t STATS_SAMPLE_INTERVAL = 64;
+
+        // works out which handler implements the given opcode (the nested switch of the Switch engine)
+        static constexpr Handler _handler_for(Instruction::Category category, Instruction::Opcode opcode);
+        // works out which handler implements the opcode starting with each possible first byte
+        static constexpr std::array<Handler, 256> _build_handler_table();
+        // the run() loop of each dispatch engine
+        ZMachine::Status _run_switch(std::size_t max_instructions, std::size_t& executed);
+        ZMachine::Status _run_threaded(std::size_t max_instructions, std::size_t& executed);
+        // runs the loop of whichever engine was chosen, setting executed to the instructions it executed
+        ZMachine::Status _run_dispatch(std::size_t max_instructions, std::size_t& executed);
+        // whether the last instruction executed means that run() must stop
+        bool _is_blocked() const;
+        // the reason that run() must stop, when _is_blocked()
+        ZMachine::Status _blocked_status() const;
+        // works out the memory map and takes a private copy of dynamic memory
+        void _map_memory();
+        /*
+         * Fetches the instruction at the Program Counter and advances the
+         * Program Counter to the byte after it.
+         * Instructions are only decoded the first time they are encountered,
+         * after which they are served from _instruction_cache.
+         * NOTE: the returned reference is valid until the next call of this
+         * method, even if the instruction is overwritten whilst executing.
+         */
+        const Instruction& _fetch_instruction();
+        // returns the cached decoding of the instruction at location, decoding it if needed
+        CachedInstruction& _cache_instruction(Address location);
+        // drops any cached instructions overlapping dynamic memory that has
+        // been written to since the last fetch
+        void _invalidate_stale_instructions();
+
+        /*
+         * Returns a view of memory which can be indexed by address, over this
+         * machine's dynamic memory if address lies there, otherwise over the
+         * shared story image.
+         * NOTE: a view over dynamic memory only covers the start of static
+         * memory, reads through it which may run on further must be made
+         * with _covering(), and the view taken again on each try
+         */
+        std::span<const Byte> _memory_view(Address address) const;
+        /*
+         * Copies more of static memory after dynamic memory, returning false
+         * if all of it already is. This moves dynamic memory, so views of it
+         * must be taken again.
+         */
+        bool _cover_more_of_static_memory();
+        /*
+         * Returns read(), trying it again with more of static memory copied
+         * after dynamic memory for as long as it throws Exception and there's
+         * more to copy.
+         */
+        template <typename Read>
+        decltype(auto) _covering(Read read) {
+            while (true) {
+                try {
+                    return read();
+                } catch (const Exception&) {
+                    if (not this->_cover_more_of_static_memory()) {
+                        throw;
+                    }
+                }
+            }
+        }
+        Byte _load_byte(Address address) const;
+        Word _load_word(Address address) const;
+        // NOTE: these only write to dynamic memory and must be used for all writes
+        // made by Z-code, so that the instruction cache and undo ring stay coherent
+        void _store_byte(Address address, Byte value);
+        void _store_word(Address address, Word value);
+        // whether storew and storeb may write to address
+        bool _writable(Address address) const;
+
+        // reading variable 0x00 pops the stack, writing it pushes the stack
+        Word _load_variable(Byte number);
+        void _store_variable(Byte number, Word value);
+        /*
+         * Opcodes which take a variable by reference (inc, dec, load, store
+         * etc...) access the top of the stack in-place rather than pushing or
+         * popping it. These provide that behaviour.
+         */
+        Word _load_variable_in_place(Byte number);
+        void _store_variable_in_place(Byte number, Word value);
+
+        Address _expand_packed_address(PackedAddress packed) const;
+        // the layout of an object's property list, watching the bytes it comes from for changes
+        const ObjectTable::Properties& _properties(Word object);
+        // an object's property, throwing if it's not a valid property number
+        const ObjectTable::Property& _property(Word object, Word property);
+
+        // the bytes of the Z-string starting at address
+        std::span<const Byte> _z_string_at(Address address);
+        /*
+         * Prints the Z-string at address, whose bytes may be given if they're
+         * already known. Strings which Z-code can't modify are decoded once,
+         * by whichever machine playing the story prints them first.
+         */
+        void _print_z_string(Address address, std::span<const Byte> z_string = {});
+        // prints to each selected output stream
+        void _print(std::string_view text);
+        void _print(char character);
+        void _new_line();
+        /*
+         * Whether the transcript (output stream 2) is selected, opening it
+         * the first time that it is.
+         */
+        bool _transcribing();
+        /*
+         * Hands everything printed so far to the Screen and the files of the
+         * other output streams, waiting until it's written if wait is true.
+         */
+        void _flush_output(bool wait);
+
+        // looks up the operand type and global, local variables (if needed)
+        // returns the actual value intended, either literal or value stored in
+        // denoted variable
+        Word _operand_value(const Instruction& instruction, std::size_t operand);
+
+        // this executes the common "return value and pop the call stack" part of all return instructions
+        void _return_value(Word value);
+        // branches if condition matches the branch instruction's on-true/on-false specifier
+        void _branch(const Instruction& instruction, bool condition);
+
+        /*
+         * Polls the Keyboard for input, adding it to the line being typed.
+         * Returns true once the line has been completed with a newline, at
+         * which point it can be taken from _input_line.
+         */
+        bool _read_line();
+        // adds a key to the line being typed, returning true if it ends the line
+        bool _type_key(Keyboard::Event event);
+        /*
+         * Splits the text in the text buffer into words, looks each of them
+         * up in the dictionary and writes the results into the parse buffer.
+         */
+        void _tokenise(ByteAddress text, ByteAddress parse, const Dictionary& dictionary);
+
+        // reads both operands of a 2OP instruction, in order
+        void _read_2op(const Instruction& instruction, Word& a, Word& b);
+
+        // one method per opcode handler
+    #define ZENCH_HANDLER_DECLARATION(name) void _opcode_##name(const Instruction& instruction);
+        ZENCH_OPCODES(ZENCH_HANDLER_DECLARATION)
+    #undef ZENCH_HANDLER_DECLARATION
+        // the handler methods, indexed by Handler
+        static constexpr auto HANDLERS = std::to_array<OpcodeHandler>({
+        #define ZENCH_HANDLER_POINTER(name) &ZMachineImpl::_opcode_##name,
+            ZENCH_OPCODES(ZENCH_HANDLER_POINTER)
+        #undef ZENCH_HANDLER_POINTER
+        });
+        // which handler implements each opcode, indexed by the first byte of the instruction
+        static const std::array<Handler, 256> HANDLER_TABLE;
+        // the names of the opcodes, indexed by Handler
+        static constexpr auto HANDLER_NAMES = std::to_array<const char*>({
+        #define ZENCH_HANDLER_NAME(name) #name,
+            ZENCH_OPCODES(ZENCH_HANDLER_NAME)
+        #undef ZENCH_HANDLER_NAME
+        });
+#ifdef ZENCH_STATS
+        // executes a handler, counting it and timing one in every STATS_SAMPLE_INTERVAL executions
+        template <typename Execute>
+        void _execute_counted(Handler handler, Execute execute) {
+            ZMachine::OpcodeStats& stats = this->_opcode_stats[(std::size_t)handler];
+            stats.count++;
+            if (--this->_until_timed != 0) {
+                return execute();
+            }
+            this->_until_timed = STATS_SAMPLE_INTERVAL;
+            auto start = std::chrono::steady_clock::now();
+            execute();
+            auto nanoseconds = (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start
+            ).count();
+            stats.sampled++;
+            stats.nanoseconds += nanoseconds;
+            stats.histogram[std::min((std::size_t)std::bit_width(nanoseconds), ZMachine::TIMING_BUCKETS - 1)]++;
+        }
+#endif
+
         FileSystem& _filesystem;
         // output streams:
         Screen& _screen;
-        std::unique_ptr<FileSystem::OutputFile> _transcript;
-        std::unique_ptr<FileSystem::OutputFile> _commands_script;
+        // everything printed since the last READ, to be handed to _screen in one go
+        ScreenBuffer _output;
+        bool _screen_selected = true;
+        // written in the background, so that they cost a turn no more than printing to the screen
+        std::unique_ptr<AsyncWriter> _transcript; // selected by bit 0 of Flags 2
+        std::unique_ptr<AsyncWriter> _commands_script;
+        bool _commands_script_selected = false;
         // input streams:
         Keyboard& _keyboard;
+        // _keyboard, if it can be read from without allocating
+        RingKeyboard* _ring_keyboard;
         std::unique_ptr<FileSystem::InputFile> _file_with_commands;
+        // keyboard events received but not yet consumed by a READ
+        std::deque<Keyboard::Event> _pending_input;
+        // ZSCII characters of the line currently being typed
+        std::vector<Byte> _input_line;
+
+        ZMachine::Dispatch _dispatch;
+        ZVersion _version;
+        bool _is_running = false; // whether the machine has not quit
+        bool _waiting_for_input = false; // whether the last instruction blocked on a READ
+        bool _reading = false; // whether a READ has started but not yet received its line
+        std::exception_ptr _error; // the error which halted the machine, if any
+        std::optional<Profiler> _profiler; // samples the call stack, whilst profiling
+        std::uint64_t _instructions = 0; // executed in total, counted a run at a time
+#ifdef ZENCH_STATS
+        // indexed by Handler, with their names left out until a snapshot is taken
+        std::array<ZMachine::OpcodeStats, HANDLERS.size()> _opcode_stats = {};
+        std::size_t _until_timed = STATS_SAMPLE_INTERVAL; // executions until the next one to time
+#endif
+
+        ByteAddress _static_memory_begin; // derived from header
+        ByteAddress _high_memory_begin; // "high memory mark", derived from header
+        ByteAddress _globals_address; // global variables start here
+        ByteAddress _dictionary_address; // the standard dictionary starts here
+        // the standard dictionary's index, built at the first READ and dropped whenever the dictionary is written to
+        std::optional<Dictionary::Index> _dictionary_index;
+        // bytes of dynamic memory covered by the indexed dictionary, from _dictionary_address
+        Address _indexed_dictionary_length = 0;
+        // the object tree, with the property list layouts of objects used so far
+        ObjectTable _objects;
+
+        Address _pc = 0x000000; // program counter
+        /*
+         * The main memory of the VM is split in two: static and high memory
+         * can never be modified, so they are read straight from the story
+         * image, which is shared with any other ZMachines playing the same
+         * story. Only dynamic memory needs its own copy.
+         */
+        std::shared_ptr<const StoryImage> _story;
+        std::span<const Byte> _image; // the bytes of _story
+        std::vector<Byte> _dynamic_memory;
+        // expands abbreviations as they were when the story was loaded
+        ZStringDecoder _decoder{this->_story->version(), this->_story->bytes()};
+        // text of the Z-string being printed, kept between strings so that printing doesn't allocate
+        std::vector<char> _decoded_text = std::vector<char>(1024);
+        // function call stack, holding the locals and evaluation stacks of all routines
+        Stack _stack{STACK_SIZE};
+        // the state at each of the last few READs, for undoing turns
+        UndoRing _undo{ZMachine::DEFAULT_UNDO_BUDGET};
+        /*
+         * Instructions decoded so far, indexed by address.
+         * High memory can never be modified by Z-code, so instructions located
+         * there stay valid for the lifetime of the machine. Instructions which
+         * lie in dynamic memory are tracked by _watched_memory so that they
+         * can be dropped when Z-code writes over any of their bytes.
+         */
+        std::unordered_map<Address, CachedInstruction> _instruction_cache;
+        // the instruction fetched most recently
+        CachedInstruction* _last_fetched = nullptr;
+        // reasons to watch a byte of dynamic memory for writes, as flags
+        static constexpr Byte WATCH_CODE = 0b01; // a cached instruction covers it
+        static constexpr Byte WATCH_PROPERTY_LAYOUT = 0b10; // a cached property list layout was decoded from it
+        // flags for each byte of dynamic memory, so that the write barrier needs only check one byte
+        std::vector<Byte> _watched_memory;
+        // addresses of those cached instructions which start in dynamic memory
+        std::vector<Address> _cached_dynamic_instructions;
+        // addresses of cached code bytes written to since the last fetch
+        std::vector<Address> _stale_code;
     };
 }
 
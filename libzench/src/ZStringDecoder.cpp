@@ -0,0 +1,444 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstddef>      // ptrdiff_t, size_t
+#include <cstdint>      // uint16_t, uint32_t
+
+#include <algorithm>    // copy_n, min
+#include <array>        // array
+#include <bit>          // countr_zero
+#include <charconv>     // to_chars
+#include <optional>     // optional
+#include <span>         // span
+#include <string>       // string
+#include <string_view>  // string_view
+
+#if defined(__x86_64__) and defined(__GNUC__)
+// the AVX2 kernel is built whatever the target, and only run if the CPU has it
+#define ZENCH_UNPACK_AVX2
+#include <immintrin.h>  // AVX2 and SSE2 intrinsics
+#elif defined(__SSE2__)
+#include <emmintrin.h>  // SSE2 intrinsics
+#endif
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+#include "ZStringDecoder.hpp"
+
+namespace {
+    using namespace com::saxbophone::zench;
+
+    using ZChar = Byte;
+
+    enum Alphabet : std::size_t { A0 = 0, A1 = 1, A2 = 2, };
+
+    // ZSCII 32 to 126, which are the same as ASCII
+    constexpr std::string_view PRINTABLE_ASCII =
+        " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+    static_assert(PRINTABLE_ASCII.size() == 0x7f - 0x20);
+
+    // writes as much as fits into the caller's buffer, counting everything
+    class Output {
+    public:
+        Output(std::span<char> buffer) : _buffer(buffer) {}
+
+        void put(char character) {
+            if (this->_length < this->_buffer.size()) {
+                this->_buffer[this->_length] = character;
+            }
+            this->_length++;
+        }
+
+        void put(std::string_view text) {
+            if (this->_length < this->_buffer.size()) {
+                std::size_t fits = std::min(text.size(), this->_buffer.size() - this->_length);
+                std::copy_n(text.begin(), fits, this->_buffer.begin() + (std::ptrdiff_t)this->_length);
+            }
+            this->_length += text.size();
+        }
+
+        void put_number(std::size_t number) {
+            char digits[20];
+            auto result = std::to_chars(digits, digits + sizeof(digits), number);
+            this->put(std::string_view(digits, result.ptr));
+        }
+
+        std::size_t length() const {
+            return this->_length;
+        }
+    private:
+        std::span<char> _buffer;
+        std::size_t _length = 0;
+    };
+
+    /*
+     * Turns a stream of Z-chars into text, keeping track of shifts and of
+     * the Z-chars still to come of an abbreviation or ZSCII escape
+     */
+    class ZCharDecoder {
+    public:
+        /*
+         * Abbreviation n is the text of abbreviations between bounds n and
+         * n + 1. Abbreviations are skipped if disallowed, or decoded as
+         * placeholders if there are none.
+         */
+        ZCharDecoder(
+            ZVersion version,
+            const ZStringDecoder& characters,
+            const ZStringDecoder::AlphabetTable& alphabets,
+            std::string_view abbreviations,
+            std::span<const std::uint32_t> bounds,
+            bool abbreviations_allowed,
+            Output& output
+        )
+          : _characters(characters)
+          , _alphabets(alphabets)
+          , _abbreviations(abbreviations)
+          , _bounds(bounds)
+          , _abbreviations_allowed(abbreviations_allowed)
+          , _output(output)
+          , _version(version)
+          {}
+
+        void decode(ZChar z) {
+            if (this->_escape_remaining == 2) {
+                this->_escape_remaining--;
+                this->_escape_top = z;
+                return;
+            }
+            if (this->_escape_remaining == 1) {
+                this->_escape_remaining--;
+                this->_output.put(this->_characters.zscii_to_utf8((Word)(this->_escape_top << 5 | z)));
+                return;
+            }
+            if (this->_abbreviation != 0) {
+                std::size_t abbreviation = 32u * (this->_abbreviation - 1u) + z;
+                this->_abbreviation = 0;
+                if (not this->_abbreviations_allowed) {
+                    // abbreviations can't be nested
+                    return;
+                }
+                if (abbreviation + 1 >= this->_bounds.size()) {
+                    this->_output.put("@{");
+                    this->_output.put_number(abbreviation);
+                    this->_output.put("}");
+                    return;
+                }
+                std::size_t begin = this->_bounds[abbreviation];
+                this->_output.put(this->_abbreviations.substr(begin, this->_bounds[abbreviation + 1] - begin));
+                return;
+            }
+            Alphabet alphabet = this->_alphabet;
+            this->_alphabet = this->_locked; // shifts only last for one character
+            switch (z) {
+            case 0:
+                this->_output.put(' ');
+                return;
+            case 1:
+                if (this->_version == ZVersion::V1) {
+                    this->_output.put('\n');
+                    return;
+                }
+                [[fallthrough]];
+            case 2: case 3:
+                if (this->_version < ZVersion::V3) {
+                    if (z == 1) {
+                        this->_abbreviation = z;
+                    } else {
+                        // shift to the next or previous alphabet, for one character
+                        this->_alphabet = (Alphabet)((this->_locked + z - 1u) % 3u);
+                    }
+                    return;
+                }
+                this->_abbreviation = z;
+                return;
+            case 4: case 5:
+                if (this->_version < ZVersion::V3) {
+                    // shift to the next or previous alphabet, until shifted again
+                    this->_locked = (Alphabet)((this->_locked + z - 3u) % 3u);
+                    this->_alphabet = this->_locked;
+                } else {
+                    this->_alphabet = z == 4 ? A1 : A2;
+                }
+                return;
+            case 6:
+                if (alphabet == A2) {
+                    this->_escape_remaining = 2;
+                    return;
+                }
+                [[fallthrough]];
+            default:
+                this->_output.put(this->_alphabets[26u * alphabet + z - 6u]);
+                return;
+            }
+        }
+    private:
+        const ZStringDecoder& _characters;
+        const ZStringDecoder::AlphabetTable& _alphabets;
+        std::string_view _abbreviations;
+        std::span<const std::uint32_t> _bounds;
+        bool _abbreviations_allowed;
+        Output& _output;
+        ZVersion _version;
+        Alphabet _alphabet = A0; // for the next character
+        Alphabet _locked = A0; // to return to after a single shift
+        ZChar _abbreviation = 0; // the Z-char which began an abbreviation, if the next gives its number
+        std::size_t _escape_remaining = 0; // Z-chars of a ZSCII escape still to come
+        ZChar _escape_top = 0; // the first of them, once seen
+    };
+
+#ifdef ZENCH_UNPACK_AVX2
+    const bool CPU_HAS_AVX2 = [] {
+        __builtin_cpu_init(); // needed as this runs before constructors which would do it
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+
+    /*
+     * Unpacks as ZStringDecoder::unpack() does, 16 Words at a time for as
+     * long as there are that many. Returns the number of Words unpacked,
+     * setting ended if the last of them ends the string.
+     */
+    __attribute__((target("avx2")))
+    std::size_t unpack_avx2(const Byte* z_string, Byte* z_chars, std::size_t words, bool& ended) {
+        constexpr std::size_t BLOCK = 16; // Words at a time
+        const __m256i mask = _mm256_set1_epi16(0b11111);
+        std::size_t w = 0;
+        for (; w + BLOCK <= words; w += BLOCK) {
+            __m256i bytes = _mm256_loadu_si256((const __m256i*)&z_string[2 * w]);
+            // Words are big-endian
+            __m256i packed = _mm256_or_si256(_mm256_slli_epi16(bytes, 8), _mm256_srli_epi16(bytes, 8));
+            __m256i first = _mm256_and_si256(_mm256_srli_epi16(packed, 10), mask);
+            __m256i second = _mm256_and_si256(_mm256_srli_epi16(packed, 5), mask);
+            __m256i third = _mm256_and_si256(packed, mask);
+            // each Word becomes the 32 bits {first, second, third, 0}, but unpacking stays within each 128-bit lane
+            __m256i low = _mm256_or_si256(first, _mm256_slli_epi16(second, 8));
+            __m256i words_0_3_8_11 = _mm256_unpacklo_epi16(low, third);
+            __m256i words_4_7_12_15 = _mm256_unpackhi_epi16(low, third);
+            Byte* out = &z_chars[w * ZStringDecoder::UNPACKED_WORD_SIZE];
+            _mm256_storeu_si256((__m256i*)out, _mm256_permute2x128_si256(words_0_3_8_11, words_4_7_12_15, 0x20));
+            _mm256_storeu_si256((__m256i*)(out + 32), _mm256_permute2x128_si256(words_0_3_8_11, words_4_7_12_15, 0x31));
+            // the string ends at the first Word which is negative, as a signed number
+            auto ends = (std::uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi16(_mm256_setzero_si256(), packed));
+            if (ends != 0) {
+                ended = true;
+                return w + (std::size_t)std::countr_zero(ends) / 2 + 1;
+            }
+        }
+        return w;
+    }
+#endif
+}
+
+namespace com::saxbophone::zench {
+    // ctor only needs to take a few details about version, any custom decoder tables...
+    ZStringDecoder::ZStringDecoder(
+        ZVersion version,
+        std::span<const Byte> memory,
+        std::optional<std::span<const Byte, 78>> alphabet_table,
+        std::optional<std::span<char16_t>> unicode_translation_table
+    )
+      : _version(version)
+      , _alphabets(version == ZVersion::V1 ? V1_ALPHABETS : ALPHABETS)
+      {
+        std::span<const char16_t> extra_characters = DEFAULT_UNICODE_TRANSLATION_TABLE;
+        if (unicode_translation_table) {
+            extra_characters = *unicode_translation_table;
+        }
+        this->_extra_character_count = std::min(extra_characters.size(), MAX_EXTRA_CHARACTERS);
+        for (std::size_t c = 0; c < this->_extra_character_count; c++) {
+            // characters of the Basic Multilingual Plane are 1 to 3 bytes of UTF-8
+            char16_t codepoint = extra_characters[c];
+            ExtraCharacter& character = this->_extra_characters[c];
+            character.codepoint = codepoint;
+            if (codepoint < 0x80) {
+                character.utf8 = {(char)codepoint};
+                character.length = 1;
+            } else if (codepoint < 0x800) {
+                character.utf8 = {(char)(0xc0 | codepoint >> 6), (char)(0x80 | (codepoint & 0x3f))};
+                character.length = 2;
+            } else {
+                character.utf8 = {
+                    (char)(0xe0 | codepoint >> 12),
+                    (char)(0x80 | (codepoint >> 6 & 0x3f)),
+                    (char)(0x80 | (codepoint & 0x3f)),
+                };
+                character.length = 3;
+            }
+        }
+        // NOTE: V1 and V2 have their own alphabets, shifts and abbreviations, later versions decode as V3 does
+        if (alphabet_table) {
+            for (std::size_t i = 0; i < this->_alphabets.size(); i++) {
+                Byte zscii = (*alphabet_table)[i];
+                // NOTE: alphabets hold single bytes, so any extra characters in them are printed as '?'
+                this->_alphabets[i] = zscii >= 32 and zscii < 127 ? (char)zscii : '?';
+            }
+            // Z-char 7 of A2 is always a newline, whatever the table says
+            this->_alphabets[2 * 26 + 1] = '\n';
+        }
+        Address table = memory.size() > 0x19 ? (Address)(memory[0x18] << 8 | memory[0x19]) : 0;
+        // V1 has no abbreviations, and a story may simply not use them
+        if (version == ZVersion::V1 or table == 0) {
+            return;
+        }
+        std::size_t count = version == ZVersion::V2 ? 32 : ABBREVIATIONS;
+        if (table + 2 * count > memory.size()) {
+            throw Exception(); // ERROR! abbreviations table runs off the end of memory
+        }
+        for (std::size_t a = 0; a < count; a++) {
+            // entries are word addresses
+            Address address = 2u * (Address)(memory[table + 2 * a] << 8 | memory[table + 2 * a + 1]);
+            Address end = address;
+            do {
+                if (end + 1u >= memory.size()) {
+                    throw Exception(); // ERROR! abbreviation runs off the end of memory
+                }
+                end += 2;
+            } while ((memory[end - 2u] & 0x80) == 0);
+            std::span<const Byte> z_string = memory.subspan(address, end - address);
+            std::size_t begin = this->_abbreviations.size();
+            this->_abbreviations.resize(begin + this->_decode(z_string, {}, false));
+            this->_decode(z_string, std::span<char>(this->_abbreviations).subspan(begin), false);
+            this->_abbreviation_bounds[a + 1] = (std::uint32_t)this->_abbreviations.size();
+        }
+        this->_abbreviation_count = count;
+    }
+
+    std::size_t ZStringDecoder::decode(std::span<const Byte> z_string, std::span<char> output) const {
+        return this->_decode(z_string, output, true);
+    }
+
+    std::string ZStringDecoder::decode(std::span<const Byte> z_string) const {
+        std::string output;
+        output.resize(this->decode(z_string, {}));
+        this->decode(z_string, output);
+        return output;
+    }
+
+    std::string_view ZStringDecoder::zscii_to_utf8(Word zscii) const {
+        if (zscii == 13) {
+            return "\n";
+        } else if (0x20 <= zscii and zscii <= 0x7e) {
+            return PRINTABLE_ASCII.substr(zscii - 0x20u, 1);
+        } else if (zscii >= FIRST_EXTRA_CHARACTER and (std::size_t)(zscii - FIRST_EXTRA_CHARACTER) < this->_extra_character_count) {
+            const ExtraCharacter& character = this->_extra_characters[zscii - FIRST_EXTRA_CHARACTER];
+            return std::string_view(character.utf8.data(), character.length);
+        }
+        return "?";
+    }
+
+    Byte ZStringDecoder::zscii_from_unicode(std::uint16_t codepoint) const {
+        // text is always lower-cased before it is stored --beyond ASCII, only Latin-1 and the ligature OE are
+        if (('A' <= codepoint and codepoint <= 'Z') or (0xc0 <= codepoint and codepoint <= 0xde and codepoint != 0xd7)) {
+            codepoint += 0x20;
+        } else if (codepoint == 0x0152) {
+            codepoint = 0x0153;
+        }
+        if (0x20 <= codepoint and codepoint <= 0x7e) {
+            return (Byte)codepoint;
+        }
+        for (std::size_t c = 0; c < this->_extra_character_count; c++) {
+            if (this->_extra_characters[c].codepoint == codepoint) {
+                return (Byte)(FIRST_EXTRA_CHARACTER + c);
+            }
+        }
+        return 0;
+    }
+
+    std::size_t ZStringDecoder::_decode(
+        std::span<const Byte> z_string,
+        std::span<char> output,
+        bool abbreviations_allowed
+    ) const {
+        Output out(output);
+        ZCharDecoder decoder(
+            this->_version,
+            *this,
+            this->_alphabets,
+            this->_abbreviations,
+            std::span<const std::uint32_t>(this->_abbreviation_bounds).first(
+                this->_abbreviation_count == 0 ? 0 : this->_abbreviation_count + 1
+            ),
+            abbreviations_allowed,
+            out
+        );
+        std::array<Byte, 64 * UNPACKED_WORD_SIZE> z_chars;
+        // only complete Words are decoded, a trailing odd byte is ignored
+        while (true) {
+            std::size_t words = unpack(z_string, z_chars);
+            for (std::size_t z = 0; z < words * UNPACKED_WORD_SIZE; z += UNPACKED_WORD_SIZE) {
+                decoder.decode(z_chars[z]);
+                decoder.decode(z_chars[z + 1]);
+                decoder.decode(z_chars[z + 2]);
+            }
+            if (words == 0 or z_string[2 * words - 2] & 0x80) {
+                return out.length();
+            }
+            z_string = z_string.subspan(2 * words);
+        }
+    }
+
+    std::size_t ZStringDecoder::unpack(std::span<const Byte> z_string, std::span<Byte> z_chars) {
+        std::size_t words = std::min(z_string.size() / 2, z_chars.size() / UNPACKED_WORD_SIZE);
+        std::size_t w = 0;
+#ifdef ZENCH_UNPACK_AVX2
+        if (CPU_HAS_AVX2) {
+            bool ended = false;
+            w = unpack_avx2(z_string.data(), z_chars.data(), words, ended);
+            if (ended) {
+                return w;
+            }
+        }
+#endif
+#if defined(__SSE2__)
+        constexpr std::size_t BLOCK = 8; // Words at a time
+        const __m128i mask = _mm_set1_epi16(0b11111);
+        for (; w + BLOCK <= words; w += BLOCK) {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)&z_string[2 * w]);
+            // Words are big-endian
+            __m128i packed = _mm_or_si128(_mm_slli_epi16(bytes, 8), _mm_srli_epi16(bytes, 8));
+            __m128i first = _mm_and_si128(_mm_srli_epi16(packed, 10), mask);
+            __m128i second = _mm_and_si128(_mm_srli_epi16(packed, 5), mask);
+            __m128i third = _mm_and_si128(packed, mask);
+            // each Word becomes the 32 bits {first, second, third, 0}
+            __m128i low = _mm_or_si128(first, _mm_slli_epi16(second, 8));
+            Byte* out = &z_chars[w * UNPACKED_WORD_SIZE];
+            _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi16(low, third));
+            _mm_storeu_si128((__m128i*)(out + 16), _mm_unpackhi_epi16(low, third));
+            // the string ends at the first Word which is negative, as a signed number
+            auto ends = (std::uint32_t)_mm_movemask_epi8(_mm_cmplt_epi16(packed, _mm_setzero_si128()));
+            if (ends != 0) {
+                return w + (std::size_t)std::countr_zero(ends) / 2 + 1;
+            }
+        }
+#endif
+        // the rest, which is too short for a whole block
+        return w + unpack_word_by_word(z_string.subspan(2 * w), z_chars.subspan(w * UNPACKED_WORD_SIZE));
+    }
+
+    std::size_t ZStringDecoder::unpack_word_by_word(std::span<const Byte> z_string, std::span<Byte> z_chars) {
+        std::size_t words = std::min(z_string.size() / 2, z_chars.size() / UNPACKED_WORD_SIZE);
+        for (std::size_t w = 0; w < words; w++) {
+            std::uint16_t word = (std::uint16_t)(z_string[2 * w] << 8 | z_string[2 * w + 1]);
+            Byte* out = &z_chars[w * UNPACKED_WORD_SIZE];
+            out[0] = (ZChar)(word >> 10 & 0b11111);
+            out[1] = (ZChar)(word >> 5 & 0b11111);
+            out[2] = (ZChar)(word & 0b11111);
+            out[3] = 0;
+            if (word & 0x8000) {
+                return w + 1;
+            }
+        }
+        return words;
+    }
+}
@@ -0,0 +1,152 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_Z_STRING_DECODER_HPP
+#define COM_SAXBOPHONE_ZENCH_Z_STRING_DECODER_HPP
+
+#include <cstddef>         // size_t
+#include <cstdint>         // uint16_t, uint32_t
+
+#include <array>           // array
+#include <optional>        // optional
+#include <span>            // span
+#include <string>          // string
+#include <string_view>     // string_view
+
+#include <zench/zench.hpp> // base library definitions of core types
+
+namespace com::saxbophone::zench {
+    /*
+     * Decodes Z-strings a Z-char at a time, straight from their packed Words,
+     * looking characters up in a flat table of all three alphabets.
+     * Decoding into a buffer provided by the caller doesn't allocate.
+     */
+    class ZStringDecoder {
+    public:
+        // A0, A1 and A2 one after the other, 26 characters each
+        using AlphabetTable = std::array<char, 78>;
+        // the default alphabets of version 1
+        static constexpr AlphabetTable V1_ALPHABETS = {
+            'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
+            'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
+            'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
+            'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+            // the first character of A2 is never printed, Z-char 6 being the ZSCII escape there
+            ' ', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.', ',',
+            '!', '?', '_', '#', '\'', '"', '/', '\\', '<', '-', ':', '(', ')',
+        };
+        // the default alphabets of all later versions, which swap '<' for a newline
+        static constexpr AlphabetTable ALPHABETS = {
+            'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
+            'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
+            'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
+            'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+            ' ', '\n', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.',
+            ',', '!', '?', '_', '#', '\'', '"', '/', '\\', '-', ':', '(', ')',
+        };
+
+        // the number of abbreviations from V3 onwards, V2 having only the first 32
+        static constexpr std::size_t ABBREVIATIONS = 96;
+
+        // ZSCII 155 onwards are the extra characters, given by the Unicode translation table
+        static constexpr Word FIRST_EXTRA_CHARACTER = 155;
+        // ZSCII 155 to 251
+        static constexpr std::size_t MAX_EXTRA_CHARACTERS = 97;
+        // the extra characters of a story which doesn't give its own Unicode translation table (Standard 3.8.5.3)
+        static constexpr std::array<char16_t, 69> DEFAULT_UNICODE_TRANSLATION_TABLE = {
+            0x00e4, 0x00f6, 0x00fc, 0x00c4, 0x00d6, 0x00dc, 0x00df, 0x00bb, 0x00ab, 0x00eb, 0x00ef, 0x00ff,
+            0x00cb, 0x00cf, 0x00e1, 0x00e9, 0x00ed, 0x00f3, 0x00fa, 0x00fd, 0x00c1, 0x00c9, 0x00cd, 0x00d3,
+            0x00da, 0x00dd, 0x00e0, 0x00e8, 0x00ec, 0x00f2, 0x00f9, 0x00c0, 0x00c8, 0x00cc, 0x00d2, 0x00d9,
+            0x00e2, 0x00ea, 0x00ee, 0x00f4, 0x00fb, 0x00c2, 0x00ca, 0x00ce, 0x00d4, 0x00db, 0x00e5, 0x00c5,
+            0x00f8, 0x00d8, 0x00e3, 0x00f1, 0x00f5, 0x00c3, 0x00d1, 0x00d5, 0x00e6, 0x00c6, 0x00e7, 0x00c7,
+            0x00fe, 0x00f0, 0x00de, 0x00d0, 0x00a3, 0x0153, 0x0152, 0x00a1, 0x00bf,
+        };
+
+        /*
+         * memory is the story's, whose abbreviations (found through the table
+         * given in its header) are all decoded up front. Without it, each
+         * abbreviation is decoded as a placeholder "@{n}" instead.
+         * unicode_translation_table gives the extra characters, if the story
+         * has its own (only the first MAX_EXTRA_CHARACTERS are used).
+         * Throws Exception if any abbreviation runs off the end of memory.
+         */
+        ZStringDecoder(
+            ZVersion version,
+            std::span<const Byte> memory={},
+            std::optional<std::span<const Byte, 78>> alphabet_table=std::nullopt,
+            std::optional<std::span<char16_t>> unicode_translation_table=std::nullopt
+        );
+        /*
+         * Decodes z_string into output, stopping at the Word with its top bit
+         * set or at the end of z_string, whichever comes first.
+         * Returns the length of the decoded text, which is only written in
+         * full if output is at least that long --otherwise, as much of it as
+         * fits is written, and a longer buffer may be tried again.
+         */
+        std::size_t decode(std::span<const Byte> z_string, std::span<char> output) const;
+        /*
+         * NOTE: we return a UTF8-encoded string implicitly
+         * the Unicode lookup table is actually encoded in UTF16 but we'll
+         * convert that on an as-needs basis rather than work solely in UTF16
+         * to accomodate it...
+         */
+        std::string decode(std::span<const Byte> z_string) const;
+        /*
+         * The text a ZSCII character is printed as, UTF-8 encoded: a newline
+         * for 13, ASCII for 32 to 126, the extra characters as the Unicode
+         * translation table gives them, and "?" for anything else.
+         */
+        std::string_view zscii_to_utf8(Word zscii) const;
+        // the ZSCII character which a codepoint is typed as, lower-cased, or 0 if there's none
+        Byte zscii_from_unicode(std::uint16_t codepoint) const;
+
+        // each Word is unpacked into this many bytes: its three Z-chars, then a padding 0
+        static constexpr std::size_t UNPACKED_WORD_SIZE = 4;
+        /*
+         * Unpacks the Words of z_string into z_chars, UNPACKED_WORD_SIZE bytes
+         * each, up to the Word with its top bit set or until either runs out.
+         * Many Words are unpacked at once with AVX2 if the CPU has it, otherwise
+         * with SSE2 if built for it.
+         * Returns the number of Words unpacked.
+         */
+        static std::size_t unpack(std::span<const Byte> z_string, std::span<Byte> z_chars);
+        // as unpack(), but one Word at a time on any CPU
+        static std::size_t unpack_word_by_word(std::span<const Byte> z_string, std::span<Byte> z_chars);
+    private:
+        std::size_t _decode(
+            std::span<const Byte> z_string,
+            std::span<char> output,
+            bool abbreviations_allowed
+        ) const;
+
+        // an extra character, and its UTF-8 encoding
+        struct ExtraCharacter {
+            char16_t codepoint;
+            Byte length;
+            std::array<char, 3> utf8;
+        };
+
+        ZVersion _version;
+        AlphabetTable _alphabets;
+        std::size_t _extra_character_count;
+        std::array<ExtraCharacter, MAX_EXTRA_CHARACTERS> _extra_characters = {};
+        std::size_t _abbreviation_count = 0; // those which are decoded, none if memory wasn't given
+        // the text of every abbreviation, one after the other, so that each is ready to copy
+        std::string _abbreviations;
+        // where each abbreviation begins in _abbreviations, then where the last one ends
+        std::array<std::uint32_t, ABBREVIATIONS + 1> _abbreviation_bounds = {};
+    };
+}
+
+#endif // include guard
@@ -0,0 +1,39 @@
+/*
+ * This file forms part of libzench
+ * libzench is a software library that implements a portable and extensible
+ * Z-machine interpreter, designed to be embedded within other programs.
+ *
+ * Created by the zench contributors, October 2026
+ *
+ * Copyright the zench contributors 2026
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <string>    // string
+
+#include <zench/zench.hpp>
+
+namespace com::saxbophone::zench {
+    const std::string VERSION = ZENCH_VERSION_STRING;
+    const std::string VERSION_DESCRIPTION = "zench v" ZENCH_VERSION_STRING;
+
+    UnsupportedVersionException::UnsupportedVersionException(Byte version)
+      : _version(version)
+      , _message(
+            version == 0 ?
+            "Story file version not supported" :
+            "Story file version " + std::to_string(version) + " not supported"
+        )
+      {}
+
+    const char* UnsupportedVersionException::what() const noexcept {
+        return this->_message.c_str();
+    }
+
+    Byte UnsupportedVersionException::version() const {
+        return this->_version;
+    }
+}
@@ -12,12 +12,36 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
 
+#include <zench/FileSystem.hpp>
 #include <zench/StandardFileSystem.hpp>
 #include <zench/Keyboard.hpp>
 #include <zench/Screen.hpp>
+#include <zench/StoryImage.hpp>
 #include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
 
 using namespace com::saxbophone::zench;
 
@@ -40,28 +64,287 @@ public:
     constexpr const char* name() override {
         return "StubScreen";
     }
+    std::pair<std::uint8_t, std::uint8_t> get_dimensions() override { return {80, 25}; }
+    bool supports_colour() override { return false; }
+    bool supports_truecolour() override { return false; }
+    void render(std::span<const Command> commands, std::string_view text) override {
+        for (const auto& command : commands) {
+            if (command.type == Command::Type::Print) {
+                std::cout << text.substr(command.offset, command.length);
+            } else if (command.type == Command::Type::NewLine) {
+                std::cout << '\n';
+            }
+        }
+        std::cout.flush();
+    }
 };
-class StubKeyboard : public Keyboard {
+// waits for a line to be typed each time input is wanted, giving nothing once the console is closed
+class ConsoleKeyboard : public Keyboard {
 public:
     constexpr const char* name() override {
-        return "StubKeyboard";
+        return "ConsoleKeyboard";
     }
     constexpr bool supports_mouse() override { return false; }
     constexpr bool supports_menus() override { return false; }
-    std::vector<Event> get_input() override { return {}; }
+    std::vector<Event> get_input() override {
+        std::string line;
+        if (not std::getline(std::cin, line)) {
+            return {};
+        }
+        // typed as UTF-8, of which only the Basic Multilingual Plane can be given to the ZMachine
+        std::vector<Event> input;
+        for (std::size_t i = 0; i < line.size();) {
+            auto lead = (unsigned char)line[i];
+            std::size_t length = lead < 0x80 ? 1 : lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : 4;
+            if (i + length > line.size()) {
+                break;
+            }
+            std::uint32_t codepoint = length == 1 ? lead : lead & (0x7fu >> length);
+            for (std::size_t b = 1; b < length; b++) {
+                codepoint = codepoint << 6 | ((unsigned char)line[i + b] & 0x3fu);
+            }
+            if (codepoint != '\r' and codepoint <= 0xffff) {
+                input.push_back((std::uint16_t)codepoint);
+            }
+            i += length;
+        }
+        input.push_back((std::uint16_t)'\n');
+        return input;
+    }
+};
+
+// has no files, so that headless runs never stop to ask for one
+class NullFileSystem : public FileSystem {
+public:
+    constexpr const char* name() override {
+        return "NullFileSystem";
+    }
+    std::unique_ptr<InputFile> open_for_read() override { return {}; }
+    std::unique_ptr<InputFile> open_for_read(std::string) override { return {}; }
+    std::unique_ptr<OutputFile> open_for_write() override { return {}; }
+    std::unique_ptr<OutputFile> open_for_write(std::string) override { return {}; }
 };
+// discards everything printed, keeping only a hash of it (64-bit FNV-1a)
+class HashingScreen : public Screen {
+public:
+    constexpr const char* name() override {
+        return "HashingScreen";
+    }
+    std::pair<std::uint8_t, std::uint8_t> get_dimensions() override { return {80, 25}; }
+    bool supports_colour() override { return false; }
+    bool supports_truecolour() override { return false; }
+    void render(std::span<const Command> commands, std::string_view text) override {
+        for (const auto& command : commands) {
+            if (command.type == Command::Type::Print) {
+                this->_add(text.substr(command.offset, command.length));
+            } else if (command.type == Command::Type::NewLine) {
+                this->_add("\n");
+            }
+        }
+    }
+    std::uint64_t hash() const {
+        return this->_hash;
+    }
+private:
+    void _add(std::string_view text) {
+        for (char c : text) {
+            this->_hash = (this->_hash ^ (unsigned char)c) * 0x100000001b3;
+        }
+    }
+
+    std::uint64_t _hash = 0xcbf29ce484222325;
+};
+// types the whole of a command script, one line per command, the first time it's asked for input
+class ScriptKeyboard : public Keyboard {
+public:
+    ScriptKeyboard(std::string_view script) {
+        for (char c : script) {
+            if (c != '\r') {
+                this->_input.push_back((std::uint16_t)(unsigned char)c);
+            }
+        }
+        if (not script.empty() and script.back() != '\n') {
+            this->_input.push_back((std::uint16_t)'\n');
+        }
+    }
+    constexpr const char* name() override {
+        return "ScriptKeyboard";
+    }
+    constexpr bool supports_mouse() override { return false; }
+    constexpr bool supports_menus() override { return false; }
+    std::vector<Event> get_input() override {
+        return std::exchange(this->_input, {});
+    }
+private:
+    std::vector<Event> _input;
+};
+
+namespace {
+    // one story played through one command script, and what came of it
+    struct BatchRun {
+        std::string story_path;
+        std::string script_path;
+        std::shared_ptr<const StoryImage> story;
+        std::string script;
+        std::uint64_t instructions = 0;
+        double seconds = 0.0;
+        std::uint64_t transcript_hash = 0;
+        std::string outcome;
+        bool failed = false;
+    };
+
+    std::optional<std::string> read_file(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (not file) {
+            return {};
+        }
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    // plays the story until it quits, fails or runs out of commands
+    void play(BatchRun& run) {
+        NullFileSystem fs;
+        HashingScreen screen;
+        ScriptKeyboard keyboard(run.script);
+        auto start = std::chrono::steady_clock::now();
+        ZMachine vm(run.story, fs, screen, keyboard);
+        // the whole script is typed at the first READ, so the machine only waits for input once it's used up
+        ZMachine::Status status = vm.run_until_blocked();
+        vm.flush_screen();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        run.instructions = vm.instructions();
+        run.seconds = elapsed.count();
+        run.transcript_hash = screen.hash();
+        switch (status) {
+        case ZMachine::Status::Quit:
+            run.outcome = "quit";
+            break;
+        case ZMachine::Status::WaitingForInput:
+            run.outcome = "end-of-script";
+            break;
+        default:
+            run.failed = true;
+            try {
+                std::rethrow_exception(vm.error());
+            } catch (const std::exception& e) {
+                run.outcome = std::string("error: ") + e.what();
+            }
+        }
+    }
+
+    /*
+     * Plays every (story, command script) pair in the list file, one pair
+     * per line separated by whitespace, on the given number of threads.
+     * Blank lines and those starting with '#' are skipped.
+     */
+    int run_batch(const std::string& list_path, std::size_t jobs) {
+        std::ifstream list(list_path);
+        if (not list) {
+            std::cerr << "Can't read batch list: " << list_path << std::endl;
+            return 1;
+        }
+        std::vector<BatchRun> runs;
+        // each story is loaded once, and shared by every run of it
+        std::map<std::string, std::shared_ptr<const StoryImage>> stories;
+        std::string line;
+        for (std::size_t line_number = 1; std::getline(list, line); line_number++) {
+            std::istringstream fields(line);
+            BatchRun run;
+            if (not (fields >> run.story_path) or run.story_path.starts_with('#')) {
+                continue;
+            }
+            if (not (fields >> run.script_path)) {
+                std::cerr << list_path << ":" << line_number << ": no command script for " << run.story_path << std::endl;
+                return 1;
+            }
+            auto& story = stories[run.story_path];
+            if (not story) {
+                StandardFileSystem::InputFile file(run.story_path);
+                try {
+                    story = StoryImage::load(file);
+                } catch (const Exception& e) {
+                    std::cerr << run.story_path << ": " << e.what() << std::endl;
+                    return 1;
+                }
+            }
+            run.story = story;
+            // read up front, so that no run's time includes reading files
+            std::optional<std::string> script = read_file(run.script_path);
+            if (not script) {
+                std::cerr << "Can't read command script: " << run.script_path << std::endl;
+                return 1;
+            }
+            run.script = std::move(*script);
+            runs.push_back(std::move(run));
+        }
+        std::atomic<std::size_t> next_run = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (std::size_t w = 0; w < std::min(jobs, runs.size()); w++) {
+            workers.emplace_back([&runs, &next_run] {
+                for (std::size_t r = next_run++; r < runs.size(); r = next_run++) {
+                    play(runs[r]);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::uint64_t instructions = 0;
+        bool failed = false;
+        std::cout << "story\tscript\tinstructions\tseconds\ttranscript\toutcome\n";
+        for (const auto& run : runs) {
+            std::cout << run.story_path << '\t' << run.script_path << '\t' << run.instructions << '\t';
+            std::cout << std::fixed << std::setprecision(6) << run.seconds << '\t';
+            std::cout << std::hex << std::setfill('0') << std::setw(16) << run.transcript_hash << std::dec << '\t';
+            std::cout << run.outcome << '\n';
+            instructions += run.instructions;
+            failed = failed or run.failed;
+        }
+        std::cout.flush();
+        std::cerr << runs.size() << " runs on " << workers.size() << " threads: ";
+        std::cerr << instructions << " instructions in " << std::fixed << std::setprecision(3) << elapsed.count() << "s (";
+        std::cerr << std::setprecision(0) << (elapsed.count() > 0.0 ? (double)instructions / elapsed.count() : 0.0);
+        std::cerr << " instructions/sec)" << std::endl;
+        return failed ? 1 : 0;
+    }
+
+    int usage(const char* program) {
+        std::cerr << "Usage: " << program << " <story file>" << std::endl;
+        std::cerr << "       " << program << " --batch <list file> [--jobs <threads>]" << std::endl;
+        return 1;
+    }
+}
 
 int main(int argc, const char* argv[]) {
-    // TODO: load up story file properly
-    StandardFileSystem::InputFile game;
+    if (argc < 2) {
+        return usage(argv[0]);
+    }
+    if (std::string_view(argv[1]) == "--batch") {
+        if (argc != 3 and not (argc == 5 and std::string_view(argv[3]) == "--jobs")) {
+            return usage(argv[0]);
+        }
+        std::size_t jobs = std::max(std::thread::hardware_concurrency(), 1u);
+        if (argc == 5) {
+            std::string_view count(argv[4]);
+            auto [end, error] = std::from_chars(count.data(), count.data() + count.size(), jobs);
+            if (error != std::errc() or end != count.data() + count.size() or jobs == 0) {
+                return usage(argv[0]);
+            }
+        }
+        return run_batch(argv[2], jobs);
+    }
+    StandardFileSystem::InputFile game(argv[1]);
     ConsoleFilePicker picker;
     StandardFileSystem fs(picker);
     StubScreen screen;
-    StubKeyboard keyboard;
+    ConsoleKeyboard keyboard;
 
     ZMachine vm(game, fs, screen, keyboard);
 
-    while (vm.is_ready()) {
-        vm.execute();
-    }
+    // the keyboard waits for each line, so this only goes round once per line typed
+    while (vm.run_until_blocked() == ZMachine::Status::WaitingForInput and std::cin) {}
 }
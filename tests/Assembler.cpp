@@ -0,0 +1,171 @@
+#include <cstddef>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+#include <Assembler.hpp>
+
+#include "Instruction.hpp"
+#include "stubs.hpp"
+
+using namespace com::saxbophone::zench;
+using namespace com::saxbophone::zench::tests;
+
+namespace {
+    // runs a story until it blocks, returning what it printed
+    std::string play(const std::vector<Byte>& story, const std::string& input = "") {
+        MemoryInputFile file(story);
+        StubFileSystem fs;
+        StubScreen screen;
+        StubKeyboard keyboard;
+        ZMachine vm(file, fs, screen, keyboard);
+        keyboard.type(input);
+        CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+        return screen.output;
+    }
+}
+
+TEST_CASE("Stories built by the Assembler run in a ZMachine") {
+    Assembler assembler;
+    Word room = assembler.object("Room");
+    Word lamp = assembler.object("brass lamp", room);
+    assembler.set_attribute(lamp, 3);
+    assembler.set_property(lamp, 5, {0x01, 0x2c});
+    assembler.set_property_default(6, 7);
+    Assembler::Label square = assembler.routine({0});
+    assembler.instruction("mul", {Assembler::local(1), Assembler::local(1)}, 0x00);
+    assembler.instruction("ret_popped");
+    Assembler::Label greeting = assembler.string("Hello!");
+    assembler.start_here();
+    assembler.instruction("print_paddr", {Assembler::packed(greeting)});
+    assembler.instruction("new_line");
+    assembler.instruction("get_parent", {Assembler::constant(lamp)}, 0x10);
+    assembler.instruction("print_num", {Assembler::global(0)});
+    assembler.instruction("new_line");
+    assembler.instruction("get_prop", {Assembler::constant(lamp), Assembler::constant(5)}, 0x00);
+    assembler.instruction("print_num", {Assembler::sp()});
+    assembler.instruction("get_prop", {Assembler::constant(lamp), Assembler::constant(6)}, 0x00);
+    assembler.instruction("print_num", {Assembler::sp()});
+    assembler.instruction("call", {Assembler::packed(square), Assembler::constant(12)}, 0x00);
+    assembler.instruction("print_num", {Assembler::sp()});
+    Assembler::Label lit = assembler.new_label();
+    assembler.instruction("test_attr", {Assembler::constant(lamp), Assembler::constant(3)}, {}, Assembler::Branch{lit});
+    assembler.print(" unlit");
+    assembler.bind(lit);
+    Assembler::Label end = assembler.new_label();
+    assembler.instruction("jump", {Assembler::address(end)});
+    assembler.print(" skipped");
+    assembler.bind(end);
+    assembler.instruction("quit");
+    CHECK(play(assembler.build()) == "Hello!\n1\n3007144");
+}
+
+TEST_CASE("Assembler::assemble() builds a story from text") {
+    std::vector<Byte> story = Assembler::assemble(R"(
+        ; says whether the word typed is in the dictionary, and what it doubles to
+        .word north "north"
+        .word south "South"
+        .separators ","
+        .array text #0a #00 #00 #00 #00 #00 #00 #00 #00 #00 #00 #00
+        .array parse #02 #00 #00 #00 #00 #00 #00 #00 #00 #00
+        .global g03 #0015
+
+        .routine double #0000
+            add l00, l00 -> sp
+            ret_popped
+
+        .start
+            sread *text *parse
+            loadw *parse #01 -> sp
+            je sp *south ?found
+            print "not found: "
+            jump done
+        found:
+            print "found: "
+        done:
+            call &double g03 -> sp
+            print_num sp
+            new_line
+            quit
+    )");
+    CHECK(play(story, "south\n") == "found: 42\n");
+    CHECK(play(story, "north\n") == "not found: 42\n");
+}
+
+TEST_CASE("Assembled instructions disassemble to the text they were assembled from") {
+    std::vector<std::string> lines = {
+        "@add #03,#04 -> 00",
+        "@storew 10,#0200,#ffff",
+        "@print_num 12",
+        "@call #1234,#05 -> 15",
+        "@print \"Hello, world!\"",
+        "@get_child #01 -> 03",
+        "@quit",
+    };
+    std::string source = ".start\n";
+    for (const std::string& line : lines) {
+        // only get_child branches
+        source += line + (line.starts_with("@get_child") ? " ?rfalse\n" : "\n");
+    }
+    std::vector<Byte> story = Assembler::assemble(source);
+    Address pc = (Address)(story[0x06] << 8 | story[0x07]);
+    for (const std::string& line : lines) {
+        Instruction instruction = Instruction::decode(pc, story);
+        std::string text = instruction.to_string(story);
+        std::size_t start = text.find(": ") + 2;
+        std::string_view disassembled = std::string_view(text).substr(start, text.find("; ") - start);
+        if (instruction.has_branch) {
+            CHECK(disassembled == line + " ? 0");
+        } else {
+            CHECK(disassembled == line);
+        }
+    }
+}
+
+TEST_CASE("Assembler reports what it can't assemble") {
+    SECTION("Unknown instructions") {
+        Assembler assembler;
+        CHECK_THROWS_AS(assembler.instruction("frobnicate"), AssemblyException);
+    }
+    SECTION("A store or branch where the instruction has none, or none where it has one") {
+        Assembler assembler;
+        CHECK_THROWS_AS(assembler.instruction("add", {Assembler::constant(1), Assembler::constant(2)}), AssemblyException);
+        CHECK_THROWS_AS(assembler.instruction("quit", {}, 0x00), AssemblyException);
+        CHECK_THROWS_AS(assembler.instruction("jz", {Assembler::sp()}), AssemblyException);
+    }
+    SECTION("Labels bound twice or never") {
+        Assembler assembler;
+        Assembler::Label label = assembler.new_label();
+        assembler.start_here();
+        assembler.instruction("jump", {Assembler::address(label)});
+        CHECK_THROWS_AS(assembler.build(), AssemblyException);
+        assembler.bind(label);
+        CHECK_THROWS_AS(assembler.bind(label), AssemblyException);
+    }
+    SECTION("No first instruction") {
+        Assembler assembler;
+        assembler.routine();
+        assembler.instruction("rtrue");
+        CHECK_THROWS_AS(assembler.build(), AssemblyException);
+    }
+    SECTION("Text, by line number") {
+        CHECK_THROWS_WITH(
+            Assembler::assemble(".start\n  quit\n  add #01 -> sp\n"),
+            "line 3: add has the wrong number of operands"
+        );
+        CHECK_THROWS_WITH(
+            Assembler::assemble(".start\n  jump nowhere\n"),
+            "label nowhere is never bound"
+        );
+        CHECK_THROWS_WITH(
+            Assembler::assemble(".start\n  print \"unterminated\n"),
+            "line 2: a string has no closing quote"
+        );
+    }
+}
@@ -0,0 +1,103 @@
+#include <cstddef>
+
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/FileSystem.hpp>
+#include <zench/zench.hpp>
+
+#include "AsyncWriter.hpp"
+#include "stubs.hpp"
+
+using namespace com::saxbophone::zench;
+using namespace com::saxbophone::zench::tests;
+
+namespace {
+    // fails every write
+    class FailingOutputFile : public FileSystem::OutputFile {
+    public:
+        constexpr const char* name() override {
+            return "FailingOutputFile";
+        }
+        bool is_open() override {
+            return true;
+        }
+        void close() override {}
+        bool open() override {
+            return true;
+        }
+        bool write(std::span<const Byte>) override {
+            return false;
+        }
+    };
+
+    std::string as_string(const std::vector<Byte>& data) {
+        return std::string(data.begin(), data.end());
+    }
+}
+
+TEST_CASE("AsyncWriter writes everything in order, however it's split between buffers") {
+    std::vector<Byte> data;
+    AsyncWriter writer(std::make_unique<MemoryOutputFile>(data), 7);
+    std::string expected;
+    for (std::size_t i = 0; i < 500; i++) {
+        std::string chunk(i % 23, (char)('a' + i % 26));
+        writer.write(chunk);
+        writer.write('.');
+        expected += chunk + '.';
+        if (i % 50 == 0) {
+            writer.submit();
+        }
+    }
+    CHECK(writer.flush());
+    CHECK(as_string(data) == expected);
+    // the writer can carry on after a flush
+    writer.write(std::string_view("end"));
+    CHECK(writer.flush());
+    CHECK(as_string(data) == expected + "end");
+}
+
+TEST_CASE("AsyncWriter writes what's left in its buffer when closed") {
+    std::vector<Byte> data;
+    {
+        AsyncWriter writer(std::make_unique<MemoryOutputFile>(data));
+        writer.write(std::string_view("West of House\n"));
+        CHECK(data.empty());
+    }
+    CHECK(as_string(data) == "West of House\n");
+}
+
+TEST_CASE("AsyncWriter::flush() reports failed writes") {
+    AsyncWriter writer(std::make_unique<FailingOutputFile>(), 4);
+    CHECK(writer.flush());
+    writer.write(std::string_view("xyzzy"));
+    CHECK_FALSE(writer.flush());
+    CHECK_FALSE(writer.close());
+}
+
+TEST_CASE("AsyncWriters on many threads share the I/O thread") {
+    constexpr std::size_t WRITERS = 8;
+    std::vector<std::vector<Byte>> files(WRITERS);
+    std::vector<std::thread> threads;
+    for (std::size_t w = 0; w < WRITERS; w++) {
+        threads.emplace_back([&files, w] {
+            // small buffers, so that writers often wait for the I/O thread
+            AsyncWriter writer(std::make_unique<MemoryOutputFile>(files[w]), 16);
+            for (std::size_t i = 0; i < 10'000; i++) {
+                writer.write((char)('0' + w));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (std::size_t w = 0; w < WRITERS; w++) {
+        CHECK(as_string(files[w]) == std::string(10'000, (char)('0' + w)));
+    }
+}
@@ -0,0 +1,68 @@
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/zench.hpp>
+
+#include "Dictionary.hpp"
+
+using namespace com::saxbophone::zench;
+
+namespace {
+    std::vector<Byte> zscii(std::string_view text) {
+        return std::vector<Byte>(text.begin(), text.end());
+    }
+}
+
+TEST_CASE("An indexed dictionary finds the same entries as searching it") {
+    bool sorted = GENERATE(true, false);
+    std::vector<Byte> memory(0x400);
+    std::vector<std::string_view> words = {"a", "go", "lamp", "north", "take", "zork"};
+    // encode the words with a dictionary which has none, then lay them out as entries
+    Dictionary empty(ZVersion::V3, memory, 0x100);
+    memory[0x100] = 0; // no separators
+    memory[0x101] = 7; // entries of 7 bytes
+    memory[0x102] = 0x00;
+    memory[0x103] = 0x00;
+    std::vector<Dictionary::EncodedWord> encoded;
+    for (auto word : words) {
+        encoded.push_back(empty.encode(zscii(word)));
+    }
+    std::sort(encoded.begin(), encoded.end());
+    if (not sorted) {
+        std::reverse(encoded.begin(), encoded.end());
+        // a word which appears twice is found at its first entry
+        encoded.push_back(encoded.front());
+    }
+    SWord count = (SWord)(sorted ? encoded.size() : -encoded.size());
+    memory[0x102] = (Byte)((Word)count >> 8);
+    memory[0x103] = (Byte)count;
+    for (std::size_t i = 0; i < encoded.size(); i++) {
+        std::copy_n(encoded[i].begin(), 4, memory.begin() + 0x104 + 7 * (std::ptrdiff_t)i);
+    }
+    Dictionary searched(ZVersion::V3, memory, 0x100);
+    Dictionary::Index index(searched);
+    Dictionary indexed(ZVersion::V3, memory, 0x100, &index);
+    CHECK(searched.end() == 0x104 + 7 * encoded.size());
+    for (auto word : words) {
+        CHECK(searched.lookup(zscii(word)) != 0);
+        CHECK(indexed.lookup(zscii(word)) == searched.lookup(zscii(word)));
+    }
+    for (auto word : {"xyzzy", "nort", "", "b"}) {
+        CHECK(searched.lookup(zscii(word)) == 0);
+        CHECK(indexed.lookup(zscii(word)) == 0);
+    }
+}
+
+TEST_CASE("An empty dictionary can be indexed") {
+    std::vector<Byte> memory(0x200);
+    memory[0x101] = 7; // entries of 7 bytes, but there are none
+    Dictionary dictionary(ZVersion::V3, memory, 0x100);
+    Dictionary::Index index(dictionary);
+    CHECK(Dictionary(ZVersion::V3, memory, 0x100, &index).lookup(zscii("north")) == 0);
+}
@@ -0,0 +1,91 @@
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/zench.hpp>
+
+#include "Instruction.hpp"
+
+using namespace com::saxbophone::zench;
+
+TEST_CASE("Long form instructions decode to two inline operands") {
+    // add #03,#04 -> sp
+    std::vector<Byte> memory = {0x14, 0x03, 0x04, 0x00};
+    Address pc = 0;
+    Instruction instruction = Instruction::decode(pc, memory);
+    CHECK(pc == 4);
+    CHECK(instruction.end() == 4);
+    CHECK(instruction.category == Instruction::Category::_2OP);
+    CHECK(instruction.opcode == 0x14);
+    REQUIRE(instruction.operand_count == 2);
+    CHECK(instruction.operands[0] == 3);
+    CHECK(instruction.operands[1] == 4);
+    CHECK(instruction.variable_operands == 0);
+    CHECK(instruction.has_store);
+    CHECK(instruction.store_variable == 0x00);
+    CHECK_FALSE(instruction.has_branch);
+}
+
+TEST_CASE("Double-VAR instructions decode up to eight operands") {
+    // call_vs2 with 7 operands: large, small, variable, then 4 small
+    std::vector<Byte> memory = {
+        0xEC, 0b00011001, 0b01010111,
+        0x12, 0x34, 0x05, 0x10, 0x07, 0x08, 0x09, 0x0a,
+        0x20, // store
+    };
+    Address pc = 0;
+    Instruction instruction = Instruction::decode(pc, memory);
+    CHECK(pc == memory.size());
+    CHECK(instruction.category == Instruction::Category::VAR);
+    REQUIRE(instruction.operand_count == 7);
+    std::array<Word, 7> expected = {0x1234, 0x05, 0x10, 0x07, 0x08, 0x09, 0x0a};
+    for (std::size_t i = 0; i < expected.size(); i++) {
+        CHECK(instruction.operands[i] == expected[i]);
+        CHECK(instruction.is_variable(i) == (i == 2));
+    }
+    CHECK(instruction.has_store);
+    CHECK(instruction.store_variable == 0x20);
+    // operand widths are only recovered for disassembly
+    Instruction::Metadata metadata = instruction.metadata(memory);
+    CHECK(metadata.operand_types[0] == Instruction::OperandType::LARGE_CONSTANT);
+    CHECK(metadata.operand_types[1] == Instruction::OperandType::SMALL_CONSTANT);
+    CHECK(metadata.operand_types[2] == Instruction::OperandType::VARIABLE);
+    CHECK(metadata.bytecode.size() == memory.size());
+}
+
+TEST_CASE("Variable form 2OP opcodes 12 and 26 are not mistaken for double-VAR") {
+    // clear_attr in variable form, with two small constants
+    std::vector<Byte> memory = {0xCC, 0b01011111, 0x01, 0x02};
+    Address pc = 0;
+    Instruction instruction = Instruction::decode(pc, memory);
+    CHECK(pc == memory.size());
+    CHECK(instruction.category == Instruction::Category::_2OP);
+    CHECK(instruction.operand_count == 2);
+}
+
+TEST_CASE("String literals following print are located without being copied") {
+    // print, followed by a two-Word literal
+    std::vector<Byte> memory = {0xB2, 0x11, 0xAA, 0xC6, 0x34, 0xBA};
+    Address pc = 0;
+    Instruction instruction = Instruction::decode(pc, memory);
+    CHECK(pc == 5);
+    std::span<const Byte> literal = instruction.trailing_string_literal(memory);
+    REQUIRE(literal.size() == 4);
+    CHECK(literal.data() == memory.data() + 1);
+}
+
+TEST_CASE("Instructions running beyond the end of memory can't be decoded") {
+    std::vector<std::vector<Byte>> truncated = {
+        {0x14, 0x03, 0x04},          // add #03,#04 without its store
+        {0xE0, 0x1F, 0x00},          // call with half of its large constant
+        {0x41, 0x10, 0x03},          // je g00 #03 without its branch
+        {0xB2, 0x11, 0xAA},          // print, whose literal never ends
+    };
+    for (const std::vector<Byte>& memory : truncated) {
+        Address pc = 0;
+        CHECK_THROWS_AS(Instruction::decode(pc, memory), Exception);
+    }
+}
@@ -0,0 +1,64 @@
+#include <cstddef>
+
+#include <set>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/zench.hpp>
+
+#include "ObjectTable.hpp"
+#include "stubs.hpp"
+
+using namespace com::saxbophone::zench;
+using namespace com::saxbophone::zench::tests;
+
+
+TEST_CASE("ObjectTable reads the object tree and attributes") {
+    std::vector<Byte> memory(0x400);
+    put_object_table(memory, 0x240);
+    ObjectTable objects(memory, 0x240);
+    CHECK(objects.child(1) == 2);
+    CHECK(objects.parent(1) == 0);
+    CHECK(objects.parent(2) == 1);
+    CHECK(objects.sibling(2) == 0);
+    CHECK(objects.attribute(1, 0));
+    CHECK(objects.attribute(1, 31));
+    CHECK_FALSE(objects.attribute(1, 1));
+    CHECK_FALSE(objects.attribute(2, 0));
+    CHECK(objects.property_default(7) == 0x0707);
+    CHECK_THROWS_AS(objects.parent(0), Exception);
+    CHECK_THROWS_AS(objects.attribute(1, 32), Exception);
+    CHECK_THROWS_AS(objects.property_default(32), Exception);
+}
+
+TEST_CASE("ObjectTable decodes each property list once, until invalidated") {
+    std::vector<Byte> memory(0x400);
+    put_object_table(memory, 0x240);
+    ObjectTable objects(memory, 0x240);
+    std::set<Address> watched;
+    auto watch = [&](Address address) { watched.insert(address); };
+    const ObjectTable::Properties& properties = objects.properties(1, watch);
+    CHECK(properties[18].data == 0x2a4);
+    CHECK(properties[18].length == 2);
+    CHECK(properties[5].data == 0x2a7);
+    CHECK(properties[5].length == 1);
+    CHECK(properties[3].length == 4);
+    CHECK(properties[7].data == 0);
+    // in the order they're listed
+    CHECK(properties[0].next == 18);
+    CHECK(properties[18].next == 5);
+    CHECK(properties[5].next == 3);
+    CHECK(properties[3].next == 0);
+    // the pointer to the property table, the short name length and each size byte
+    CHECK(watched == std::set<Address>{0x285, 0x286, 0x2a0, 0x2a3, 0x2a6, 0x2a8, 0x2ad});
+    // cached, so a change isn't seen until invalidated
+    memory[0x2a6] = 0x06;
+    watched.clear();
+    CHECK(objects.properties(1, watch)[5].data == 0x2a7);
+    CHECK(watched.empty());
+    objects.invalidate();
+    CHECK(objects.properties(1, watch)[5].data == 0);
+    CHECK(objects.properties(1, watch)[6].data == 0x2a7);
+    CHECK(objects.properties(2, watch)[0].next == 7);
+}
@@ -0,0 +1,36 @@
+#include <catch2/catch.hpp>
+
+#include <zench/zench.hpp>
+
+#include "Profiler.hpp"
+#include "Stack.hpp"
+
+using namespace com::saxbophone::zench;
+
+TEST_CASE("Profiler::advance() says when each sample is due") {
+    Profiler profiler(10);
+    CHECK(profiler.until_sample() == 10);
+    CHECK_FALSE(profiler.advance(4));
+    CHECK(profiler.until_sample() == 6);
+    CHECK(profiler.advance(6));
+    CHECK(profiler.until_sample() == 10);
+    // overshooting counts towards the next sample
+    CHECK(profiler.advance(13));
+    CHECK(profiler.until_sample() == 7);
+}
+
+TEST_CASE("Profiler::folded() counts each distinct call stack once") {
+    Profiler profiler(1);
+    Stack stack(64);
+    profiler.sample(stack);
+    stack.push_frame(0x100, 0, 0, 0, 0x4e3c);
+    profiler.sample(stack);
+    stack.push_frame(0x4e40, 0, 0, 0);
+    profiler.sample(stack);
+    profiler.sample(stack);
+    stack.pop_frame();
+    stack.push_frame(0x4e44, 0, 0, 0, 0x5a10);
+    profiler.sample(stack);
+    CHECK(profiler.samples() == 5);
+    CHECK(profiler.folded() == "main 1\nmain;0x4e3c 1\nmain;0x4e3c;? 2\nmain;0x4e3c;0x5a10 1\n");
+}
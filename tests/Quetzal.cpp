@@ -0,0 +1,80 @@
+#include <cstddef>
+
+#include <optional>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/zench.hpp>
+
+#include "Quetzal.hpp"
+#include "Stack.hpp"
+#include "stubs.hpp"
+
+using namespace com::saxbophone::zench;
+using namespace com::saxbophone::zench::tests;
+
+TEST_CASE("CMem round-trips dynamic memory, including long runs of unchanged bytes") {
+    std::vector<Byte> original(1000);
+    for (std::size_t i = 0; i < original.size(); i++) {
+        original[i] = (Byte)(i * 7);
+    }
+    auto memory = original;
+    memory[3] = 0xff;
+    memory[600] ^= 0x01;
+    memory[601] = 0x00;
+    std::vector<Byte> cmem;
+    Quetzal::encode_cmem(memory, original, cmem);
+    // unchanged memory takes only a couple of bytes per run
+    CHECK(cmem.size() < 16);
+    std::vector<Byte> decoded(original.size());
+    REQUIRE(Quetzal::decode_cmem(cmem, original, decoded));
+    CHECK(decoded == memory);
+    // a run that overflows memory is rejected
+    std::vector<Byte> overflowing = {0x00, 0xff, 0x00, 0xff, 0x00, 0xff, 0x00, 0xff};
+    CHECK_FALSE(Quetzal::decode_cmem(overflowing, original, decoded));
+}
+
+TEST_CASE("Saved games round-trip the stack and can only be restored into the same story") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Stack stack(64);
+    stack.push(0x1234);
+    stack.push_frame(0x10abc, 0x10, 2, 3);
+    stack.local(2) = 0xbeef;
+    stack.push(0x5678);
+    std::vector<Byte> dynamic_memory(story.begin(), story.begin() + 0x100);
+    dynamic_memory[0x80] = 0x42;
+    auto saved = Quetzal::save(story, dynamic_memory, stack, 0x123);
+    auto restored = Quetzal::restore(story, saved, 64);
+    REQUIRE(restored);
+    CHECK(restored->pc == 0x123);
+    CHECK(restored->dynamic_memory == dynamic_memory);
+    CHECK(restored->stack.depth() == 2);
+    CHECK(restored->stack.argument_count() == 2);
+    CHECK(restored->stack.local(2) == 0xbeef);
+    CHECK(restored->stack.pop() == 0x5678);
+    Stack::Return caller = restored->stack.pop_frame();
+    CHECK(caller.pc == 0x10abc);
+    CHECK(caller.result_ref == 0x10);
+    CHECK(restored->stack.pop() == 0x1234);
+    // a stack that doesn't fit, or a different story, can't be restored
+    CHECK_FALSE(Quetzal::restore(story, saved, 8));
+    auto other_story = story;
+    other_story[0x1c] = 0x01; // checksum
+    CHECK_FALSE(Quetzal::restore(other_story, saved, 64));
+    // nor can something that isn't a saved game at all
+    CHECK_FALSE(Quetzal::restore(story, story, 64));
+}
+
+TEST_CASE("Quetzal::read() reads exactly one FORM from a file") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Stack stack(64);
+    std::vector<Byte> dynamic_memory(story.begin(), story.begin() + 0x100);
+    auto saved = Quetzal::save(story, dynamic_memory, stack, 0x123);
+    auto padded = saved;
+    padded.push_back(0x00);
+    MemoryInputFile file(padded);
+    CHECK(Quetzal::read(file) == saved);
+    MemoryInputFile not_a_save(story);
+    CHECK(Quetzal::read(not_a_save).empty());
+}
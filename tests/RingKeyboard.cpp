@@ -0,0 +1,100 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include <catch2/catch.hpp>
+
+#include <zench/Keyboard.hpp>
+#include <zench/RingKeyboard.hpp>
+#include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+#include "stubs.hpp"
+
+using namespace com::saxbophone::zench;
+using namespace com::saxbophone::zench::tests;
+
+TEST_CASE("RingKeyboard packs events into 32 bits losslessly") {
+    Keyboard::Event codepoint = (std::uint16_t)0xffff;
+    Keyboard::Event key = Keyboard::SpecialKey::SingleClick;
+    CHECK(RingKeyboard::decode(RingKeyboard::encode(codepoint)) == codepoint);
+    CHECK(RingKeyboard::decode(RingKeyboard::encode(key)) == key);
+    CHECK(RingKeyboard::encode(codepoint) != RingKeyboard::encode((std::uint16_t)Keyboard::SpecialKey::SingleClick));
+}
+
+TEST_CASE("RingKeyboard drops events when full and returns the rest in order") {
+    RingKeyboard keyboard(3);
+    REQUIRE(keyboard.capacity() == 4);
+    for (std::uint16_t c = 0; c < 4; c++) {
+        CHECK(keyboard.push(c));
+    }
+    CHECK_FALSE(keyboard.push((std::uint16_t)4));
+    CHECK(keyboard.pop() == Keyboard::Event((std::uint16_t)0));
+    CHECK(keyboard.push(Keyboard::SpecialKey::Newline));
+    auto events = keyboard.get_input();
+    REQUIRE(events.size() == 4);
+    CHECK(events[0] == Keyboard::Event((std::uint16_t)1));
+    CHECK(events[3] == Keyboard::Event(Keyboard::SpecialKey::Newline));
+    CHECK_FALSE(keyboard.pop());
+}
+
+TEST_CASE("RingKeyboard passes events between two threads without loss") {
+    constexpr std::uint16_t EVENTS = 50'000;
+    RingKeyboard keyboard(64);
+    std::thread producer([&] {
+        for (std::uint16_t c = 0; c < EVENTS;) {
+            if (keyboard.push(c)) {
+                c++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    std::uint16_t expected = 0;
+    bool in_order = true;
+    while (expected < EVENTS) {
+        if (std::optional<Keyboard::Event> event = keyboard.pop()) {
+            in_order = in_order and *event == Keyboard::Event(expected);
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    CHECK(in_order);
+}
+
+TEST_CASE("ZMachine reads a RingKeyboard one line at a time") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    story[0x08] = 0x01; // dictionary at 0x180
+    story[0x09] = 0x80;
+    story[0x80] = 20; // text buffer
+    story[0xa0] = 4; // parse buffer
+    story[0x181] = 0x06; // no separators or entries
+    Byte code[] = {
+        0x95, 0x10,                         // 0x100: inc g00
+        0x41, 0x10, 0x03, 0xC9,             // 0x102: je g00 #03 ?0x10d
+        0xE4, 0x5F, 0x80, 0xA0,             // 0x106: sread #80 #a0
+        0x8C, 0xFF, 0xF5,                   // 0x10A: jump 0x100
+        0xBA,                               // 0x10D: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    RingKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::WaitingForInput);
+    // both lines are waiting, but only the first is taken by the first READ
+    for (char c : std::string("a\nb")) {
+        keyboard.push((std::uint16_t)c);
+    }
+    CHECK(vm.run_until_blocked() == ZMachine::Status::WaitingForInput);
+    keyboard.push(Keyboard::SpecialKey::Newline);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+}
@@ -0,0 +1,147 @@
+#include <cstddef>
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/Scheduler.hpp>
+#include <zench/StoryImage.hpp>
+#include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+#include "stubs.hpp"
+
+using namespace com::saxbophone::zench;
+using namespace com::saxbophone::zench::tests;
+
+namespace {
+    // counts how many times sessions stopped with each status
+    struct Stops {
+        void operator()(Scheduler::SessionId, ZMachine&, ZMachine::Status status) {
+            std::lock_guard lock(mutex);
+            (status == ZMachine::Status::WaitingForInput ? waiting : status == ZMachine::Status::Quit ? quit : other)++;
+        }
+
+        std::mutex mutex;
+        std::size_t waiting = 0;
+        std::size_t quit = 0;
+        std::size_t other = 0;
+    };
+}
+
+TEST_CASE("Scheduler parks sessions waiting for input until they're notified") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    story[0x08] = 0x01; // dictionary at 0x180
+    story[0x09] = 0x80;
+    story[0x80] = 20; // text buffer
+    story[0xa0] = 4; // parse buffer
+    story[0x181] = 0x06; // no separators or entries
+    Byte code[] = {
+        0x95, 0x10,                         // 0x100: inc g00
+        0x41, 0x10, 0x03, 0xC9,             // 0x102: je g00 #03 ?0x10d
+        0xE4, 0x5F, 0x80, 0xA0,             // 0x106: sread #80 #a0
+        0x8C, 0xFF, 0xF5,                   // 0x10A: jump 0x100
+        0xBA,                               // 0x10D: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    auto image = StoryImage::load(file);
+    constexpr std::size_t SESSIONS = 100;
+    StubFileSystem fs;
+    StubScreen screen;
+    std::vector<StubKeyboard> keyboards(SESSIONS);
+    Stops stops;
+    Scheduler scheduler(4, std::ref(stops));
+    std::vector<Scheduler::SessionId> sessions;
+    for (auto& keyboard : keyboards) {
+        sessions.push_back(scheduler.add(std::make_unique<ZMachine>(image, fs, screen, keyboard)));
+    }
+    scheduler.wait_until_idle();
+    CHECK(stops.waiting == SESSIONS);
+    CHECK(scheduler.session_count() == SESSIONS);
+    // sessions don't run again until notified
+    for (std::size_t s = 0; s < SESSIONS; s++) {
+        keyboards[s].type("go\n");
+    }
+    for (std::size_t s = 0; s < SESSIONS / 2; s++) {
+        CHECK(scheduler.notify(sessions[s]));
+    }
+    scheduler.wait_until_idle();
+    CHECK(stops.waiting == SESSIONS + SESSIONS / 2);
+    // now every session has had one line of input more than the first half
+    for (std::size_t s = 0; s < SESSIONS; s++) {
+        if (s < SESSIONS / 2) {
+            keyboards[s].type("go\n");
+        }
+        CHECK(scheduler.notify(sessions[s]));
+    }
+    scheduler.wait_until_idle();
+    // the first half have had two turns and quit, the rest have had one
+    CHECK(stops.quit == SESSIONS / 2);
+    CHECK(stops.waiting == SESSIONS * 2);
+    CHECK(stops.other == 0);
+    CHECK(scheduler.session_count() == SESSIONS / 2);
+    CHECK_FALSE(scheduler.notify(sessions[0]));
+}
+
+TEST_CASE("Scheduler time-slices sessions which don't stop by themselves") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xC5, 0x4F, 0x10, 0x27, 0x10, 0xC5, // 0x100: inc_chk g00 #2710 ?0x109
+        0x8C, 0xFF, 0xF9,                   // 0x106: jump 0x100
+        0xBA,                               // 0x109: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    auto image = StoryImage::load(file);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    Stops stops;
+    // more sessions than threads, each needing many time slices
+    Scheduler scheduler(2, std::ref(stops), 1000);
+    for (std::size_t s = 0; s < 8; s++) {
+        scheduler.add(std::make_unique<ZMachine>(image, fs, screen, keyboard));
+    }
+    scheduler.wait_until_idle();
+    CHECK(stops.quit == 8);
+    CHECK(scheduler.session_count() == 0);
+}
+
+TEST_CASE("Scheduler gives other sessions a turn whilst one runs forever") {
+    auto looping = blank_story(0x200, 0x100, 0x100);
+    looping[0x100] = 0x8C; // 0x100: jump 0x100
+    looping[0x101] = 0xFF;
+    looping[0x102] = 0xFF;
+    auto counting = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xC5, 0x4F, 0x10, 0x27, 0x10, 0xC5, // 0x100: inc_chk g00 #2710 ?0x109
+        0x8C, 0xFF, 0xF9,                   // 0x106: jump 0x100
+        0xBA,                               // 0x109: quit
+    };
+    std::copy(std::begin(code), std::end(code), counting.begin() + 0x100);
+    MemoryInputFile looping_file(looping);
+    MemoryInputFile counting_file(counting);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    Stops stops;
+    {
+        Scheduler scheduler(1, std::ref(stops), 1000);
+        scheduler.add(std::make_unique<ZMachine>(looping_file, fs, screen, keyboard));
+        scheduler.add(std::make_unique<ZMachine>(counting_file, fs, screen, keyboard));
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (scheduler.session_count() > 1 and std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(scheduler.session_count() == 1);
+        // and the scheduler stops even though the other never will
+    }
+    CHECK(stops.quit == 1);
+}
@@ -0,0 +1,95 @@
+#include <cstddef>
+
+#include <string>
+
+#include <catch2/catch.hpp>
+
+#include <zench/Screen.hpp>
+
+#include "ScreenBuffer.hpp"
+#include "stubs.hpp"
+
+using namespace com::saxbophone::zench;
+using namespace com::saxbophone::zench::tests;
+
+namespace {
+    // remembers the last batch rendered
+    class RecordingScreen : public StubScreen {
+    public:
+        void render(std::span<const Command> commands, std::string_view text) override {
+            StubScreen::render(commands, text);
+            last_commands.assign(commands.begin(), commands.end());
+        }
+
+        std::vector<Command> last_commands;
+    };
+}
+
+TEST_CASE("ScreenBuffer merges runs of text in the same style") {
+    RecordingScreen screen;
+    ScreenBuffer buffer(screen);
+    buffer.print("Hello");
+    buffer.print(',');
+    buffer.print(" world", Screen::Style::Bold);
+    buffer.print("!", Screen::Style::Bold);
+    buffer.new_line();
+    buffer.print("Bye");
+    CHECK(screen.batches == 0);
+    buffer.flush();
+    CHECK(screen.batches == 1);
+    CHECK(screen.output == "Hello, world!\nBye");
+    REQUIRE(screen.last_commands.size() == 4);
+    CHECK(screen.last_commands[0].length == 6);
+    CHECK(screen.last_commands[1].style == Screen::Style::Bold);
+    CHECK(screen.last_commands[2].type == Screen::Command::Type::NewLine);
+    // nothing to flush
+    buffer.flush();
+    CHECK(screen.batches == 1);
+}
+
+TEST_CASE("ScreenBuffer flushes by itself once full") {
+    StubScreen screen;
+    ScreenBuffer buffer(screen);
+    for (std::size_t i = 0; i < ScreenBuffer::MAX_COMMANDS; i++) {
+        buffer.new_line();
+    }
+    CHECK(screen.batches == 1);
+    buffer.print(std::string(ScreenBuffer::MAX_TEXT, 'x'));
+    CHECK(screen.batches == 2);
+    CHECK(screen.output.size() == ScreenBuffer::MAX_COMMANDS + ScreenBuffer::MAX_TEXT);
+}
+
+TEST_CASE("Screens which don't render batches are given each command in turn") {
+    // a driver written before batches existed, which only prints
+    class LineScreen : public Screen {
+    public:
+        constexpr const char* name() override {
+            return "LineScreen";
+        }
+        std::pair<std::uint8_t, std::uint8_t> get_dimensions() override { return {80, 25}; }
+        bool supports_colour() override { return false; }
+        bool supports_truecolour() override { return false; }
+        void print(std::string_view text, std::uint8_t style) override {
+            if (style == Screen::Style::Bold) {
+                output += '*';
+                output += text;
+                output += '*';
+            } else {
+                output += text;
+            }
+        }
+        void new_line() override {
+            output += '\n';
+        }
+
+        std::string output;
+    };
+    LineScreen screen;
+    ScreenBuffer buffer(screen);
+    buffer.print("Hello, ");
+    buffer.print("world", Screen::Style::Bold);
+    buffer.new_line();
+    buffer.print('!');
+    buffer.flush();
+    CHECK(screen.output == "Hello, *world*\n!");
+}
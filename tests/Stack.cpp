@@ -0,0 +1,58 @@
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/zench.hpp>
+
+#include "Stack.hpp"
+
+using namespace com::saxbophone::zench;
+
+TEST_CASE("Each frame has its own locals and evaluation stack") {
+    Stack stack(64);
+    stack.push(0x1111);
+    stack.push_frame(0x12345, 0x20, 1, 3);
+    CHECK(stack.depth() == 2);
+    CHECK(stack.argument_count() == 1);
+    // locals start zeroed and only the routine's own are accessible
+    CHECK(stack.local(1) == 0);
+    stack.local(3) = 0xbeef;
+    CHECK_THROWS_AS(stack.local(4), Exception);
+    // the caller's evaluation stack can't be reached from the callee
+    CHECK_THROWS_AS(stack.pop(), StackUnderflowException);
+    stack.push(0x2222);
+    CHECK(stack.top() == 0x2222);
+    Stack::Return caller = stack.pop_frame();
+    CHECK(caller.pc == 0x12345);
+    CHECK(caller.result_ref == 0x20);
+    CHECK(stack.depth() == 1);
+    CHECK(stack.pop() == 0x1111);
+}
+
+TEST_CASE("Returning from the entrypoint frame is an error") {
+    Stack stack(64);
+    CHECK_THROWS_AS(stack.pop_frame(), Exception);
+}
+
+TEST_CASE("Stack capacity is enforced on push and call") {
+    Stack stack(Stack::FRAME_HEADER_SIZE + 2);
+    stack.push(1);
+    stack.push(2);
+    CHECK_THROWS_AS(stack.push(3), StackOverflowException);
+    CHECK_THROWS_AS(stack.push_frame(0, 0, 0, 0), StackOverflowException);
+}
+
+TEST_CASE("Each frame remembers the routine it's running, for profiling") {
+    Stack stack(64);
+    stack.push_frame(0x12345, 0x20, 0, 2, 0x4e3c);
+    stack.push(7);
+    stack.push_frame(0x4e40, 0x00, 0, 0);
+    stack.push_frame(0x4e42, 0x00, 1, 1, 0x1fffe);
+    std::vector<Address> routines;
+    stack.routines(routines);
+    CHECK(routines == std::vector<Address>{0, 0x4e3c, 0, 0x1fffe});
+    stack.pop_frame();
+    stack.pop_frame();
+    stack.routines(routines);
+    CHECK(routines == std::vector<Address>{0, 0x4e3c});
+}
@@ -0,0 +1,62 @@
+#include <cstdio>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/StandardFileSystem.hpp>
+#include <zench/zench.hpp>
+
+using namespace com::saxbophone::zench;
+
+namespace {
+    class NoFilePicker : public StandardFilePicker {
+    public:
+        constexpr const char* name() override {
+            return "NoFilePicker";
+        }
+        std::string get_filename() override { return {}; }
+    };
+}
+
+TEST_CASE("StandardFileSystem::InputFile reads a whole file in bulk") {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "zench-input-file-test.bin";
+    std::vector<Byte> data(1000);
+    for (std::size_t i = 0; i < data.size(); i++) {
+        data[i] = (Byte)(i * 7);
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write((const char*)data.data(), (std::streamsize)data.size());
+    }
+    StandardFileSystem::InputFile file(path.string());
+    REQUIRE(file.is_open());
+    CHECK(file.size() == data.size());
+    std::span<const Byte> contents = file.contents();
+    CHECK(std::vector<Byte>(contents.begin(), contents.end()) == data);
+    // reads pick up where the last one left off, and stop at the end of the file
+    CHECK((Byte)file.read() == data[0]);
+    std::vector<Byte> buffer(2000);
+    CHECK(file.read_into(buffer) == data.size() - 1);
+    CHECK(std::equal(data.begin() + 1, data.end(), buffer.begin()));
+    file.close();
+    CHECK_FALSE(file.is_open());
+    // re-opening starts from the beginning again
+    REQUIRE(file.open());
+    CHECK((Byte)file.read() == data[0]);
+    file.close();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("StandardFileSystem can't open files which don't exist") {
+    NoFilePicker picker;
+    StandardFileSystem fs(picker);
+    CHECK(fs.open_for_read("zench-no-such-file.z3") == nullptr);
+    CHECK(fs.open_for_read() == nullptr);
+}
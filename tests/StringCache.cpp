@@ -0,0 +1,82 @@
+#include <cstddef>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/zench.hpp>
+
+#include "StringCache.hpp"
+
+using namespace com::saxbophone::zench;
+
+namespace {
+    std::optional<std::string> find(const StringCache& cache, Address address) {
+        std::vector<char> text;
+        std::optional<std::size_t> length = cache.find(address, text);
+        if (not length) {
+            return {};
+        }
+        return std::string(text.data(), *length);
+    }
+}
+
+TEST_CASE("StringCache finds the text inserted for each address") {
+    StringCache cache;
+    CHECK_FALSE(find(cache, 0x1234));
+    cache.insert(0x1234, "West of House");
+    cache.insert(0x1236, "");
+    CHECK(find(cache, 0x1234) == "West of House");
+    CHECK(find(cache, 0x1236) == "");
+    // inserting again keeps the first
+    cache.insert(0x1234, "Behind House");
+    CHECK(find(cache, 0x1234) == "West of House");
+    CHECK(cache.size() == 2);
+    // found text is copied into the start of a buffer already long enough
+    std::vector<char> buffer(100, '.');
+    CHECK(cache.find(0x1234, buffer) == 13);
+    CHECK(buffer.size() == 100);
+    CHECK(std::string_view(buffer.data(), 14) == "West of House.");
+}
+
+TEST_CASE("StringCache stays within its budget, sparing strings looked up recently") {
+    StringCache cache(16 * 1024);
+    std::string text(200, 'x');
+    cache.insert(0, text);
+    for (Address address = 2; address < 2000; address += 2) {
+        // keep the first string in use throughout
+        CHECK(find(cache, 0));
+        cache.insert(address, text);
+        CHECK(cache.used() <= cache.budget());
+    }
+    CHECK(cache.size() < 999);
+    CHECK(find(cache, 0) == text);
+    // a string which could never fit isn't cached
+    cache.insert(0x4000, std::string(cache.budget(), 'y'));
+    CHECK_FALSE(find(cache, 0x4000));
+}
+
+TEST_CASE("StringCache can be used from many threads at once") {
+    StringCache cache(64 * 1024);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < 4; t++) {
+        threads.emplace_back([&cache, t] {
+            std::vector<char> text;
+            for (Address address = 0; address < 2000; address++) {
+                if (cache.find(address, text)) {
+                    continue;
+                }
+                cache.insert(address, std::string(address % 64 + t, 'z'));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(cache.used() <= cache.budget());
+    CHECK(cache.size() > 0);
+}
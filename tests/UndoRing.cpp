@@ -0,0 +1,138 @@
+#include <cstddef>
+
+#include <optional>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/zench.hpp>
+
+#include "Stack.hpp"
+#include "UndoRing.hpp"
+
+using namespace com::saxbophone::zench;
+
+TEST_CASE("UndoRing rewinds memory and stack by any number of snapshots") {
+    UndoRing undo(64 * 1024);
+    std::vector<Byte> memory(1000);
+    Stack stack(64);
+    auto first_memory = memory;
+    undo.save(memory, stack, 0x100);
+    memory[10] = 1;
+    undo.touch(10);
+    stack.push(0x1111);
+    stack.push_frame(0x200, 0x10, 0, 2);
+    stack.local(1) = 0xaaaa;
+    undo.save(memory, stack, 0x200);
+    memory[500] = 2;
+    memory[501] = 3;
+    undo.touch(500);
+    undo.touch(501);
+    stack.local(2) = 0xbbbb;
+    undo.save(memory, stack, 0x300);
+    // changes since the newest snapshot are undone too
+    memory[999] = 4;
+    undo.touch(999);
+    CHECK(undo.size() == 3);
+    std::size_t stores = 0;
+    auto store = [&](Address address, Byte value) {
+        memory[address] = value;
+        undo.touch(address);
+        stores++;
+    };
+    CHECK_FALSE(undo.restore(4, memory, stack, store));
+    CHECK(stores == 0);
+    CHECK(undo.restore(2, memory, stack, store) == 0x200);
+    // only the bytes which differ are written
+    CHECK(stores == 3);
+    CHECK(memory[10] == 1);
+    CHECK(memory[500] == 0);
+    CHECK(memory[999] == 0);
+    CHECK(stack.depth() == 2);
+    CHECK(stack.local(1) == 0xaaaa);
+    CHECK(stack.local(2) == 0);
+    CHECK(undo.size() == 1);
+    CHECK(undo.restore(1, memory, stack, store) == 0x100);
+    CHECK(memory == first_memory);
+    CHECK(stack.depth() == 1);
+    CHECK_THROWS_AS(stack.pop(), StackUnderflowException);
+    CHECK(undo.size() == 0);
+    CHECK(undo.used() == 0);
+}
+
+TEST_CASE("UndoRing forgets the oldest snapshots to stay within its budget") {
+    std::vector<Byte> memory(1000);
+    Stack stack(64);
+    UndoRing undo(2000);
+    for (std::size_t turn = 0; turn < 100; turn++) {
+        memory[turn] = 1;
+        undo.touch((Address)turn);
+        CHECK(undo.save(memory, stack, (Address)turn));
+        CHECK(undo.used() <= undo.budget());
+    }
+    // each turn costs far less than a full copy of memory
+    CHECK(undo.size() > 10);
+    CHECK(undo.size() < 100);
+    // the oldest snapshot remembered can still be restored in full
+    std::size_t oldest = 100 - undo.size();
+    CHECK(undo.restore(undo.size(), memory, stack, [&](Address address, Byte value) {
+        memory[address] = value;
+    }) == oldest);
+    for (std::size_t a = 0; a < 100; a++) {
+        CHECK(memory[a] == (a <= oldest ? 1 : 0));
+    }
+    // a budget too small for even one full copy disables undo
+    undo.set_budget(100);
+    CHECK_FALSE(undo.save(memory, stack, 0));
+    CHECK(undo.size() == 0);
+}
+
+TEST_CASE("UndoRing only compares the blocks of memory touched since the last save") {
+    UndoRing undo(64 * 1024);
+    std::vector<Byte> memory(1000);
+    Stack stack(64);
+    undo.save(memory, stack, 0x100);
+    memory[10] = 1;
+    undo.touch(10);
+    // a write which isn't reported goes unnoticed
+    memory[700] = 2;
+    undo.save(memory, stack, 0x200);
+    memory[20] = 3;
+    undo.touch(20);
+    std::vector<Address> stored;
+    CHECK(undo.restore(2, memory, stack, [&](Address address, Byte value) {
+        memory[address] = value;
+        stored.push_back(address);
+    }) == 0x100);
+    CHECK(stored == std::vector<Address>{20, 10});
+    CHECK(memory[10] == 0);
+    CHECK(memory[20] == 0);
+    CHECK(memory[700] == 2);
+}
+
+TEST_CASE("UndoRing remembers what differs from the snapshot it restores to") {
+    UndoRing undo(64 * 1024);
+    std::vector<Byte> memory(1000);
+    Stack stack(64);
+    undo.save(memory, stack, 0x100);
+    memory[300] = 1;
+    undo.touch(300);
+    undo.save(memory, stack, 0x200);
+    memory[300] = 2;
+    undo.touch(300);
+    undo.save(memory, stack, 0x300);
+    // back to the second snapshot, leaving the first as the newest
+    CHECK(undo.restore(1, memory, stack, [&](Address address, Byte value) {
+        memory[address] = value;
+    }) == 0x300);
+    CHECK(memory[300] == 2);
+    CHECK(undo.restore(1, memory, stack, [&](Address address, Byte value) {
+        memory[address] = value;
+    }) == 0x200);
+    CHECK(memory[300] == 1);
+    // nothing was written in between, yet the newest snapshot differs
+    CHECK(undo.restore(1, memory, stack, [&](Address address, Byte value) {
+        memory[address] = value;
+    }) == 0x100);
+    CHECK(memory[300] == 0);
+}
@@ -0,0 +1,794 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <catch2/catch.hpp>
+
+#include <zench/StoryImage.hpp>
+#include <zench/ZMachine.hpp>
+#include <zench/zench.hpp>
+
+#include "StringCache.hpp"
+#include "stubs.hpp"
+
+using namespace com::saxbophone::zench;
+using namespace com::saxbophone::zench::tests;
+
+namespace {
+    // executes until the machine quits, returning the number of instructions executed
+    std::size_t run_to_completion(ZMachine& vm, std::size_t limit) {
+        std::size_t count = 0;
+        while (vm.is_ready() and count < limit) {
+            vm.execute();
+            count++;
+        }
+        return count;
+    }
+}
+
+TEST_CASE("Cached instructions in high memory are re-executed correctly") {
+    auto dispatch = GENERATE(ZMachine::Dispatch::Switch, ZMachine::Dispatch::Threaded);
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xC5, 0x4F, 0x10, 0x03, 0xE8, 0xC5, // 0x100: inc_chk g00 #03e8 ?0x109
+        0x8C, 0xFF, 0xF9,                   // 0x106: jump 0x100
+        0xBA,                               // 0x109: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard, dispatch);
+    // 1000 iterations of inc_chk and jump, then the final inc_chk and quit
+    CHECK(run_to_completion(vm, 10000) == 2002);
+}
+
+TEST_CASE("Cached instructions in dynamic memory are invalidated when overwritten") {
+    auto story = blank_story(0x200, 0x080, 0x100);
+    Byte code[] = {
+        0xB4,                         // 0x80: nop
+        0xE2, 0x57, 0x00, 0x80, 0xBA, // 0x81: storeb #00 #80 #ba (overwrite the nop with quit)
+        0x8C, 0xFF, 0xF9,             // 0x86: jump 0x80
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x080);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    // nop, storeb, jump, then quit --a stale cache would loop forever
+    CHECK(run_to_completion(vm, 100) == 4);
+}
+
+TEST_CASE("ZMachine::run() stops when its budget is exhausted") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0x8C, 0xFF, 0xFF, // 0x100: jump 0x100
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run(1000) == ZMachine::Status::BudgetExhausted);
+    CHECK(vm.is_ready());
+}
+
+TEST_CASE("ZMachine::run_until_blocked() reports errors by status") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0x17, 0x01, 0x00, 0x00, // 0x100: div #01 #00 -> sp
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Error);
+    CHECK(vm.error() != nullptr);
+    CHECK_THROWS_AS(std::rethrow_exception(vm.error()), DivisionByZeroException);
+    CHECK_FALSE(vm.is_ready());
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+}
+
+TEST_CASE("Routines receive arguments in locals and return to their caller") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xE0, 0x1F, 0x00, 0x90, 0x05, 0x10, // 0x100: call 0x120 #05 -> g00
+        0x41, 0x10, 0x08, 0x43,             // 0x106: je g00 #08 ?! 0x10b
+        0xBA,                               // 0x10a: quit
+        0x17, 0x01, 0x00, 0x00,             // 0x10b: div #01 #00 -> sp
+    };
+    Byte routine[] = {
+        0x02, 0x00, 0x00, 0x00, 0x03, // 0x120: 2 locals, initially 0 and 3
+        0x74, 0x01, 0x02, 0x00,       // 0x125: add l00 l01 -> sp
+        0xB8,                         // 0x129: ret_popped
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    std::copy(std::begin(routine), std::end(routine), story.begin() + 0x120);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+}
+
+TEST_CASE("Unbounded recursion overflows the stack instead of exhausting memory") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xE0, 0x3F, 0x00, 0x90, 0x00, // 0x100: call 0x120 -> sp
+    };
+    Byte routine[] = {
+        0x00,                         // 0x120: no locals
+        0xE0, 0x3F, 0x00, 0x90, 0x00, // 0x121: call 0x120 -> sp
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    std::copy(std::begin(routine), std::end(routine), story.begin() + 0x120);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Error);
+    CHECK_THROWS_AS(std::rethrow_exception(vm.error()), StackOverflowException);
+}
+
+TEST_CASE("Reading beyond the end of memory is an error") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    SECTION("Calling a routine beyond the end of the story") {
+        Byte code[] = {
+            0xE0, 0x3F, 0x01, 0x00, 0x00, // 0x100: call 0x200 -> sp
+        };
+        std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    }
+    SECTION("An instruction cut off by the end of the story") {
+        story[0x1ff] = 0xE0; // 0x1ff: call, without its operands
+        story[0x06] = 0x01;
+        story[0x07] = 0xff;
+    }
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Error);
+    CHECK_THROWS_AS(std::rethrow_exception(vm.error()), Exception);
+}
+
+TEST_CASE("Z-code can't change the header, apart from Flags 2") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xE2, 0x57, 0x00, 0x00, 0x05,       // 0x100: storeb #00 #00 #05
+        0x10, 0x00, 0x00, 0x10,             // 0x105: loadb #00 #00 -> g00
+        0x41, 0x10, 0x03, 0xC6,             // 0x109: je g00 #03 ?0x111
+        0x17, 0x01, 0x00, 0x00,             // 0x10D: div #01 #00 -> sp
+        0xBA,                               // 0x111: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+}
+
+TEST_CASE("Stories whose header points beyond where its tables can be are invalid") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    SECTION("Global variables in static memory") {
+        story[0x0c] = 0x01;
+    }
+    SECTION("Object table in static memory") {
+        story[0x0a] = 0x01;
+    }
+    SECTION("Dictionary beyond the end of the story") {
+        story[0x08] = 0x02;
+    }
+    SECTION("Abbreviations running off the end of the story") {
+        story[0x18] = 0x01;
+        story[0x19] = 0x80;
+    }
+    SECTION("First instruction beyond the end of the story") {
+        story[0x06] = 0x02;
+    }
+    MemoryInputFile file(story);
+    CHECK_THROWS_AS(StoryImage::load(file), InvalidStoryFileException);
+}
+
+TEST_CASE("Stories of unsupported versions are rejected with their version") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    story[0x00] = 5;
+    MemoryInputFile file(story);
+    try {
+        StoryImage::load(file);
+        FAIL("no exception thrown");
+    } catch (const UnsupportedVersionException& e) {
+        CHECK(e.version() == 5);
+        CHECK(std::string(e.what()) == "Story file version 5 not supported");
+    }
+}
+
+TEST_CASE("ZMachines sharing a StoryImage each get their own dynamic memory") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0x10, 0x80, 0x00, 0x00,       // 0x100: loadb #80 #00 -> sp
+        0xA0, 0x00, 0xC6,             // 0x104: jz sp ? 0x10b
+        0x17, 0x01, 0x00, 0x00,       // 0x107: div #01 #00 -> sp
+        0xE2, 0x57, 0x80, 0x00, 0x55, // 0x10b: storeb #80 #00 #55
+        0xBA,                         // 0x110: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    auto image = StoryImage::load(file);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine first(image, fs, screen, keyboard);
+    ZMachine second(image, fs, screen, keyboard);
+    // each machine fails if it sees the other's write
+    CHECK(first.run_until_blocked() == ZMachine::Status::Quit);
+    CHECK(second.run_until_blocked() == ZMachine::Status::Quit);
+    CHECK(image->bytes()[0x80] == 0x00);
+}
+
+TEST_CASE("Code in dynamic memory can run on far into static memory") {
+    auto story = blank_story(0x400, 0xf0, 0x100);
+    story[0xf0] = 0xB2; // 0xF0: print, with a literal of 200 Words
+    for (std::size_t i = 0; i < 200; i++) {
+        story[0xf1 + 2 * i] = i == 199 ? 0x98 : 0x18; // "aaa"
+        story[0xf2 + 2 * i] = 0xC6;
+    }
+    story[0x281] = 0xBA; // 0x281: quit
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+    CHECK(screen.output == std::string(600, 'a'));
+}
+
+TEST_CASE("ZMachine::run_until_blocked() waits for input at READ and tokenises it") {
+    auto dispatch = GENERATE(ZMachine::Dispatch::Switch, ZMachine::Dispatch::Threaded);
+    auto story = blank_story(0x200, 0x100, 0x100);
+    story[0x08] = 0x01; // dictionary at 0x180
+    story[0x09] = 0x80;
+    story[0x80] = 20; // text buffer
+    story[0xa0] = 4; // parse buffer
+    Byte code[] = {
+        0xE4, 0x5F, 0x80, 0xA0,             // 0x100: sread #80 #a0
+        0x10, 0xA0, 0x01, 0x00,             // 0x104: loadb #a0 #01 -> sp
+        0x41, 0x00, 0x03, 0x4D,             // 0x108: je sp #03 ?! 0x117
+        0x0F, 0xA0, 0x01, 0x00,             // 0x10C: loadw #a0 #01 -> sp
+        0xC1, 0x8F, 0x00, 0x01, 0x8B, 0x43, // 0x110: je sp #018b ?! 0x117
+        0xBA,                               // 0x116: quit
+        0x17, 0x01, 0x00, 0x00,             // 0x117: div #01 #00 -> sp
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    Byte dictionary[] = {
+        0x01, ',', 0x06, 0x00, 0x02,        // 0x180: 1 separator, 2 entries of 6 bytes
+        0x32, 0x85, 0x94, 0xA5, 0x00, 0x00, // 0x185: "go"
+        0x4E, 0x97, 0xE5, 0xA5, 0x00, 0x00, // 0x18B: "north"
+    };
+    std::copy(std::begin(dictionary), std::end(dictionary), story.begin() + 0x180);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard, dispatch);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::WaitingForInput);
+    keyboard.type("North,");
+    CHECK(vm.run_until_blocked() == ZMachine::Status::WaitingForInput);
+    keyboard.type("go\n");
+    // three words: "north", "," and "go", with "north" found in the dictionary
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+}
+
+TEST_CASE("A dictionary in dynamic memory is looked up as it is after being modified") {
+    auto story = blank_story(0x200, 0x100, 0x1c0);
+    story[0x08] = 0x01; // dictionary at 0x180
+    story[0x09] = 0x80;
+    story[0x80] = 20; // text buffer
+    story[0xa0] = 4; // parse buffer
+    Byte code[] = {
+        0xE4, 0x5F, 0x80, 0xA0,             // 0x100: sread #80 #a0
+        0x0F, 0xA0, 0x01, 0x00,             // 0x104: loadw #a0 #01 -> sp
+        0xA0, 0x00, 0x57,                   // 0x108: jz sp ?! 0x120
+        0xE2, 0x17, 0x01, 0x85, 0x03, 0xA5, // 0x10B: storeb #0185 #03 #a5
+        0xE4, 0x5F, 0x80, 0xA0,             // 0x111: sread #80 #a0
+        0x0F, 0xA0, 0x01, 0x00,             // 0x115: loadw #a0 #01 -> sp
+        0xC1, 0x8F, 0x00, 0x01, 0x85, 0x43, // 0x119: je sp #0185 ?! 0x120
+        0xBA,                               // 0x11F: quit
+        0x17, 0x01, 0x00, 0x00,             // 0x120: div #01 #00 -> sp
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    Byte dictionary[] = {
+        0x01, ',', 0x06, 0x00, 0x01,        // 0x180: 1 separator, 1 entry of 6 bytes
+        0x4E, 0x97, 0xE5, 0xA6, 0x00, 0x00, // 0x185: not quite "north", until the storeb
+    };
+    std::copy(std::begin(dictionary), std::end(dictionary), story.begin() + 0x180);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::WaitingForInput);
+    keyboard.type("north\n");
+    CHECK(vm.run_until_blocked() == ZMachine::Status::WaitingForInput);
+    keyboard.type("north\n");
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+}
+
+TEST_CASE("Object opcodes see property lists as they are after being modified") {
+    auto dispatch = GENERATE(ZMachine::Dispatch::Switch, ZMachine::Dispatch::Threaded);
+    auto story = blank_story(0x400, 0x100, 0x300);
+    story[0x0a] = 0x02; // object table at 0x240
+    story[0x0b] = 0x40;
+    put_object_table(story, 0x240);
+    Byte code[] = {
+        0x11, 0x01, 0x12, 0x00,             // 0x100: get_prop #01 #12 -> sp
+        0xC1, 0x8F, 0x00, 0x12, 0x34, 0x00, 0x5A, // 0x104: je sp #1234 ?! 0x163
+        0x11, 0x01, 0x07, 0x00,             // 0x10B: get_prop #01 #07 -> sp --the default
+        0xC1, 0x8F, 0x00, 0x07, 0x07, 0x00, 0x4F, // 0x10F: je sp #0707 ?! 0x163
+        0x13, 0x01, 0x00, 0x00,             // 0x116: get_next_prop #01 #00 -> sp
+        0x41, 0x00, 0x12, 0x00, 0x46,       // 0x11A: je sp #12 ?! 0x163
+        0x13, 0x01, 0x12, 0x00,             // 0x11F: get_next_prop #01 #12 -> sp
+        0x41, 0x00, 0x05, 0x00, 0x3D,       // 0x123: je sp #05 ?! 0x163
+        0x12, 0x01, 0x05, 0x00,             // 0x128: get_prop_addr #01 #05 -> sp
+        0xA4, 0x00, 0x00,                   // 0x12C: get_prop_len sp -> sp
+        0x41, 0x00, 0x01, 0x00, 0x31,       // 0x12F: je sp #01 ?! 0x163
+        0x0A, 0x01, 0x1F, 0x00, 0x2C,       // 0x134: test_attr #01 #1f ?! 0x163
+        0x92, 0x01, 0x00, 0x00, 0x27,       // 0x139: get_child #01 -> sp ?! 0x163
+        0x41, 0x00, 0x02, 0x00, 0x22,       // 0x13E: je sp #02 ?! 0x163
+        0x93, 0x02, 0x00,                   // 0x143: get_parent #02 -> sp
+        0x41, 0x00, 0x01, 0x00, 0x1A,       // 0x146: je sp #01 ?! 0x163
+        0xE2, 0x17, 0x02, 0xA6, 0x00, 0x06, // 0x14B: storeb #02a6 #00 #06 --property 5 becomes 6
+        0x12, 0x01, 0x05, 0x00,             // 0x151: get_prop_addr #01 #05 -> sp
+        0xA0, 0x00, 0x00, 0x0C,             // 0x155: jz sp ?! 0x163
+        0x11, 0x01, 0x06, 0x00,             // 0x159: get_prop #01 #06 -> sp
+        0x41, 0x00, 0x56, 0x00, 0x03,       // 0x15D: je sp #56 ?! 0x163
+        0xBA,                               // 0x162: quit
+        0x17, 0x01, 0x00, 0x00,             // 0x163: div #01 #00 -> sp
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard, dispatch);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+}
+
+TEST_CASE("A game saved within a routine can be restored by another ZMachine") {
+    auto dispatch = GENERATE(ZMachine::Dispatch::Switch, ZMachine::Dispatch::Threaded);
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xB6, 0xD1,                         // 0x100: restore ?0x111
+        0xE2, 0x57, 0x80, 0x00, 0x11,       // 0x102: storeb #80 #00 #11
+        0xE0, 0x1F, 0x00, 0x90, 0x2A, 0x10, // 0x107: call 0x120 #2a -> g00
+        0x41, 0x10, 0x2B, 0xC6,             // 0x10D: je g00 #2b ?0x115
+        0x17, 0x01, 0x00, 0x00,             // 0x111: div #01 #00 -> sp
+        0xBA,                               // 0x115: quit
+    };
+    Byte routine[] = {
+        0x01, 0x00, 0x00,                   // 0x120: 1 local
+        0xE8, 0x7F, 0x07,                   // 0x123: push #07
+        0xB5, 0xC6,                         // 0x126: save ?0x12c
+        0x17, 0x01, 0x00, 0x00,             // 0x128: div #01 #00 -> sp
+        0x10, 0x80, 0x00, 0x00,             // 0x12C: loadb #80 #00 -> sp
+        0x41, 0x00, 0x11, 0x3F, 0xF5,       // 0x130: je sp #11 ?! 0x128
+        0x41, 0x00, 0x07, 0x3F, 0xF0,       // 0x135: je sp #07 ?! 0x128
+        0x54, 0x01, 0x01, 0x00,             // 0x13A: add l00 #01 -> sp
+        0xB8,                               // 0x13E: ret_popped
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    std::copy(std::begin(routine), std::end(routine), story.begin() + 0x120);
+    MemoryInputFile file(story);
+    auto image = StoryImage::load(file);
+    MemoryFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    // there's nothing to restore yet, so the first machine runs normally and saves
+    ZMachine first(image, fs, screen, keyboard, dispatch);
+    CHECK(run_to_completion(first, 100) == 12);
+    REQUIRE(fs.file);
+    // only the one changed byte of dynamic memory is stored
+    CHECK(fs.file->size() < 0x80);
+    // the second resumes in the routine, with the first's memory and stack
+    ZMachine second(image, fs, screen, keyboard, dispatch);
+    CHECK(run_to_completion(second, 100) == 8);
+}
+
+TEST_CASE("ZMachine::undo() rewinds to an earlier READ") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    story[0x08] = 0x01; // dictionary at 0x180
+    story[0x09] = 0x80;
+    story[0x80] = 20; // text buffer
+    story[0xa0] = 4; // parse buffer
+    story[0x181] = 0x06; // no separators or entries
+    Byte code[] = {
+        0x95, 0x10,                         // 0x100: inc g00
+        0x41, 0x10, 0x03, 0xC9,             // 0x102: je g00 #03 ?0x10d
+        0xE4, 0x5F, 0x80, 0xA0,             // 0x106: sread #80 #a0
+        0x8C, 0xFF, 0xF5,                   // 0x10A: jump 0x100
+        0xBA,                               // 0x10D: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::WaitingForInput);
+    CHECK(vm.undo_depth() == 0);
+    CHECK_FALSE(vm.undo());
+    keyboard.type("a\n");
+    CHECK(vm.run_until_blocked() == ZMachine::Status::WaitingForInput);
+    CHECK(vm.undo_depth() == 1);
+    // back to the first turn, so it takes two more turns to quit
+    CHECK(vm.undo());
+    CHECK(vm.undo_depth() == 0);
+    keyboard.type("b\n");
+    CHECK(vm.run_until_blocked() == ZMachine::Status::WaitingForInput);
+    keyboard.type("c\n");
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+    // the turn which ended the game can be undone too
+    CHECK_FALSE(vm.undo(3));
+    CHECK(vm.undo());
+    keyboard.type("d\n");
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+    vm.set_undo_budget(0);
+    CHECK(vm.undo_depth() == 0);
+}
+
+namespace {
+    // a coroutine which starts immediately and cleans up after itself
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+    };
+
+    Detached await_game_over(ZMachine::Task& task, std::optional<ZMachine::Status>& result) {
+        result = co_await task;
+    }
+}
+
+TEST_CASE("ZMachine::play() suspends at READ until resumed with input") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    story[0x08] = 0x01; // dictionary at 0x180
+    story[0x09] = 0x80;
+    story[0x80] = 20; // text buffer
+    story[0xa0] = 4; // parse buffer
+    story[0x181] = 0x06; // no separators or entries
+    Byte code[] = {
+        0x95, 0x10,                         // 0x100: inc g00
+        0x41, 0x10, 0x03, 0xC9,             // 0x102: je g00 #03 ?0x10d
+        0xE4, 0x5F, 0x80, 0xA0,             // 0x106: sread #80 #a0
+        0x8C, 0xFF, 0xF5,                   // 0x10A: jump 0x100
+        0xBA,                               // 0x10D: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    ZMachine::Task task = vm.play();
+    CHECK(task.status() == ZMachine::Status::WaitingForInput);
+    std::optional<ZMachine::Status> result;
+    await_game_over(task, result);
+    // resuming without input just suspends again
+    CHECK(task.resume() == ZMachine::Status::WaitingForInput);
+    keyboard.type("a\n");
+    CHECK(task.resume() == ZMachine::Status::WaitingForInput);
+    CHECK_FALSE(task.done());
+    CHECK_FALSE(result);
+    keyboard.type("b\n");
+    CHECK(task.resume() == ZMachine::Status::Quit);
+    CHECK(task.done());
+    // the awaiting coroutine has carried on
+    CHECK(result == ZMachine::Status::Quit);
+    CHECK(task.resume() == ZMachine::Status::Quit);
+}
+
+TEST_CASE("Print opcodes reach the Screen in one batch") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xB2, 0xB5, 0xC5,                   // 0x100: print "hi"
+        0xE6, 0x3F, 0xFF, 0xFB,             // 0x103: print_num #fffb
+        0xE5, 0x7F, 0x21,                   // 0x107: print_char #21
+        0xBB,                               // 0x10A: new_line
+        0x8D, 0x00, 0x90,                   // 0x10B: print_paddr #0090
+        0xBA,                               // 0x10E: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    story[0x120] = 0xB5; // "hi"
+    story[0x121] = 0xC5;
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+    CHECK(screen.output == "hi-5!\nhi");
+    CHECK(screen.batches == 1);
+}
+
+TEST_CASE("Strings in static and high memory are decoded once for every machine playing the story") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xB2, 0xB5, 0xC5,                   // 0x100: print "hi"
+        0x8D, 0x00, 0x90,                   // 0x103: print_paddr #0090
+        0x87, 0x00, 0x80,                   // 0x106: print_addr #0080 --in dynamic memory
+        0xBA,                               // 0x109: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    story[0x120] = 0x98; // "a"
+    story[0x121] = 0xA5;
+    story[0x80] = 0xA8; // "e"
+    story[0x81] = 0xA5;
+    MemoryInputFile file(story);
+    auto image = StoryImage::load(file);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine first(image, fs, screen, keyboard);
+    CHECK(first.run_until_blocked() == ZMachine::Status::Quit);
+    CHECK(image->strings().size() == 2);
+    ZMachine second(image, fs, screen, keyboard);
+    CHECK(second.run_until_blocked() == ZMachine::Status::Quit);
+    CHECK(image->strings().size() == 2);
+    CHECK(screen.output == "hiaehiae");
+}
+
+TEST_CASE("Output stream 2 writes a transcript of what's printed") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xF3, 0x7F, 0x02,                   // 0x100: output_stream #02
+        0xB2, 0xB5, 0xC5,                   // 0x103: print "hi"
+        0xBB,                               // 0x106: new_line
+        0xF3, 0x3F, 0xFF, 0xFE,             // 0x107: output_stream #fffe
+        0xB2, 0xB5, 0xC5,                   // 0x10B: print "hi"
+        0xBA,                               // 0x10E: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    MemoryFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+    CHECK(screen.output == "hi\nhi");
+    // written by the time quit returns
+    REQUIRE(fs.file);
+    CHECK(std::string(fs.file->begin(), fs.file->end()) == "hi\n");
+}
+
+TEST_CASE("The transcript is deselected if there's no file to write it to") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xF3, 0x7F, 0x02,                   // 0x100: output_stream #02
+        0xB2, 0xB5, 0xC5,                   // 0x103: print "hi"
+        0x10, 0x00, 0x11, 0x00,             // 0x106: loadb #00 #11 -> sp
+        0x41, 0x00, 0x00, 0xC6,             // 0x10A: je sp #00 ?0x112
+        0x17, 0x01, 0x00, 0x00,             // 0x10E: div #01 #00 -> sp
+        0xBA,                               // 0x112: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+    CHECK(screen.output == "hi");
+}
+
+TEST_CASE("Output stream 4 records the commands typed") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    story[0x08] = 0x01; // dictionary at 0x180, with no entries
+    story[0x09] = 0x80;
+    story[0x181] = 6;
+    story[0x80] = 20; // text buffer
+    story[0xa0] = 4; // parse buffer
+    Byte code[] = {
+        0xF3, 0x7F, 0x04,                   // 0x100: output_stream #04
+        0xE4, 0x5F, 0x80, 0xA0,             // 0x103: sread #80 #a0
+        0xE4, 0x5F, 0x80, 0xA0,             // 0x107: sread #80 #a0
+        0xBA,                               // 0x10B: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    MemoryFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    keyboard.type("Open Mailbox\nread leaflet\n");
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+    REQUIRE(fs.file);
+    CHECK(std::string(fs.file->begin(), fs.file->end()) == "open mailbox\nread leaflet\n");
+}
+
+TEST_CASE("Commands are recorded in UTF-8, as far as they fit in the text buffer") {
+    auto story = blank_story(0x200, 0x100, 0x100);
+    story[0x08] = 0x01; // dictionary at 0x180, with no entries
+    story[0x09] = 0x80;
+    story[0x181] = 6;
+    story[0x80] = 5; // text buffer with room for 4 characters
+    story[0xa0] = 4; // parse buffer
+    Byte code[] = {
+        0xF3, 0x7F, 0x04,                   // 0x100: output_stream #04
+        0xE4, 0x5F, 0x80, 0xA0,             // 0x103: sread #80 #a0
+        0xBA,                               // 0x107: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    MemoryFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard);
+    keyboard.type("k");
+    keyboard.type(0x00E4); // a with diaeresis, ZSCII 155
+    keyboard.type("se sandwich\n");
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+    REQUIRE(fs.file);
+    CHECK(std::string(fs.file->begin(), fs.file->end()) == "k\xC3\xA4se\n");
+}
+
+TEST_CASE("ZMachine::stats() counts each opcode executed, if built in") {
+    auto dispatch = GENERATE(ZMachine::Dispatch::Switch, ZMachine::Dispatch::Threaded);
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0x54, 0x10, 0x01, 0x10,             // 0x100: add g00 #01 -> g00
+        0x41, 0x10, 0x64, 0x3F, 0xF9,       // 0x104: je g00 #64 ?! 0x100
+        0xBA,                               // 0x109: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard, dispatch);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+    ZMachine::Stats stats = vm.stats();
+    if (not stats.enabled) {
+        CHECK(stats.instructions == 0);
+        CHECK(stats.opcodes.empty());
+        return;
+    }
+    CHECK(stats.instructions == 201);
+    auto count = [&](std::string_view name) {
+        auto found = std::find_if(
+            stats.opcodes.begin(), stats.opcodes.end(),
+            [&](const ZMachine::OpcodeStats& opcode) { return opcode.name == name; }
+        );
+        REQUIRE(found != stats.opcodes.end());
+        // every timed execution is in one bucket of the histogram
+        std::uint64_t histogram = 0;
+        for (std::uint64_t bucket : found->histogram) {
+            histogram += bucket;
+        }
+        CHECK(histogram == found->sampled);
+        return found->count;
+    };
+    CHECK(count("add") == 100);
+    CHECK(count("je") == 100);
+    CHECK(count("quit") == 1);
+    CHECK(count("print") == 0);
+    std::uint64_t sampled = 0;
+    for (const auto& opcode : stats.opcodes) {
+        sampled += opcode.sampled;
+    }
+    CHECK(sampled == 201 / 64);
+    vm.reset_stats();
+    CHECK(vm.stats().instructions == 0);
+}
+
+TEST_CASE("ZMachine::instructions() counts every instruction executed, however it's run") {
+    auto dispatch = GENERATE(ZMachine::Dispatch::Switch, ZMachine::Dispatch::Threaded);
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0x54, 0x10, 0x01, 0x10,             // 0x100: add g00 #01 -> g00
+        0x41, 0x10, 0x64, 0x3F, 0xF9,       // 0x104: je g00 #64 ?! 0x100
+        0xBA,                               // 0x109: quit
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard, dispatch);
+    CHECK(vm.instructions() == 0);
+    vm.execute();
+    vm.execute();
+    vm.execute();
+    CHECK(vm.instructions() == 3);
+    CHECK(vm.run(10) == ZMachine::Status::BudgetExhausted);
+    CHECK(vm.instructions() == 13);
+    CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+    CHECK(vm.instructions() == 201);
+}
+
+TEST_CASE("ZMachine::instructions() counts the instructions executed before an error") {
+    auto dispatch = GENERATE(ZMachine::Dispatch::Switch, ZMachine::Dispatch::Threaded);
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0x54, 0x10, 0x01, 0x10,             // 0x100: add g00 #01 -> g00
+        0x41, 0x10, 0x64, 0x3F, 0xF9,       // 0x104: je g00 #64 ?! 0x100
+        0x17, 0x01, 0x00, 0x00,             // 0x109: div #01 #00 -> sp
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    MemoryInputFile file(story);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    ZMachine vm(file, fs, screen, keyboard, dispatch);
+    CHECK(vm.run(1000) == ZMachine::Status::Error);
+    // the division which failed isn't counted
+    CHECK(vm.instructions() == 200);
+}
+
+TEST_CASE("Profiling samples the routines on the call stack every so many instructions") {
+    auto dispatch = GENERATE(ZMachine::Dispatch::Switch, ZMachine::Dispatch::Threaded);
+    auto story = blank_story(0x200, 0x100, 0x100);
+    Byte code[] = {
+        0xE0, 0x3F, 0x00, 0x90, 0x00,       // 0x100: call 0x120 -> sp
+        0x54, 0x10, 0x01, 0x10,             // 0x105: add g00 #01 -> g00
+        0x41, 0x10, 0x0A, 0x3F, 0xF4,       // 0x109: je g00 #0a ?! 0x100
+        0xBA,                               // 0x10E: quit
+    };
+    Byte routines[] = {
+        0x00,                               // 0x120: no locals
+        0xE0, 0x3F, 0x00, 0x98, 0x00,       // 0x121: call 0x130 -> sp
+        0xB8,                               // 0x126: ret_popped
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00,                               // 0x130: no locals
+        0xB0,                               // 0x131: rtrue
+    };
+    std::copy(std::begin(code), std::end(code), story.begin() + 0x100);
+    std::copy(std::begin(routines), std::end(routines), story.begin() + 0x120);
+    MemoryInputFile file(story);
+    auto image = StoryImage::load(file);
+    StubFileSystem fs;
+    StubScreen screen;
+    StubKeyboard keyboard;
+    SECTION("Every instruction") {
+        ZMachine vm(image, fs, screen, keyboard, dispatch);
+        CHECK(vm.profile().empty());
+        vm.set_profiling_interval(1);
+        CHECK(vm.run_until_blocked() == ZMachine::Status::Quit);
+        CHECK(vm.profile() == "main 31\nmain;0x120 20\nmain;0x120;0x130 10\n");
+        vm.set_profiling_interval(0);
+        CHECK(vm.profile().empty());
+    }
+    SECTION("Every 7 instructions, however run() is called") {
+        ZMachine vm(image, fs, screen, keyboard, dispatch);
+        vm.set_profiling_interval(7);
+        std::size_t budget = GENERATE(std::size_t{3}, std::size_t{100});
+        while (vm.run(budget) == ZMachine::Status::BudgetExhausted) {}
+        // 61 instructions are executed in all
+        std::string profile = vm.profile();
+        std::size_t samples = 0;
+        for (std::size_t end = profile.find('\n'); end != std::string::npos; end = profile.find('\n', end + 1)) {
+            std::size_t count = profile.rfind(' ', end) + 1;
+            samples += std::stoul(profile.substr(count, end - count));
+        }
+        CHECK(samples == 8);
+    }
+}
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <zench/zench.hpp>
+
+#include "ZStringDecoder.hpp"
+
+using namespace com::saxbophone::zench;
+
+namespace {
+    // packs Z-chars three to a Word, padding with 5s and ending the string on the last
+    std::vector<Byte> encode(std::initializer_list<Byte> z_chars) {
+        std::vector<Byte> pending(z_chars);
+        while (pending.size() % 3 != 0) {
+            pending.push_back(5);
+        }
+        std::vector<Byte> z_string;
+        for (std::size_t i = 0; i < pending.size(); i += 3) {
+            Word word = (Word)(pending[i] << 10 | pending[i + 1] << 5 | pending[i + 2]);
+            if (i + 3 == pending.size()) {
+                word |= 0x8000;
+            }
+            z_string.push_back((Byte)(word >> 8));
+            z_string.push_back((Byte)word);
+        }
+        return z_string;
+    }
+}
+
+TEST_CASE("Z-strings are decoded from the default alphabets of V3") {
+    ZStringDecoder decoder(ZVersion::V3);
+    // "Hello, world!\n"
+    auto z_string = encode({4, 13, 10, 17, 17, 20, 5, 19, 0, 28, 20, 23, 17, 9, 5, 20, 5, 7});
+    CHECK(decoder.decode(z_string) == "Hello, world!\n");
+}
+
+TEST_CASE("Decoding stops at the Word with its top bit set") {
+    ZStringDecoder decoder(ZVersion::V3);
+    auto z_string = encode({6, 7, 8});
+    z_string.push_back(0x00); // a Word which isn't part of the string
+    z_string.push_back(0x00);
+    CHECK(decoder.decode(z_string) == "abc");
+}
+
+TEST_CASE("Decoding into a buffer writes only as much as fits") {
+    ZStringDecoder decoder(ZVersion::V3);
+    auto z_string = encode({6, 7, 8, 9, 10, 11});
+    std::array<char, 4> buffer = {'.', '.', '.', '.'};
+    CHECK(decoder.decode(z_string, std::span<char>(buffer).first(3)) == 6);
+    CHECK(std::string(buffer.begin(), buffer.end()) == "abc.");
+    std::array<char, 6> bigger;
+    CHECK(decoder.decode(z_string, bigger) == 6);
+    CHECK(std::string(bigger.begin(), bigger.end()) == "abcdef");
+}
+
+TEST_CASE("Without memory, abbreviations are decoded to placeholders") {
+    ZStringDecoder decoder(ZVersion::V3);
+    // abbreviation 32 * (2 - 1) + 3, then the escape for ZSCII 65
+    auto z_string = encode({2, 3, 5, 6, 2, 1});
+    CHECK(decoder.decode(z_string) == "@{35}A");
+}
+
+TEST_CASE("ZSCII escapes are decoded as print_char prints them") {
+    ZStringDecoder decoder(ZVersion::V3);
+    // ZSCII 126 '~', 32 ' ', 13 newline, 155, the first extra character, then 252, which is undefined
+    auto z_string = encode({5, 6, 3, 30, 5, 6, 1, 0, 5, 6, 0, 13, 5, 6, 4, 27, 5, 6, 7, 28});
+    CHECK(decoder.decode(z_string) == "~ \n\xc3\xa4?");
+}
+
+TEST_CASE("Extra characters are translated to and from Unicode") {
+    SECTION("With the default Unicode translation table") {
+        ZStringDecoder decoder(ZVersion::V3);
+        CHECK(decoder.zscii_to_utf8(155) == "\xc3\xa4"); // a with diaeresis
+        CHECK(decoder.zscii_to_utf8(220) == "\xc5\x93"); // oe ligature
+        CHECK(decoder.zscii_to_utf8(224) == "?"); // beyond the table
+        // typed text is lower-cased
+        CHECK(decoder.zscii_from_unicode('Q') == 'q');
+        CHECK(decoder.zscii_from_unicode(0x00e4) == 155);
+        CHECK(decoder.zscii_from_unicode(0x00c4) == 155);
+        CHECK(decoder.zscii_from_unicode(0x20ac) == 0); // the euro sign isn't in the table
+    }
+    SECTION("With a story's own table") {
+        std::vector<char16_t> table = {0x20ac, 0x0041};
+        ZStringDecoder decoder(ZVersion::V5, {}, std::nullopt, table);
+        CHECK(decoder.zscii_to_utf8(155) == "\xe2\x82\xac");
+        CHECK(decoder.zscii_to_utf8(156) == "A");
+        CHECK(decoder.zscii_to_utf8(157) == "?");
+        CHECK(decoder.zscii_from_unicode(0x20ac) == 155);
+    }
+}
+
+TEST_CASE("V1 has its own A2 and shifts which lock") {
+    ZStringDecoder decoder(ZVersion::V1);
+    // newline, '<' from A2, then shift-lock to A1 for "AB", and back to A0 for "c"
+    auto z_string = encode({1, 3, 27, 4, 6, 7, 5, 8});
+    CHECK(decoder.decode(z_string) == "\n<ABc");
+}
+
+TEST_CASE("A custom alphabet table replaces the default one") {
+    std::array<Byte, 78> table;
+    for (std::size_t i = 0; i < table.size(); i++) {
+        table[i] = (Byte)('0' + i % 26);
+    }
+    ZStringDecoder decoder(ZVersion::V5, {}, std::span<const Byte, 78>(table));
+    // Z-char 7 of A2 stays a newline
+    auto z_string = encode({6, 4, 7, 5, 7, 5, 8});
+    CHECK(decoder.decode(z_string) == "01\n2");
+}
+
+TEST_CASE("Unpacking many Words at once gives the same Z-chars as one at a time") {
+    // long enough for several blocks, with a terminator at each position in turn
+    std::vector<Byte> z_string(2 * 40);
+    for (std::size_t i = 0; i < z_string.size(); i++) {
+        z_string[i] = (Byte)((i * 37 + 11) & 0x7f);
+    }
+    for (std::size_t end = 0; end <= 40; end++) {
+        std::vector<Byte> terminated = z_string;
+        if (end < 40) {
+            terminated[2 * end] |= 0x80;
+        }
+        std::vector<Byte> fast(40 * ZStringDecoder::UNPACKED_WORD_SIZE);
+        std::vector<Byte> slow(40 * ZStringDecoder::UNPACKED_WORD_SIZE);
+        std::size_t words = ZStringDecoder::unpack(terminated, fast);
+        CHECK(words == (end < 40 ? end + 1 : 40));
+        CHECK(ZStringDecoder::unpack_word_by_word(terminated, slow) == words);
+        fast.resize(words * ZStringDecoder::UNPACKED_WORD_SIZE);
+        slow.resize(words * ZStringDecoder::UNPACKED_WORD_SIZE);
+        CHECK(fast == slow);
+    }
+    // unpacking stops when the output is full
+    std::vector<Byte> short_output(3 * ZStringDecoder::UNPACKED_WORD_SIZE);
+    CHECK(ZStringDecoder::unpack(z_string, short_output) == 3);
+}
+
+TEST_CASE("Abbreviations are expanded from the story's abbreviations table") {
+    std::vector<Byte> memory(0x400);
+    memory[0x18] = 0x01; // abbreviations table at 0x100
+    memory[0x19] = 0x00;
+    auto put = [&](std::size_t address, const std::vector<Byte>& bytes) {
+        std::copy(bytes.begin(), bytes.end(), memory.begin() + (std::ptrdiff_t)address);
+    };
+    // every abbreviation is "the", except for number 35 which is "House"
+    for (std::size_t a = 0; a < ZStringDecoder::ABBREVIATIONS; a++) {
+        put(0x100 + 2 * a, {0x01, 0x00}); // word address of 0x200
+    }
+    put(0x100 + 2 * 35, {0x01, 0x10}); // word address of 0x220
+    put(0x200, encode({25, 13, 10}));
+    // abbreviations can't themselves contain abbreviations
+    put(0x220, encode({4, 13, 20, 26, 1, 0, 24, 10}));
+    ZStringDecoder decoder(ZVersion::V3, memory);
+    auto z_string = encode({1, 0, 0, 2, 3, 0, 3, 31});
+    CHECK(decoder.decode(z_string) == "the House the");
+    // the text is copied straight into a buffer too short for it, as far as it goes
+    std::array<char, 6> buffer;
+    CHECK(decoder.decode(z_string, buffer) == 13);
+    CHECK(std::string(buffer.begin(), buffer.end()) == "the Ho");
+}
+
+TEST_CASE("An abbreviation which runs off the end of memory is an error") {
+    std::vector<Byte> memory(0x200);
+    memory[0x18] = 0x01; // abbreviations table at 0x100, whose entries are all 0x1fe
+    for (std::size_t a = 0; a < ZStringDecoder::ABBREVIATIONS; a++) {
+        memory[0x100 + 2 * a] = 0x00;
+        memory[0x101 + 2 * a] = 0xff;
+    }
+    CHECK_THROWS_AS(ZStringDecoder(ZVersion::V3, memory), Exception);
+}
@@ -0,0 +1,226 @@
+/*
+ * Minimal implementations of Zench's component interfaces, for constructing
+ * ZMachine instances from in-memory story images within the unit tests.
+ */
+
+#ifndef COM_SAXBOPHONE_ZENCH_TESTS_STUBS_HPP
+#define COM_SAXBOPHONE_ZENCH_TESTS_STUBS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <zench/FileSystem.hpp>
+#include <zench/Keyboard.hpp>
+#include <zench/Screen.hpp>
+#include <zench/zench.hpp>
+
+namespace com::saxbophone::zench::tests {
+    // reads a story image held in memory
+    class MemoryInputFile : public FileSystem::InputFile {
+    public:
+        MemoryInputFile(std::vector<Byte> data) : _data(std::move(data)) {}
+        constexpr const char* name() override {
+            return "MemoryInputFile";
+        }
+        bool is_open() override {
+            return _open;
+        }
+        void close() override {
+            _open = false;
+        }
+        bool open() override {
+            return false;
+        }
+        char read() override {
+            return _cursor < _data.size() ? (char)_data[_cursor++] : '\0';
+        }
+        std::size_t read_into(std::span<Byte> buffer) override {
+            std::size_t count = std::min(buffer.size(), _data.size() - _cursor);
+            std::copy_n(_data.begin() + (std::ptrdiff_t)_cursor, count, buffer.begin());
+            _cursor += count;
+            return count;
+        }
+        std::optional<std::size_t> size() override {
+            return _data.size();
+        }
+        std::span<const Byte> contents() override {
+            return _data;
+        }
+    private:
+        std::vector<Byte> _data;
+        std::size_t _cursor = 0;
+        bool _open = true;
+    };
+
+    // appends everything written to it to a vector held elsewhere
+    class MemoryOutputFile : public FileSystem::OutputFile {
+    public:
+        MemoryOutputFile(std::vector<Byte>& data) : _data(data) {}
+        constexpr const char* name() override {
+            return "MemoryOutputFile";
+        }
+        bool is_open() override {
+            return _open;
+        }
+        void close() override {
+            _open = false;
+        }
+        bool open() override {
+            return _open = true;
+        }
+        bool write(std::span<const Byte> bytes) override {
+            _data.insert(_data.end(), bytes.begin(), bytes.end());
+            return true;
+        }
+    private:
+        std::vector<Byte>& _data;
+        bool _open = true;
+    };
+
+    // holds a single file in memory, which is replaced by open_for_write() and read by open_for_read()
+    class MemoryFileSystem : public FileSystem {
+    public:
+        constexpr const char* name() override {
+            return "MemoryFileSystem";
+        }
+        std::unique_ptr<InputFile> open_for_read() override {
+            if (not file) {
+                return {};
+            }
+            return std::make_unique<MemoryInputFile>(*file);
+        }
+        std::unique_ptr<InputFile> open_for_read(std::string) override {
+            return this->open_for_read();
+        }
+        std::unique_ptr<OutputFile> open_for_write() override {
+            return std::make_unique<MemoryOutputFile>(file.emplace());
+        }
+        std::unique_ptr<OutputFile> open_for_write(std::string) override {
+            return this->open_for_write();
+        }
+
+        std::optional<std::vector<Byte>> file;
+    };
+
+    class StubFileSystem : public FileSystem {
+    public:
+        constexpr const char* name() override {
+            return "StubFileSystem";
+        }
+        std::unique_ptr<InputFile> open_for_read() override { return {}; }
+        std::unique_ptr<InputFile> open_for_read(std::string) override { return {}; }
+        std::unique_ptr<OutputFile> open_for_write() override { return {}; }
+        std::unique_ptr<OutputFile> open_for_write(std::string) override { return {}; }
+    };
+
+    class StubScreen : public Screen {
+    public:
+        constexpr const char* name() override {
+            return "StubScreen";
+        }
+        std::pair<std::uint8_t, std::uint8_t> get_dimensions() override { return {80, 25}; }
+        bool supports_colour() override { return false; }
+        bool supports_truecolour() override { return false; }
+        void render(std::span<const Command> commands, std::string_view text) override {
+            batches++;
+            for (const auto& command : commands) {
+                if (command.type == Command::Type::Print) {
+                    output += text.substr(command.offset, command.length);
+                } else if (command.type == Command::Type::NewLine) {
+                    output += '\n';
+                }
+            }
+        }
+
+        // the text printed so far, with a newline for each NewLine
+        std::string output;
+        // number of times render() has been called
+        std::size_t batches = 0;
+    };
+
+    // only produces the input typed into it with type()
+    class StubKeyboard : public Keyboard {
+    public:
+        constexpr const char* name() override {
+            return "StubKeyboard";
+        }
+        constexpr bool supports_mouse() override { return false; }
+        constexpr bool supports_menus() override { return false; }
+        std::vector<Event> get_input() override {
+            return std::exchange(_input, {});
+        }
+        void type(const std::string& text) {
+            for (char c : text) {
+                _input.push_back((std::uint16_t)c);
+            }
+        }
+        void type(std::uint16_t codepoint) {
+            _input.push_back(codepoint);
+        }
+    private:
+        std::vector<Event> _input;
+    };
+
+    /*
+     * Produces a blank Version 3 story image of the given size, with a header
+     * describing the given memory map. The caller fills in the code.
+     */
+    inline std::vector<Byte> blank_story(
+        std::size_t size,
+        Word initial_pc,
+        Word static_memory_begin,
+        Word globals_address = 0x0040
+    ) {
+        std::vector<Byte> story(size);
+        auto set_word = [&](std::size_t address, Word value) {
+            story[address] = (Byte)(value >> 8);
+            story[address + 1] = (Byte)value;
+        };
+        story[0x00] = 3; // version
+        set_word(0x04, static_memory_begin); // high memory base
+        set_word(0x06, initial_pc);
+        set_word(0x0c, globals_address);
+        set_word(0x0e, static_memory_begin);
+        set_word(0x1a, (Word)(size / 2)); // file length
+        return story;
+    }
+
+    // two objects, 2 being the child of 1, with their property tables at 0x2a0 and 0x2c0
+    inline void put_object_table(std::vector<Byte>& memory, std::size_t table) {
+        for (Byte property = 1; property <= 31; property++) {
+            memory[table + 2u * (property - 1u)] = property; // each default is the property number, twice
+            memory[table + 2u * (property - 1u) + 1] = property;
+        }
+        Byte objects[] = {
+            0x80, 0x00, 0x00, 0x01, 0x00, 0x00, 0x02, 0x02, 0xA0, // 1: attributes 0 and 31, child 2
+            0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x02, 0xC0, // 2: parent 1
+        };
+        std::copy(std::begin(objects), std::end(objects), memory.begin() + (std::ptrdiff_t)table + 62);
+        Byte first[] = {
+            0x01, 0x94, 0xA5,                   // 0x2A0: short name of one Word
+            0x32, 0x12, 0x34,                   // 0x2A3: property 18, 2 bytes
+            0x05, 0x56,                         // 0x2A6: property 5, 1 byte
+            0x63, 0xAA, 0xBB, 0xCC, 0xDD,       // 0x2A8: property 3, 4 bytes
+            0x00,                               // 0x2AD: end of properties
+        };
+        std::copy(std::begin(first), std::end(first), memory.begin() + 0x2a0);
+        Byte second[] = {
+            0x00,                               // 0x2C0: no short name
+            0x27, 0xBE, 0xEF,                   // 0x2C1: property 7, 2 bytes
+            0x00,                               // 0x2C4: end of properties
+        };
+        std::copy(std::begin(second), std::end(second), memory.begin() + 0x2c0);
+    }
+}
+
+#endif // include guard